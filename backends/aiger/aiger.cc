@@ -0,0 +1,432 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+// [[CITE]] The AIGER And-Inverter Graph (AIG) Format Version 20071012
+// Armin Biere, FMV Reports Series, Institute for Formal Models and Verification, Johannes Kepler University, 2007
+// http://fmv.jku.at/papers/Biere-FMV-TR-07-1.pdf
+
+#include "kernel/register.h"
+#include "kernel/sigtools.h"
+#include "kernel/celltypes.h"
+#include "kernel/log.h"
+#include <string>
+#include <stdio.h>
+
+struct AigerWriter
+{
+	struct latch_t {
+		RTLIL::SigBit q, d;
+		std::string name;
+		int init;
+	};
+
+	RTLIL::Module *module;
+	SigMap sigmap;
+
+	std::map<RTLIL::SigBit, RTLIL::Cell*> drivers;
+	std::map<RTLIL::SigBit, int> bit_lits;
+	std::set<RTLIL::SigBit> in_progress;
+
+	std::vector<std::string> input_names;
+	std::vector<latch_t> latches;
+	std::vector<int> latch_next_lits;
+	std::vector<int> output_lits;
+	std::vector<std::string> output_names;
+
+	std::vector<std::pair<int, int>> and_gates;
+	std::map<std::pair<int, int>, int> and_cache;
+	int num_vars;
+
+	RTLIL::SigSpec clock_sig;
+	bool clock_pol;
+
+	AigerWriter(RTLIL::Module *module) : module(module), sigmap(module), num_vars(0), clock_pol(true) { }
+
+	static std::string bit_name(RTLIL::SigBit bit)
+	{
+		std::string str = RTLIL::unescape_id(bit.wire->name);
+		for (size_t i = 0; i < str.size(); i++)
+			if (str[i] == ' ' || str[i] == '\n')
+				str[i] = '_';
+		if (bit.wire->width != 1)
+			str += stringf("[%d]", bit.offset);
+		return str;
+	}
+
+	RTLIL::SigBit port_bit(RTLIL::Cell *cell, std::string port, int offset = 0)
+	{
+		return sigmap(cell->connections.at(port).extract(offset, 1));
+	}
+
+	void add_clock(RTLIL::Cell *cell, RTLIL::SigSpec sig, bool polarity)
+	{
+		sig = sigmap(sig);
+		if (clock_sig.width == 0) {
+			clock_sig = sig;
+			clock_pol = polarity;
+		} else if (clock_sig != sig || clock_pol != polarity)
+			log_error("Flip-flop %s.%s uses a different clock than the other flip-flops. AIGER only supports a single global clock.\n",
+					RTLIL::id2cstr(module->name), RTLIL::id2cstr(cell->name));
+	}
+
+	void add_input(RTLIL::SigBit bit, std::string name)
+	{
+		if (bit.wire == NULL || bit_lits.count(bit) || drivers.count(bit))
+			return;
+		bit_lits[bit] = 2 * (++num_vars);
+		input_names.push_back(name);
+	}
+
+	int mkand(int a, int b)
+	{
+		if (a == 0 || b == 0 || (a ^ b) == 1)
+			return 0;
+		if (a == 1 || a == b)
+			return b;
+		if (b == 1)
+			return a;
+		if (a < b)
+			std::swap(a, b);
+		std::pair<int, int> key(a, b);
+		if (and_cache.count(key) == 0) {
+			and_gates.push_back(key);
+			and_cache[key] = 2 * (++num_vars);
+		}
+		return and_cache.at(key);
+	}
+
+	int mkor(int a, int b) {
+		return mkand(a ^ 1, b ^ 1) ^ 1;
+	}
+
+	int mkxor(int a, int b) {
+		return mkor(mkand(a, b ^ 1), mkand(a ^ 1, b));
+	}
+
+	int mkmux(int a, int b, int s) {
+		return mkor(mkand(s ^ 1, a), mkand(s, b));
+	}
+
+	int bit2lit(RTLIL::SigBit bit)
+	{
+		if (bit.wire == NULL)
+			return bit.data == RTLIL::State::S1 ? 1 : 0;
+
+		if (bit_lits.count(bit))
+			return bit_lits.at(bit);
+
+		if (in_progress.count(bit))
+			log_error("Found logic loop at signal %s in module %s.\n", bit_name(bit).c_str(), RTLIL::id2cstr(module->name));
+		in_progress.insert(bit);
+
+		RTLIL::Cell *cell = drivers.at(bit);
+		int lit = 0;
+
+		if (cell->type == "$_INV_")
+			lit = bit2lit(port_bit(cell, "\\A")) ^ 1;
+		else if (cell->type == "$_AND_")
+			lit = mkand(bit2lit(port_bit(cell, "\\A")), bit2lit(port_bit(cell, "\\B")));
+		else if (cell->type == "$_OR_")
+			lit = mkor(bit2lit(port_bit(cell, "\\A")), bit2lit(port_bit(cell, "\\B")));
+		else if (cell->type == "$_XOR_")
+			lit = mkxor(bit2lit(port_bit(cell, "\\A")), bit2lit(port_bit(cell, "\\B")));
+		else if (cell->type == "$_MUX_")
+			lit = mkmux(bit2lit(port_bit(cell, "\\A")), bit2lit(port_bit(cell, "\\B")), bit2lit(port_bit(cell, "\\S")));
+		else
+			log_abort();
+
+		in_progress.erase(bit);
+		bit_lits[bit] = lit;
+		return lit;
+	}
+
+	void setup()
+	{
+		std::map<int, RTLIL::Wire*> inputs, outputs;
+		std::vector<RTLIL::Cell*> gate_cells, ff_cells;
+
+		for (auto &it : module->wires) {
+			RTLIL::Wire *wire = it.second;
+			if (wire->port_input)
+				inputs[wire->port_id] = wire;
+			if (wire->port_output)
+				outputs[wire->port_id] = wire;
+		}
+
+		for (auto &it : module->cells)
+		{
+			RTLIL::Cell *cell = it.second;
+
+			if (cell->type == "$_INV_" || cell->type == "$_AND_" || cell->type == "$_OR_" || cell->type == "$_XOR_" || cell->type == "$_MUX_") {
+				RTLIL::SigBit bit = port_bit(cell, "\\Y");
+				if (bit.wire == NULL)
+					continue;
+				if (drivers.count(bit))
+					log_error("Signal %s in module %s has multiple drivers.\n", bit_name(bit).c_str(), RTLIL::id2cstr(module->name));
+				drivers[bit] = cell;
+				gate_cells.push_back(cell);
+				continue;
+			}
+
+			if (cell->type == "$_DFF_N_" || cell->type == "$_DFF_P_") {
+				add_clock(cell, cell->connections.at("\\C"), cell->type == "$_DFF_P_");
+				ff_cells.push_back(cell);
+				continue;
+			}
+
+			if (cell->type == "$dff") {
+				add_clock(cell, cell->connections.at("\\CLK"), cell->parameters.at("\\CLK_POLARITY").as_bool());
+				ff_cells.push_back(cell);
+				continue;
+			}
+
+			log_error("Unsupported cell type %s (%s) in module %s. Only internal gates and $dff cells are supported.\n",
+					RTLIL::id2cstr(cell->type), RTLIL::id2cstr(cell->name), RTLIL::id2cstr(module->name));
+		}
+
+		// the clock is implicit in AIGER, so it is only exported as input if it is also used as data signal
+
+		std::set<RTLIL::SigBit> clock_bits, ff_bits;
+		for (auto bit : clock_sig.to_sigbit_vector())
+			clock_bits.insert(bit);
+
+		for (auto &it : inputs)
+		for (int i = 0; i < it.second->width; i++) {
+			RTLIL::SigBit bit(it.second, i), mapped_bit = sigmap(RTLIL::SigSpec(bit));
+			if (!clock_bits.count(mapped_bit))
+				add_input(mapped_bit, bit_name(bit));
+		}
+
+		for (auto cell : ff_cells)
+		for (auto bit : sigmap(cell->connections.at("\\Q")).to_sigbit_vector()) {
+			if (bit.wire == NULL || bit_lits.count(bit) || drivers.count(bit) || ff_bits.count(bit))
+				log_error("Output of flip-flop %s.%s is constant, a primary input or has multiple drivers.\n",
+						RTLIL::id2cstr(module->name), RTLIL::id2cstr(cell->name));
+			ff_bits.insert(bit);
+		}
+
+		std::vector<RTLIL::SigBit> used_bits;
+		for (auto cell : gate_cells)
+			for (auto &conn : cell->connections)
+				if (conn.first != "\\Y")
+					used_bits.push_back(sigmap(conn.second));
+		for (auto cell : ff_cells)
+			for (auto bit : sigmap(cell->connections.at("\\D")).to_sigbit_vector())
+				used_bits.push_back(bit);
+		for (auto &it : outputs)
+			for (auto bit : sigmap(RTLIL::SigSpec(it.second)).to_sigbit_vector())
+				used_bits.push_back(bit);
+
+		for (auto bit : used_bits)
+			if (bit.wire != NULL && !bit_lits.count(bit) && !drivers.count(bit) && !ff_bits.count(bit)) {
+				log("Treating undriven signal %s as primary input.\n", bit_name(bit).c_str());
+				add_input(bit, bit_name(bit));
+			}
+
+		for (auto cell : ff_cells)
+		{
+			RTLIL::SigSpec q_sig = cell->connections.at("\\Q");
+			RTLIL::SigSpec d_sig = cell->connections.at("\\D");
+
+			for (int i = 0; i < q_sig.width; i++)
+			{
+				latch_t latch;
+				latch.q = sigmap(q_sig.extract(i, 1));
+				latch.d = sigmap(d_sig.extract(i, 1));
+				latch.init = -1;
+
+				RTLIL::SigBit orig_bit = q_sig.extract(i, 1);
+				latch.name = bit_name(orig_bit);
+
+				if (orig_bit.wire->attributes.count("\\init")) {
+					RTLIL::Const &init = orig_bit.wire->attributes.at("\\init");
+					if (orig_bit.offset < int(init.bits.size()) && init.bits[orig_bit.offset] == RTLIL::State::S0)
+						latch.init = 0;
+					if (orig_bit.offset < int(init.bits.size()) && init.bits[orig_bit.offset] == RTLIL::State::S1)
+						latch.init = 1;
+				}
+
+				bit_lits[latch.q] = 2 * (++num_vars);
+				latches.push_back(latch);
+			}
+		}
+
+		// from here on every new variable is an AND gate, created in topological order
+
+		for (auto &latch : latches)
+			latch_next_lits.push_back(bit2lit(latch.d));
+
+		for (auto &it : outputs)
+		for (int i = 0; i < it.second->width; i++) {
+			RTLIL::SigBit bit(it.second, i);
+			output_lits.push_back(bit2lit(sigmap(RTLIL::SigSpec(bit))));
+			output_names.push_back(bit_name(bit));
+		}
+	}
+
+	static void write_unsigned(FILE *f, unsigned int x)
+	{
+		while (x & ~0x7f) {
+			fputc((x & 0x7f) | 0x80, f);
+			x >>= 7;
+		}
+		fputc(x, f);
+	}
+
+	void write(FILE *f, bool ascii_mode, bool symbols_mode)
+	{
+		int num_inputs = input_names.size();
+		int num_latches = latches.size();
+
+		fprintf(f, "%s %d %d %d %d %d\n", ascii_mode ? "aag" : "aig", num_vars, num_inputs, num_latches,
+				int(output_lits.size()), int(and_gates.size()));
+
+		if (ascii_mode)
+			for (int i = 0; i < num_inputs; i++)
+				fprintf(f, "%d\n", 2 * (i + 1));
+
+		for (int i = 0; i < num_latches; i++) {
+			int lit = 2 * (num_inputs + i + 1);
+			if (ascii_mode)
+				fprintf(f, "%d ", lit);
+			if (latches[i].init == 0)
+				fprintf(f, "%d\n", latch_next_lits[i]);
+			else
+				fprintf(f, "%d %d\n", latch_next_lits[i], latches[i].init < 0 ? lit : 1);
+		}
+
+		for (int lit : output_lits)
+			fprintf(f, "%d\n", lit);
+
+		for (size_t i = 0; i < and_gates.size(); i++) {
+			int lhs = 2 * (num_inputs + num_latches + i + 1);
+			log_assert(lhs > and_gates[i].first && and_gates[i].first >= and_gates[i].second);
+			if (ascii_mode) {
+				fprintf(f, "%d %d %d\n", lhs, and_gates[i].first, and_gates[i].second);
+			} else {
+				write_unsigned(f, lhs - and_gates[i].first);
+				write_unsigned(f, and_gates[i].first - and_gates[i].second);
+			}
+		}
+
+		if (symbols_mode) {
+			for (int i = 0; i < num_inputs; i++)
+				if (!input_names[i].empty())
+					fprintf(f, "i%d %s\n", i, input_names[i].c_str());
+			for (int i = 0; i < num_latches; i++)
+				fprintf(f, "l%d %s\n", i, latches[i].name.c_str());
+			for (size_t i = 0; i < output_names.size(); i++)
+				fprintf(f, "o%d %s\n", int(i), output_names[i].c_str());
+		}
+
+		fprintf(f, "c\nGenerated by %s\n", yosys_version_str);
+	}
+};
+
+struct AigerBackend : public Backend {
+	AigerBackend() : Backend("aiger", "write design to AIGER file") { }
+	virtual void help()
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    write_aiger [options] [filename]\n");
+		log("\n");
+		log("Write the top module of the current design to an AIGER file. The module must\n");
+		log("only contain internal gates ($_INV_, $_AND_, $_OR_, $_XOR_, $_MUX_) and flip-flops\n");
+		log("($_DFF_P_, $_DFF_N_, $dff) that are all driven by the same clock. The clock is\n");
+		log("implicit in the AIGER format and is therefore not written as input. Undriven\n");
+		log("signals are treated as additional inputs.\n");
+		log("\n");
+		log("Flip-flops are initialized using the 'init' attribute on their output wires.\n");
+		log("Flip-flops without an 'init' attribute are written as uninitialized latches.\n");
+		log("\n");
+		log("    -top top_module\n");
+		log("        set the specified module as design top module\n");
+		log("\n");
+		log("    -ascii\n");
+		log("        write the ASCII variant of the format (aag) instead of the binary\n");
+		log("        variant (aig)\n");
+		log("\n");
+		log("    -nosymbols\n");
+		log("        do not write the symbol table with the names of inputs, outputs\n");
+		log("        and latches\n");
+		log("\n");
+	}
+	virtual void execute(FILE *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design)
+	{
+		std::string top_module_name;
+		bool ascii_mode = false;
+		bool symbols_mode = true;
+
+		log_header("Executing AIGER backend.\n");
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++)
+		{
+			if (args[argidx] == "-top" && argidx+1 < args.size()) {
+				top_module_name = RTLIL::escape_id(args[++argidx]);
+				continue;
+			}
+			if (args[argidx] == "-ascii") {
+				ascii_mode = true;
+				continue;
+			}
+			if (args[argidx] == "-nosymbols") {
+				symbols_mode = false;
+				continue;
+			}
+			break;
+		}
+		extra_args(f, filename, args, argidx);
+
+		if (top_module_name.empty())
+			for (auto &mod_it : design->modules)
+				if (mod_it.second->get_bool_attribute("\\top"))
+					top_module_name = mod_it.first;
+
+		if (top_module_name.empty())
+			for (auto &mod_it : design->modules) {
+				if (mod_it.second->get_bool_attribute("\\blackbox"))
+					continue;
+				if (!top_module_name.empty())
+					log_error("Found more than one module in design and no top module is selected. Use -top or the 'hierarchy' command.\n");
+				top_module_name = mod_it.first;
+			}
+
+		if (design->modules.count(top_module_name) == 0)
+			log_error("Can't find top module in current design!\n");
+
+		RTLIL::Module *module = design->modules.at(top_module_name);
+
+		if (module->processes.size() != 0)
+			log_error("Found unmapped processes in module %s: unmapped processes are not supported in AIGER backend!\n", RTLIL::id2cstr(module->name));
+		if (module->memories.size() != 0)
+			log_error("Found unmapped memories in module %s: unmapped memories are not supported in AIGER backend!\n", RTLIL::id2cstr(module->name));
+
+		log("Writing module %s.\n", RTLIL::id2cstr(module->name));
+
+		AigerWriter writer(module);
+		writer.setup();
+		writer.write(f, ascii_mode, symbols_mode);
+
+		log("Wrote %d inputs, %d latches, %d outputs and %d AND gates.\n", int(writer.input_names.size()),
+				int(writer.latches.size()), int(writer.output_lits.size()), int(writer.and_gates.size()));
+	}
+} AigerBackend;
+
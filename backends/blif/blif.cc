@@ -27,6 +27,7 @@
 #include "kernel/celltypes.h"
 #include "kernel/log.h"
 #include <string>
+#include <list>
 #include <assert.h>
 
 struct BlifDumperConfig
@@ -56,7 +57,7 @@ struct BlifDumper
 	{
 	}
 
-	std::vector<std::string> cstr_buf;
+	std::list<std::string> cstr_buf;
 
 	const char *cstr(RTLIL::IdString id)
 	{
@@ -0,0 +1,456 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+// [[CITE]] The AIGER And-Inverter Graph (AIG) Format Version 20071012
+// Armin Biere, FMV Reports Series, Institute for Formal Models and Verification, Johannes Kepler University, 2007
+// http://fmv.jku.at/papers/Biere-FMV-TR-07-1.pdf
+
+#include "kernel/register.h"
+#include "kernel/log.h"
+#include "aigerparse.h"
+#include <string.h>
+#include <stdlib.h>
+
+struct AigerParser
+{
+	struct latch_t {
+		unsigned int lit, next, init;
+	};
+
+	struct port_t {
+		std::string name;
+		int width;
+		bool is_input;
+	};
+
+	FILE *f;
+	RTLIL::Module *module;
+	bool binary_mode;
+	unsigned int num_vars, num_inputs, num_latches, num_outputs, num_ands;
+
+	std::vector<unsigned int> input_lits, output_lits;
+	std::vector<latch_t> latches;
+	std::vector<unsigned int> and_lits;
+	std::vector<std::pair<unsigned int, unsigned int>> and_inputs;
+	std::vector<std::string> input_syms, latch_syms, output_syms;
+
+	std::vector<RTLIL::SigBit> var_bits;
+	std::vector<RTLIL::Wire*> inv_wires;
+
+	AigerParser(FILE *f, RTLIL::Module *module) : f(f), module(module), binary_mode(false),
+			num_vars(0), num_inputs(0), num_latches(0), num_outputs(0), num_ands(0) { }
+
+	// reads an unsigned decimal number and returns the character that terminated it
+	unsigned int read_number(int &term)
+	{
+		int ch = fgetc(f);
+		while (ch == ' ')
+			ch = fgetc(f);
+		if (ch < '0' || ch > '9')
+			log_error("Syntax error in AIGER file: expected number.\n");
+		unsigned int value = 0;
+		while (ch >= '0' && ch <= '9') {
+			value = 10*value + (ch - '0');
+			ch = fgetc(f);
+		}
+		if (ch == '\r')
+			ch = fgetc(f);
+		term = ch;
+		return value;
+	}
+
+	unsigned int read_line_number()
+	{
+		int term;
+		unsigned int value = read_number(term);
+		if (term != '\n')
+			log_error("Syntax error in AIGER file: expected end of line.\n");
+		return value;
+	}
+
+	unsigned int read_binary_delta()
+	{
+		unsigned int x = 0, i = 0;
+		int ch;
+		while ((ch = fgetc(f)) & 0x80) {
+			if (ch == EOF)
+				log_error("Unexpected end of file in binary AIGER data.\n");
+			x |= (ch & 0x7f) << (7 * i++);
+		}
+		if (ch == EOF)
+			log_error("Unexpected end of file in binary AIGER data.\n");
+		return x | (ch << (7 * i));
+	}
+
+	void check_lit(unsigned int lit)
+	{
+		if (lit / 2 > num_vars)
+			log_error("Literal %u in AIGER file exceeds maximum variable index %u.\n", lit, num_vars);
+	}
+
+	void parse_header()
+	{
+		char format[4] = { 0, 0, 0, 0 };
+		if (fread(format, 1, 3, f) != 3 || (strcmp(format, "aig") && strcmp(format, "aag")))
+			log_error("Input is not an AIGER file: missing 'aig' or 'aag' header.\n");
+		binary_mode = !strcmp(format, "aig");
+
+		int term;
+		num_vars = read_number(term);
+		num_inputs = read_number(term);
+		num_latches = read_number(term);
+		num_outputs = read_number(term);
+		num_ands = read_number(term);
+
+		// AIGER 1.9 header extensions (bad state, constraint, justice and fairness properties)
+		while (term == ' ')
+			if (read_number(term) != 0)
+				log_error("AIGER file uses properties from AIGER 1.9. Only plain AIGER models are supported.\n");
+		if (term != '\n')
+			log_error("Syntax error in AIGER header.\n");
+
+		if (num_vars < num_inputs + num_latches + num_ands)
+			log_error("Inconsistent AIGER header: M=%u is smaller than I+L+A=%u.\n", num_vars, num_inputs + num_latches + num_ands);
+	}
+
+	void parse_body()
+	{
+		for (unsigned int i = 0; i < num_inputs; i++) {
+			unsigned int lit = binary_mode ? 2*(i+1) : read_line_number();
+			check_lit(lit);
+			if (lit < 2 || (lit & 1))
+				log_error("Invalid input literal %u in AIGER file.\n", lit);
+			input_lits.push_back(lit);
+		}
+
+		for (unsigned int i = 0; i < num_latches; i++) {
+			latch_t latch;
+			int term;
+			latch.lit = binary_mode ? 2*(num_inputs+i+1) : read_number(term);
+			latch.next = read_number(term);
+			latch.init = 0;
+			if (term == ' ')
+				latch.init = read_number(term);
+			if (term != '\n')
+				log_error("Syntax error in latch definition in AIGER file.\n");
+			check_lit(latch.lit);
+			check_lit(latch.next);
+			if (latch.lit < 2 || (latch.lit & 1) || (latch.init > 1 && latch.init != latch.lit))
+				log_error("Invalid latch definition for literal %u in AIGER file.\n", latch.lit);
+			latches.push_back(latch);
+		}
+
+		for (unsigned int i = 0; i < num_outputs; i++) {
+			output_lits.push_back(read_line_number());
+			check_lit(output_lits.back());
+		}
+
+		for (unsigned int i = 0; i < num_ands; i++) {
+			unsigned int lhs, rhs0, rhs1;
+			if (binary_mode) {
+				lhs = 2*(num_inputs+num_latches+i+1);
+				rhs0 = lhs - read_binary_delta();
+				rhs1 = rhs0 - read_binary_delta();
+			} else {
+				int term;
+				lhs = read_number(term);
+				rhs0 = read_number(term);
+				rhs1 = read_number(term);
+				if (term != '\n')
+					log_error("Syntax error in AND gate definition in AIGER file.\n");
+			}
+			check_lit(lhs);
+			check_lit(rhs0);
+			check_lit(rhs1);
+			if (lhs < 2 || (lhs & 1))
+				log_error("Invalid AND gate literal %u in AIGER file.\n", lhs);
+			and_inputs.resize(std::max<size_t>(and_inputs.size(), lhs/2 + 1), std::pair<unsigned int, unsigned int>(0, 0));
+			and_inputs[lhs/2] = std::pair<unsigned int, unsigned int>(rhs0, rhs1);
+			and_lits.push_back(lhs);
+		}
+	}
+
+	void parse_symbols()
+	{
+		input_syms.resize(num_inputs);
+		latch_syms.resize(num_latches);
+		output_syms.resize(num_outputs);
+
+		while (1)
+		{
+			int type = fgetc(f);
+			if (type == EOF || type == 'c')
+				break;
+
+			if (type != 'i' && type != 'l' && type != 'o')
+				log_error("Unsupported entry '%c' in AIGER symbol table.\n", type);
+
+			int term;
+			unsigned int index = read_number(term);
+			if (term != ' ')
+				log_error("Syntax error in AIGER symbol table.\n");
+
+			std::string name;
+			for (int ch = fgetc(f); ch != '\n' && ch != EOF; ch = fgetc(f))
+				if (ch != '\r')
+					name += ch;
+
+			std::vector<std::string> &syms = type == 'i' ? input_syms : type == 'l' ? latch_syms : output_syms;
+			if (index >= syms.size() || name.empty())
+				log_error("Invalid entry '%c%u' in AIGER symbol table.\n", type, index);
+			syms[index] = name;
+		}
+	}
+
+	// splits "name[index]" into its components, or returns -1 if the symbol is not indexed
+	static int split_symbol(std::string sym, std::string &name)
+	{
+		name = sym;
+		if (sym.size() < 4 || sym[sym.size()-1] != ']')
+			return -1;
+		size_t pos = sym.find_last_of('[');
+		if (pos == std::string::npos || pos == 0 || pos+2 >= sym.size())
+			return -1;
+		for (size_t i = pos+1; i+1 < sym.size(); i++)
+			if (sym[i] < '0' || sym[i] > '9')
+				return -1;
+		name = sym.substr(0, pos);
+		return atoi(sym.c_str() + pos + 1);
+	}
+
+	// groups indexed symbols into multi-bit port wires and returns the port bit for each symbol
+	std::vector<RTLIL::SigBit> create_ports(std::vector<std::string> &syms, const char *default_prefix, bool is_input, std::set<std::string> &port_names)
+	{
+		std::vector<std::string> names;
+		std::vector<int> indices;
+		std::map<std::string, int> widths;
+		std::map<std::string, bool> indexed;
+		std::vector<std::string> order;
+
+		for (size_t i = 0; i < syms.size(); i++) {
+			std::string name;
+			int index = split_symbol(syms[i].empty() ? stringf("%s%d", default_prefix, int(i)) : syms[i], name);
+			name = RTLIL::escape_id(name);
+			if (widths.count(name) == 0) {
+				if (port_names.count(name))
+					log_error("Duplicate port name %s in AIGER file.\n", RTLIL::id2cstr(name));
+				widths[name] = 0;
+				indexed[name] = index >= 0;
+				order.push_back(name);
+			}
+			if (indexed.at(name) != (index >= 0))
+				log_error("Port %s in AIGER file is used with and without bit index.\n", RTLIL::id2cstr(name));
+			widths[name] = std::max(widths[name], index + 1);
+			names.push_back(name);
+			indices.push_back(index);
+		}
+
+		for (auto &name : order) {
+			RTLIL::Wire *wire = new RTLIL::Wire;
+			wire->name = name;
+			wire->width = std::max(widths.at(name), 1);
+			wire->port_input = is_input;
+			wire->port_output = !is_input;
+			wire->port_id = port_names.size() + 1;
+			module->add(wire);
+			port_names.insert(name);
+		}
+
+		std::set<RTLIL::SigBit> used_bits;
+		std::vector<RTLIL::SigBit> bits;
+		for (size_t i = 0; i < names.size(); i++) {
+			RTLIL::SigBit bit(module->wires.at(names[i]), std::max(indices[i], 0));
+			if (used_bits.count(bit))
+				log_error("Duplicate port bit %s in AIGER file.\n", syms[i].c_str());
+			used_bits.insert(bit);
+			bits.push_back(bit);
+		}
+		return bits;
+	}
+
+	RTLIL::SigSpec lit2sig(unsigned int lit)
+	{
+		if (lit < 2)
+			return RTLIL::SigSpec(lit ? RTLIL::State::S1 : RTLIL::State::S0);
+		if ((lit & 1) == 0)
+			return var_bits.at(lit/2);
+
+		RTLIL::Wire *&inv_wire = inv_wires.at(lit/2);
+		if (inv_wire == NULL) {
+			inv_wire = module->new_wire(1, NEW_ID);
+			RTLIL::Cell *cell = new RTLIL::Cell;
+			cell->name = NEW_ID;
+			cell->type = "$_INV_";
+			cell->connections["\\A"] = var_bits.at(lit/2);
+			cell->connections["\\Y"] = inv_wire;
+			module->add(cell);
+		}
+		return inv_wire;
+	}
+
+	void create_netlist(std::string clk_name)
+	{
+		std::set<std::string> port_names;
+		std::vector<RTLIL::SigBit> input_bits = create_ports(input_syms, "i", true, port_names);
+
+		var_bits.resize(num_vars + 1);
+		inv_wires.resize(num_vars + 1);
+
+		for (unsigned int i = 0; i < num_inputs; i++)
+			var_bits.at(input_lits[i]/2) = input_bits[i];
+
+		RTLIL::Wire *clk_wire = NULL;
+		if (num_latches > 0) {
+			if (port_names.count(RTLIL::escape_id(clk_name)))
+				log_error("Clock name %s conflicts with an input port name.\n", clk_name.c_str());
+			clk_wire = new RTLIL::Wire;
+			clk_wire->name = RTLIL::escape_id(clk_name);
+			clk_wire->port_input = true;
+			clk_wire->port_id = port_names.size() + 1;
+			module->add(clk_wire);
+			port_names.insert(clk_wire->name);
+		}
+
+		// the output ports are created before the latch wires, so a latch with
+		// the same symbol as an output (e.g. a registered output written by
+		// write_aiger) gets a new name instead of colliding with the port.
+		std::vector<RTLIL::SigBit> output_bits = create_ports(output_syms, "o", false, port_names);
+
+		for (unsigned int i = 0; i < num_latches; i++) {
+			RTLIL::IdString name = latch_syms[i].empty() ? RTLIL::IdString(NEW_ID) : RTLIL::escape_id(latch_syms[i]);
+			if (module->wires.count(name))
+				name = NEW_ID;
+			RTLIL::Wire *wire = module->new_wire(1, name);
+			if (latches[i].init < 2)
+				wire->attributes["\\init"] = RTLIL::Const(latches[i].init, 1);
+			var_bits.at(latches[i].lit/2) = wire;
+		}
+
+		for (auto lhs : and_lits)
+			var_bits.at(lhs/2) = module->new_wire(1, NEW_ID);
+
+		for (unsigned int i = 1; i <= num_vars; i++)
+			if (var_bits[i].wire == NULL)
+				var_bits[i] = module->new_wire(1, NEW_ID);
+
+		for (auto lhs : and_lits) {
+			RTLIL::Cell *cell = new RTLIL::Cell;
+			cell->name = NEW_ID;
+			cell->type = "$_AND_";
+			cell->connections["\\A"] = lit2sig(and_inputs[lhs/2].first);
+			cell->connections["\\B"] = lit2sig(and_inputs[lhs/2].second);
+			cell->connections["\\Y"] = var_bits.at(lhs/2);
+			module->add(cell);
+		}
+
+		for (unsigned int i = 0; i < num_latches; i++) {
+			RTLIL::Cell *cell = new RTLIL::Cell;
+			cell->name = NEW_ID;
+			cell->type = "$_DFF_P_";
+			cell->connections["\\C"] = clk_wire;
+			cell->connections["\\D"] = lit2sig(latches[i].next);
+			cell->connections["\\Q"] = var_bits.at(latches[i].lit/2);
+			module->add(cell);
+		}
+
+		for (unsigned int i = 0; i < num_outputs; i++)
+			module->connections.push_back(RTLIL::SigSig(output_bits[i], lit2sig(output_lits[i])));
+	}
+};
+
+RTLIL::Module *parse_aiger(FILE *f, RTLIL::Design *design, std::string module_name, std::string clk_name)
+{
+	RTLIL::Module *module = new RTLIL::Module;
+	module->name = RTLIL::escape_id(module_name);
+
+	if (design->modules.count(module->name))
+		log_error("Duplicate definition of module %s.\n", RTLIL::id2cstr(module->name));
+
+	AigerParser parser(f, module);
+	parser.parse_header();
+	parser.parse_body();
+	parser.parse_symbols();
+	parser.create_netlist(clk_name);
+
+	design->modules[module->name] = module;
+	return module;
+}
+
+struct AigerFrontend : public Frontend {
+	AigerFrontend() : Frontend("aiger", "read AIGER file") { }
+	virtual void help()
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    read_aiger [options] [filename]\n");
+		log("\n");
+		log("Load a module from an AIGER file (binary 'aig' or ASCII 'aag' format). AND\n");
+		log("gates are converted to $_AND_ and $_INV_ cells and latches to $_DFF_P_ cells\n");
+		log("with a common clock input. Latch initial values are stored in 'init'\n");
+		log("attributes. Inputs and outputs with names of the form 'name[index]' in the\n");
+		log("symbol table are grouped into multi-bit ports.\n");
+		log("\n");
+		log("    -module_name <module_name>\n");
+		log("        name of the created module. the default is the name of the input\n");
+		log("        file without path and extension.\n");
+		log("\n");
+		log("    -clk_name <wire_name>\n");
+		log("        name of the clock input created for designs with latches. the\n");
+		log("        default is 'clk'.\n");
+		log("\n");
+	}
+	virtual void execute(FILE *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design)
+	{
+		std::string module_name, clk_name = "clk";
+
+		log_header("Executing AIGER frontend.\n");
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++) {
+			std::string arg = args[argidx];
+			if (arg == "-module_name" && argidx+1 < args.size()) {
+				module_name = args[++argidx];
+				continue;
+			}
+			if (arg == "-clk_name" && argidx+1 < args.size()) {
+				clk_name = args[++argidx];
+				continue;
+			}
+			break;
+		}
+		extra_args(f, filename, args, argidx);
+
+		if (module_name.empty()) {
+			module_name = filename;
+			size_t pos = module_name.find_last_of('/');
+			if (pos != std::string::npos)
+				module_name = module_name.substr(pos+1);
+			pos = module_name.find_last_of('.');
+			if (pos != std::string::npos && pos > 0)
+				module_name = module_name.substr(0, pos);
+			if (module_name.empty() || module_name == "<stdin>")
+				module_name = "aiger";
+		}
+
+		RTLIL::Module *module = parse_aiger(f, design, module_name, clk_name);
+
+		log("Created module %s with %d cells.\n", RTLIL::id2cstr(module->name), int(module->cells.size()));
+	}
+} AigerFrontend;
+
@@ -2,11 +2,11 @@
  *  yosys -- Yosys Open SYnthesis Suite
  *
  *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
- *  
+ *
  *  Permission to use, copy, modify, and/or distribute this software for any
  *  purpose with or without fee is hereby granted, provided that the above
  *  copyright notice and this permission notice appear in all copies.
- *  
+ *
  *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
  *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
  *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
@@ -17,12 +17,13 @@
  *
  */
 
-#ifndef ABC_BLIFPARSE
-#define ABC_BLIFPARSE
+#ifndef AIGERPARSE_H
+#define AIGERPARSE_H
 
 #include "kernel/rtlil.h"
+#include <stdio.h>
 
-extern RTLIL::Design *abc_parse_blif(FILE *f, std::string dff_name);
+extern RTLIL::Module *parse_aiger(FILE *f, RTLIL::Design *design, std::string module_name, std::string clk_name);
 
 #endif
 
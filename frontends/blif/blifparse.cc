@@ -0,0 +1,511 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+// [[CITE]] Berkeley Logic Interchange Format (BLIF)
+// University of California, Berkeley, 1992
+// http://www.cs.uic.edu/~jlillis/courses/cs594/spring05/blif.pdf
+
+#include "kernel/register.h"
+#include "kernel/log.h"
+#include "blifparse.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unordered_map>
+
+// The parser works directly on the (usually memory mapped) input buffer. Each
+// logical line is split into tokens that point into the buffer, so no string
+// is copied unless it is used as a name in the created modules.
+
+struct BlifParser
+{
+	struct token_t {
+		const char *text;
+		int len;
+
+		bool operator==(const char *str) const {
+			return strncmp(text, str, len) == 0 && str[len] == 0;
+		}
+		std::string str() const {
+			return std::string(text, len);
+		}
+	};
+
+	RTLIL::Design *design;
+	const char *ptr, *end;
+	std::string default_model, dff_name, clk_name;
+
+	std::vector<token_t> tokens;
+	int line_nr, token_line_nr;
+	bool pushed_back;
+
+	RTLIL::Module *module;
+	std::unordered_map<std::string, RTLIL::Wire*> wires;
+	std::string key;
+	int port_count;
+
+	BlifParser(RTLIL::Design *design, const char *data, size_t size) : design(design), ptr(data), end(data + size),
+			line_nr(1), token_line_nr(1), pushed_back(false), module(NULL), port_count(0) { }
+
+	void syntax_error()
+	{
+		log_error("Syntax error in BLIF file in line %d.\n", token_line_nr);
+	}
+
+	bool is_space(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	// a backslash at the end of a line continues the logical line on the next line
+	bool is_continuation(const char *p)
+	{
+		if (p >= end || *p != '\\')
+			return false;
+		p++;
+		while (p < end && *p == '\r')
+			p++;
+		return p == end || *p == '\n';
+	}
+
+	bool next_line()
+	{
+		if (pushed_back) {
+			pushed_back = false;
+			return true;
+		}
+
+		tokens.clear();
+		while (ptr < end)
+		{
+			char c = *ptr;
+			if (c == '\n') {
+				ptr++, line_nr++;
+				if (!tokens.empty())
+					return true;
+				continue;
+			}
+			if (is_space(c)) {
+				ptr++;
+				continue;
+			}
+			if (c == '#') {
+				const char *p = (const char*)memchr(ptr, '\n', end - ptr);
+				ptr = p ? p : end;
+				continue;
+			}
+			if (is_continuation(ptr)) {
+				while (ptr < end && *ptr != '\n')
+					ptr++;
+				if (ptr < end)
+					ptr++, line_nr++;
+				continue;
+			}
+
+			token_t tok;
+			tok.text = ptr;
+			while (ptr < end && *ptr != '\n' && !is_space(*ptr) && !is_continuation(ptr))
+				ptr++;
+			tok.len = ptr - tok.text;
+			if (tokens.empty())
+				token_line_nr = line_nr;
+			tokens.push_back(tok);
+		}
+		return !tokens.empty();
+	}
+
+	RTLIL::Wire *get_wire(const token_t &tok)
+	{
+		key.assign(tok.text, tok.len);
+		auto it = wires.find(key);
+		if (it != wires.end())
+			return it->second;
+
+		RTLIL::Wire *wire = new RTLIL::Wire;
+		wire->name = "\\" + key;
+		if (module->wires.count(wire->name))
+			log_error("Duplicate wire name `%s' in BLIF file in line %d.\n", key.c_str(), token_line_nr);
+		module->add(wire);
+		wires[key] = wire;
+		return wire;
+	}
+
+	RTLIL::Cell *add_cell(std::string type)
+	{
+		RTLIL::Cell *cell = new RTLIL::Cell;
+		cell->name = NEW_ID;
+		cell->type = type;
+		module->add(cell);
+		return cell;
+	}
+
+	void begin_model(std::string name)
+	{
+		module = new RTLIL::Module;
+		module->name = "\\" + name;
+		if (design->modules.count(module->name))
+			log_error("Duplicate definition of module %s in BLIF file in line %d.\n", name.c_str(), token_line_nr);
+		design->modules[module->name] = module;
+		wires.clear();
+		port_count = 0;
+	}
+
+	void end_model()
+	{
+		module->fixup_ports();
+		module = NULL;
+	}
+
+	void parse_ports(bool is_input)
+	{
+		for (size_t i = 1; i < tokens.size(); i++) {
+			RTLIL::Wire *wire = get_wire(tokens[i]);
+			if (wire->port_id == 0)
+				wire->port_id = ++port_count;
+			if (is_input)
+				wire->port_input = true;
+			else
+				wire->port_output = true;
+		}
+	}
+
+	// .names <in-1> .. <in-n> <out> followed by the single output cover
+	void parse_names()
+	{
+		if (tokens.size() < 2)
+			syntax_error();
+
+		int width = tokens.size() - 2;
+		if (width > 16)
+			log_error("Too many inputs (%d) for a .names command in BLIF file in line %d.\n", width, token_line_nr);
+
+		RTLIL::SigSpec input_sig;
+		for (int i = 0; i < width; i++)
+			input_sig.append(get_wire(tokens[i+1]));
+		RTLIL::SigSpec output_sig = get_wire(tokens.back());
+
+		std::vector<RTLIL::State> bits(1 << width, RTLIL::State::Sx);
+		RTLIL::State cover_state = RTLIL::State::Sx;
+
+		while (next_line())
+		{
+			if (tokens[0].text[0] == '.') {
+				pushed_back = true;
+				break;
+			}
+
+			const token_t &output = tokens.back();
+			if (int(tokens.size()) != (width > 0 ? 2 : 1) || output.len != 1 || (output.text[0] != '0' && output.text[0] != '1'))
+				syntax_error();
+
+			RTLIL::State state = output.text[0] == '1' ? RTLIL::State::S1 : RTLIL::State::S0;
+			if (cover_state != RTLIL::State::Sx && cover_state != state)
+				log_error("Mixed on-set and off-set cubes for a .names command in BLIF file in line %d.\n", token_line_nr);
+			cover_state = state;
+
+			if (width == 0)
+				continue;
+
+			const token_t &input = tokens[0];
+			if (input.len != width)
+				syntax_error();
+
+			// set all minterms of the cube by enumerating the subsets of its don't-care inputs
+			int fixed = 0, free = 0;
+			for (int j = 0; j < width; j++)
+				switch (input.text[j]) {
+					case '0': break;
+					case '1': fixed |= 1 << j; break;
+					case '-': free |= 1 << j; break;
+					default: syntax_error();
+				}
+			for (int sub = free;; sub = (sub - 1) & free) {
+				bits[fixed | sub] = state;
+				if (sub == 0)
+					break;
+			}
+		}
+
+		// an empty cover is the constant 0, minterms not in the cover have the opposite output value
+		RTLIL::State default_state = cover_state == RTLIL::State::S0 ? RTLIL::State::S1 : RTLIL::State::S0;
+
+		if (width == 0) {
+			module->connections.push_back(RTLIL::SigSig(output_sig, cover_state == RTLIL::State::S1 ? RTLIL::State::S1 : RTLIL::State::S0));
+			return;
+		}
+
+		for (auto &bit : bits)
+			if (bit == RTLIL::State::Sx)
+				bit = default_state;
+
+		RTLIL::Cell *cell = add_cell("$lut");
+		cell->parameters["\\WIDTH"] = RTLIL::Const(width);
+		cell->parameters["\\LUT"] = RTLIL::Const(bits);
+		cell->connections["\\I"] = input_sig;
+		cell->connections["\\O"] = output_sig;
+	}
+
+	// .latch <input> <output> [<type> <control>] [<init-val>]
+	void parse_latch()
+	{
+		int init = 3;
+		size_t nargs = tokens.size() - 1;
+		if (nargs == 3 || nargs == 5) {
+			const token_t &tok = tokens.back();
+			if (tok.len != 1 || tok.text[0] < '0' || tok.text[0] > '3')
+				syntax_error();
+			init = tok.text[0] - '0';
+			nargs--;
+		}
+		if (nargs != 2 && nargs != 4)
+			syntax_error();
+
+		RTLIL::Wire *d = get_wire(tokens[1]);
+		RTLIL::Wire *q = get_wire(tokens[2]);
+		RTLIL::Cell *cell = NULL;
+
+		if (nargs == 4 && !(tokens[3] == "as") && !(tokens[4] == "NIL"))
+		{
+			const char *type = NULL, *ctrl_port = NULL;
+			if (tokens[3] == "re")
+				type = "$_DFF_P_", ctrl_port = "\\C";
+			else if (tokens[3] == "fe")
+				type = "$_DFF_N_", ctrl_port = "\\C";
+			else if (tokens[3] == "ah")
+				type = "$_DLATCH_P_", ctrl_port = "\\E";
+			else if (tokens[3] == "al")
+				type = "$_DLATCH_N_", ctrl_port = "\\E";
+			else
+				log_error("Unsupported latch type `%s' in BLIF file in line %d.\n", tokens[3].str().c_str(), token_line_nr);
+			cell = add_cell(type);
+			cell->connections[ctrl_port] = get_wire(tokens[4]);
+		}
+		else if (clk_name.empty())
+		{
+			cell = add_cell(dff_name);
+		}
+		else
+		{
+			token_t tok = { clk_name.data(), int(clk_name.size()) };
+			RTLIL::Wire *clk = get_wire(tok);
+			if (clk->port_id == 0) {
+				clk->port_id = ++port_count;
+				clk->port_input = true;
+			}
+			cell = add_cell("$_DFF_P_");
+			cell->connections["\\C"] = clk;
+		}
+
+		cell->connections["\\D"] = d;
+		cell->connections["\\Q"] = q;
+
+		if (init == 0 || init == 1)
+			q->attributes["\\init"] = RTLIL::Const(init, 1);
+	}
+
+	// .gate/.subckt <type> <formal-1>=<actual-1> .. <formal-n>=<actual-n>
+	void parse_instance()
+	{
+		if (tokens.size() < 2)
+			syntax_error();
+
+		RTLIL::Cell *cell = add_cell("\\" + tokens[1].str());
+		for (size_t i = 2; i < tokens.size(); i++) {
+			const token_t &tok = tokens[i];
+			const char *eq = (const char*)memchr(tok.text, '=', tok.len);
+			if (eq == NULL || eq == tok.text || eq == tok.text + tok.len - 1)
+				syntax_error();
+			token_t actual = { eq + 1, int(tok.text + tok.len - eq - 1) };
+			cell->connections["\\" + std::string(tok.text, eq - tok.text)] = get_wire(actual);
+		}
+	}
+
+	void parse()
+	{
+		while (next_line())
+		{
+			const token_t &cmd = tokens[0];
+
+			if (cmd == ".model") {
+				if (module != NULL)
+					end_model();
+				begin_model(tokens.size() > 1 ? tokens[1].str() : default_model);
+				continue;
+			}
+
+			if (cmd == ".end") {
+				if (module != NULL)
+					end_model();
+				continue;
+			}
+
+			if (cmd == ".exdc") {
+				// skip the external don't care network up to the .end of the model
+				while (next_line() && !(tokens[0] == ".end")) { }
+				if (module != NULL)
+					end_model();
+				continue;
+			}
+
+			if (module == NULL)
+				begin_model(default_model);
+
+			if (cmd == ".inputs") {
+				parse_ports(true);
+				continue;
+			}
+
+			if (cmd == ".outputs") {
+				parse_ports(false);
+				continue;
+			}
+
+			if (cmd == ".names") {
+				parse_names();
+				continue;
+			}
+
+			if (cmd == ".latch") {
+				parse_latch();
+				continue;
+			}
+
+			if (cmd == ".gate" || cmd == ".subckt") {
+				parse_instance();
+				continue;
+			}
+
+			if (cmd == ".clock" || cmd == ".area" || cmd == ".delay" || cmd == ".wire_load_slope" || cmd == ".wire" ||
+					cmd == ".input_arrival" || cmd == ".default_input_arrival" || cmd == ".output_required" ||
+					cmd == ".default_output_required" || cmd == ".input_drive" || cmd == ".default_input_drive" ||
+					cmd == ".output_load" || cmd == ".default_output_load" || cmd == ".default_max_input_load")
+				continue;
+
+			if (cmd.text[0] == '.')
+				log_error("Unsupported BLIF command `%s' in line %d.\n", cmd.str().c_str(), token_line_nr);
+			syntax_error();
+		}
+
+		if (module != NULL)
+			end_model();
+	}
+};
+
+void parse_blif(RTLIL::Design *design, const char *data, size_t size, std::string default_model,
+		std::string dff_name, std::string clk_name)
+{
+	BlifParser parser(design, data, size);
+	parser.default_model = default_model;
+	parser.dff_name = dff_name;
+	parser.clk_name = clk_name;
+	parser.parse();
+}
+
+struct BlifFrontend : public Frontend {
+	BlifFrontend() : Frontend("blif", "read BLIF file") { }
+	virtual void help()
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    read_blif [options] [filename]\n");
+		log("\n");
+		log("Load modules from a BLIF file. Each .model is converted to a module. The\n");
+		log(".names covers are converted to $lut cells (with up to 16 inputs) or to\n");
+		log("constant drivers, .gate and .subckt instances to cells of the given type and\n");
+		log(".latch commands to $_DFF_P_, $_DFF_N_, $_DLATCH_P_ or $_DLATCH_N_ cells.\n");
+		log("Latch initial values are stored in 'init' attributes.\n");
+		log("\n");
+		log("    -module_name <module_name>\n");
+		log("        name of the module created for a model without a name. the default\n");
+		log("        is the name of the input file without path and extension.\n");
+		log("\n");
+		log("    -clk_name <wire_name>\n");
+		log("        name of the clock input created for latches without a control\n");
+		log("        signal. the default is 'clk'.\n");
+		log("\n");
+	}
+	virtual void execute(FILE *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design)
+	{
+		std::string module_name, clk_name = "clk";
+
+		log_header("Executing BLIF frontend.\n");
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++) {
+			std::string arg = args[argidx];
+			if (arg == "-module_name" && argidx+1 < args.size()) {
+				module_name = args[++argidx];
+				continue;
+			}
+			if (arg == "-clk_name" && argidx+1 < args.size()) {
+				clk_name = args[++argidx];
+				continue;
+			}
+			break;
+		}
+		extra_args(f, filename, args, argidx);
+
+		if (module_name.empty()) {
+			module_name = filename;
+			size_t pos = module_name.find_last_of('/');
+			if (pos != std::string::npos)
+				module_name = module_name.substr(pos+1);
+			pos = module_name.find_last_of('.');
+			if (pos != std::string::npos && pos > 0)
+				module_name = module_name.substr(0, pos);
+			if (module_name.empty() || module_name == "<stdin>")
+				module_name = "blif";
+		}
+
+		// map regular files into memory, read everything else (e.g. pipes) into a buffer
+		void *mapped = NULL;
+		size_t size = 0;
+		std::vector<char> buffer;
+
+		struct stat st;
+		int fd = fileno(f);
+		if (fd >= 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 && ftell(f) == 0) {
+			size = st.st_size;
+			mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (mapped == MAP_FAILED)
+				mapped = NULL;
+			else
+				madvise(mapped, size, MADV_SEQUENTIAL);
+		}
+
+		if (mapped == NULL) {
+			char block[65536];
+			size_t n;
+			while ((n = fread(block, 1, sizeof(block), f)) > 0)
+				buffer.insert(buffer.end(), block, block + n);
+			size = buffer.size();
+		}
+
+		size_t old_num_modules = design->modules.size();
+		parse_blif(design, mapped ? (const char*)mapped : buffer.data(), size, module_name, "", clk_name);
+
+		if (mapped != NULL)
+			munmap(mapped, size);
+
+		log("Read %d modules from BLIF file.\n", int(design->modules.size() - old_num_modules));
+	}
+} BlifFrontend;
+
@@ -0,0 +1,277 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef AIGGEN_H
+#define AIGGEN_H
+
+#include "kernel/rtlil.h"
+#include "kernel/sigtools.h"
+#include "kernel/log.h"
+
+#include "libs/ezaig/ezaig.h"
+
+// Convert the combinational internal gate cells ($_INV_, $_AND_, $_OR_, $_XOR_
+// and $_MUX_) of a module to an ezAIG graph and back. The AIG inputs are the
+// signals read by the gates that are not driven by an imported gate, the AIG
+// outputs are the signals driven by the imported gates that are used elsewhere
+// (by other cells, module ports or wires with the "keep" attribute).
+//
+// Combinational loops are broken by turning one signal of the loop into an
+// additional AIG input. This signal is then also an AIG output so the loop is
+// closed again when the graph is converted back to cells.
+
+struct AigGen
+{
+	ezAIG aig;
+	RTLIL::Module *module;
+	SigMap sigmap;
+
+	std::vector<RTLIL::Cell*> cells;
+	std::vector<RTLIL::SigBit> input_bits, output_bits;
+
+	std::map<RTLIL::SigBit, RTLIL::Cell*> drivers;
+	std::map<RTLIL::SigBit, int> bit_lits, loop_lits;
+
+	AigGen(RTLIL::Module *module) : module(module), sigmap(module) { }
+
+	static bool is_gate(RTLIL::IdString type)
+	{
+		return type == "$_INV_" || type == "$_AND_" || type == "$_OR_" || type == "$_XOR_" || type == "$_MUX_";
+	}
+
+	RTLIL::SigBit port_bit(RTLIL::Cell *cell, std::string port)
+	{
+		return sigmap(cell->connections.at(port));
+	}
+
+	void fanin_bits(RTLIL::Cell *cell, std::vector<RTLIL::SigBit> &bits)
+	{
+		bits.clear();
+		bits.push_back(port_bit(cell, "\\A"));
+		if (cell->type != "$_INV_")
+			bits.push_back(port_bit(cell, "\\B"));
+		if (cell->type == "$_MUX_")
+			bits.push_back(port_bit(cell, "\\S"));
+	}
+
+	int const_lit(RTLIL::SigBit bit)
+	{
+		return bit.data == RTLIL::State::S1 ? ezAIG::CONST_TRUE : ezAIG::CONST_FALSE;
+	}
+
+	int bit2lit(RTLIL::SigBit root)
+	{
+		// iterative depth-first search, so long chains of gates do not overflow the stack
+		std::vector<RTLIL::SigBit> stack = { root };
+		std::set<RTLIL::SigBit> in_progress;
+		std::vector<RTLIL::SigBit> fanins;
+
+		while (!stack.empty())
+		{
+			RTLIL::SigBit bit = stack.back();
+
+			if (bit.wire == NULL || (bit_lits.count(bit) && in_progress.count(bit) == 0)) {
+				stack.pop_back();
+				continue;
+			}
+
+			if (drivers.count(bit) == 0) {
+				bit_lits[bit] = aig.add_input();
+				input_bits.push_back(bit);
+				stack.pop_back();
+				continue;
+			}
+
+			RTLIL::Cell *cell = drivers.at(bit);
+			fanin_bits(cell, fanins);
+
+			if (in_progress.count(bit) == 0) {
+				in_progress.insert(bit);
+				for (auto &fanin : fanins) {
+					if (fanin.wire == NULL || bit_lits.count(fanin))
+						continue;
+					if (in_progress.count(fanin)) {
+						log("  Breaking combinational loop at signal %s.\n", log_signal(fanin));
+						bit_lits[fanin] = aig.add_input();
+						input_bits.push_back(fanin);
+						output_bits.push_back(fanin);
+						continue;
+					}
+					stack.push_back(fanin);
+				}
+				continue;
+			}
+
+			std::vector<int> lits;
+			for (auto &fanin : fanins)
+				lits.push_back(fanin.wire == NULL ? const_lit(fanin) : bit_lits.at(fanin));
+
+			int lit = 0;
+			if (cell->type == "$_INV_")
+				lit = ezAIG::NOT(lits[0]);
+			else if (cell->type == "$_AND_")
+				lit = aig.AND(lits[0], lits[1]);
+			else if (cell->type == "$_OR_")
+				lit = aig.OR(lits[0], lits[1]);
+			else if (cell->type == "$_XOR_")
+				lit = aig.XOR(lits[0], lits[1]);
+			else if (cell->type == "$_MUX_")
+				lit = aig.MUX(lits[2], lits[0], lits[1]);
+			else
+				log_abort();
+
+			stack.pop_back();
+			in_progress.erase(bit);
+
+			// a signal that was used to break a loop keeps its input literal, the
+			// function computed here is connected to it by the AIG output
+			if (bit_lits.count(bit) == 0)
+				bit_lits[bit] = lit;
+			else
+				loop_lits[bit] = lit;
+		}
+
+		return bit_lits.at(root);
+	}
+
+	void import_cells(const std::vector<RTLIL::Cell*> &gate_cells)
+	{
+		std::set<RTLIL::Cell*> gate_set;
+		for (auto cell : gate_cells) {
+			RTLIL::SigBit bit = port_bit(cell, "\\Y");
+			if (bit.wire == NULL || drivers.count(bit))
+				continue;
+			drivers[bit] = cell;
+			cells.push_back(cell);
+			gate_set.insert(cell);
+		}
+
+		std::set<RTLIL::SigBit> used_bits;
+		for (auto &it : module->cells) {
+			if (gate_set.count(it.second))
+				continue;
+			for (auto &conn : it.second->connections)
+				for (auto bit : sigmap(conn.second).to_sigbit_vector())
+					used_bits.insert(bit);
+		}
+		for (auto &it : module->wires) {
+			RTLIL::Wire *wire = it.second;
+			if (wire->port_id > 0 || wire->attributes.count("\\keep"))
+				for (auto bit : sigmap(RTLIL::SigSpec(wire)).to_sigbit_vector())
+					used_bits.insert(bit);
+		}
+
+		std::vector<RTLIL::SigBit> outputs;
+		for (auto cell : cells) {
+			RTLIL::SigBit bit = port_bit(cell, "\\Y");
+			if (used_bits.count(bit))
+				outputs.push_back(bit);
+		}
+
+		std::vector<int> lits;
+		for (auto bit : outputs)
+			lits.push_back(bit2lit(bit));
+
+		// loop breaking signals are already listed as outputs
+		for (auto &bit : output_bits)
+			aig.add_output(loop_lits.count(bit) ? loop_lits.at(bit) : bit_lits.at(bit));
+
+		for (size_t i = 0; i < outputs.size(); i++) {
+			if (loop_lits.count(outputs[i]))
+				continue;
+			aig.add_output(lits[i]);
+			output_bits.push_back(outputs[i]);
+		}
+	}
+
+	void remove_cells()
+	{
+		for (auto cell : cells) {
+			module->cells.erase(cell->name);
+			delete cell;
+		}
+		cells.clear();
+	}
+
+	void export_cells(RTLIL::Design *design = NULL)
+	{
+		remove_cells();
+
+		std::vector<RTLIL::SigSpec> node_sigs(aig.num_nodes());
+		std::vector<RTLIL::SigSpec> inv_sigs(aig.num_nodes());
+		std::set<RTLIL::SigBit> input_set(input_bits.begin(), input_bits.end());
+
+		for (int i = 0; i < aig.num_inputs(); i++)
+			node_sigs[aig.input_node(i)] = input_bits[i];
+
+		// let the AND nodes drive the output signals directly where possible
+		for (int i = 0; i < aig.num_outputs(); i++) {
+			int lit = aig.output_lit(i);
+			if (!ezAIG::lit_inverted(lit) && aig.is_and(ezAIG::lit_node(lit)) && node_sigs[ezAIG::lit_node(lit)].width == 0 && input_set.count(output_bits[i]) == 0)
+				node_sigs[ezAIG::lit_node(lit)] = output_bits[i];
+		}
+
+		auto lit2sig = [&](int lit) -> RTLIL::SigSpec
+		{
+			int node = ezAIG::lit_node(lit);
+			if (node == 0)
+				return RTLIL::SigSpec(lit == ezAIG::CONST_TRUE ? RTLIL::State::S1 : RTLIL::State::S0);
+			if (!ezAIG::lit_inverted(lit))
+				return node_sigs[node];
+			if (inv_sigs[node].width == 0) {
+				RTLIL::Cell *cell = new RTLIL::Cell;
+				cell->name = NEW_ID;
+				cell->type = "$_INV_";
+				cell->connections["\\A"] = node_sigs[node];
+				cell->connections["\\Y"] = module->new_wire(1, NEW_ID);
+				module->add(cell);
+				if (design)
+					design->select(module, cell);
+				inv_sigs[node] = cell->connections["\\Y"];
+			}
+			return inv_sigs[node];
+		};
+
+		for (int node = 1; node < aig.num_nodes(); node++)
+		{
+			if (!aig.is_and(node))
+				continue;
+			if (node_sigs[node].width == 0)
+				node_sigs[node] = module->new_wire(1, NEW_ID);
+
+			RTLIL::Cell *cell = new RTLIL::Cell;
+			cell->name = NEW_ID;
+			cell->type = "$_AND_";
+			cell->connections["\\A"] = lit2sig(aig.fanin0(node));
+			cell->connections["\\B"] = lit2sig(aig.fanin1(node));
+			cell->connections["\\Y"] = node_sigs[node];
+			module->add(cell);
+			if (design)
+				design->select(module, cell);
+		}
+
+		for (int i = 0; i < aig.num_outputs(); i++) {
+			RTLIL::SigSpec sig = lit2sig(aig.output_lit(i));
+			if (sig != RTLIL::SigSpec(output_bits[i]))
+				module->connections.push_back(RTLIL::SigSig(output_bits[i], sig));
+		}
+	}
+};
+
+#endif
@@ -28,6 +28,7 @@
 #include <algorithm>
 
 int RTLIL::autoidx = 1;
+thread_local int *RTLIL::local_autoidx = NULL;
 
 RTLIL::Const::Const()
 {
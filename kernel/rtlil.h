@@ -58,6 +58,10 @@ namespace RTLIL
 
 	extern int autoidx;
 
+	// worker threads that create objects using NEW_ID point this to a thread
+	// local counter (see passes/techmap/mapbuffer.h) instead of using autoidx
+	extern thread_local int *local_autoidx;
+
 	struct Const;
 	struct Selection;
 	struct Design;
@@ -132,7 +136,7 @@ namespace RTLIL
 		std::string str = "$auto$";
 		size_t pos = file.find_last_of('/');
 		str += pos != std::string::npos ? file.substr(pos+1) : file;
-		str += stringf(":%d:%s$%d", line, func.c_str(), autoidx++);
+		str += stringf(":%d:%s$%d", line, func.c_str(), local_autoidx ? (*local_autoidx)++ : autoidx++);
 		return str;
 	}
 
@@ -658,15 +658,7 @@ struct SatGen
 
 			std::vector<int> yy = model_undef ? ez->vec_var(y.size()) : y;
 
-			std::vector<int> tmp(a.size(), ez->FALSE);
-			for (int i = 0; i < int(a.size()); i++)
-			{
-				std::vector<int> shifted_a(a.size(), ez->FALSE);
-				for (int j = i; j < int(a.size()); j++)
-					shifted_a.at(j) = a.at(j-i);
-				tmp = ez->vec_ite(b.at(i), ez->vec_add(tmp, shifted_a), tmp);
-			}
-			ez->assume(ez->vec_eq(tmp, yy));
+			ez->assume(ez->vec_eq(ez->vec_mul(a, b), yy));
 
 			if (model_undef) {
 				log_assert(arith_undef_handled);
@@ -0,0 +1,665 @@
+/*
+ *  ezAIG -- A small And-Inverter Graph library for logic optimization
+ *
+ *  Copyright (C) 2013  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+// [[CITE]] DAG-aware AIG rewriting
+// Alan Mishchenko, Satrajit Chatterjee, Robert Brayton. "DAG-aware AIG rewriting: A fresh look at
+// combinational logic synthesis", Proceedings of the 43rd Design Automation Conference, 2006
+
+// [[CITE]] Minato-Morreale algorithm for irredundant sum-of-products
+// Shin-ichi Minato. "Fast Generation of Irredundant Sum-of-Products Forms from Binary Decision
+// Diagrams", Proceedings of SASIMI'92, 1992
+
+#include "ezaig.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+#include <assert.h>
+
+const int ezAIG::CONST_FALSE = 0;
+const int ezAIG::CONST_TRUE = 1;
+
+static const uint64_t var_truth_table[6] = {
+	0xaaaaaaaaaaaaaaaaULL, 0xccccccccccccccccULL, 0xf0f0f0f0f0f0f0f0ULL,
+	0xff00ff00ff00ff00ULL, 0xffff0000ffff0000ULL, 0xffffffff00000000ULL
+};
+
+ezAIG::ezAIG()
+{
+	clear();
+}
+
+void ezAIG::clear()
+{
+	nodes.clear();
+	nodes.push_back(node_t{-1, -1});
+	input_nodes.clear();
+	output_lits.clear();
+	hash_table.clear();
+	hash_table.resize(1024);
+	num_and_nodes = 0;
+}
+
+unsigned int ezAIG::node_hash(int fanin0, int fanin1)
+{
+	return (unsigned int)fanin0 * 2654435761u ^ (unsigned int)fanin1 * 40503u;
+}
+
+void ezAIG::rehash(int new_size)
+{
+	hash_table.clear();
+	hash_table.resize(new_size);
+
+	for (int node = 1; node < int(nodes.size()); node++) {
+		if (!is_and(node))
+			continue;
+		int idx = node_hash(nodes[node].fanin0, nodes[node].fanin1) & (new_size - 1);
+		while (hash_table[idx] != 0)
+			idx = (idx + 1) & (new_size - 1);
+		hash_table[idx] = node;
+	}
+}
+
+int ezAIG::add_input()
+{
+	nodes.push_back(node_t{-1, -1});
+	input_nodes.push_back(nodes.size() - 1);
+	return make_lit(nodes.size() - 1);
+}
+
+int ezAIG::add_output(int lit)
+{
+	output_lits.push_back(lit);
+	return output_lits.size() - 1;
+}
+
+int ezAIG::AND(int a, int b)
+{
+	if (a > b)
+		std::swap(a, b);
+
+	if (a == CONST_FALSE)
+		return CONST_FALSE;
+	if (a == CONST_TRUE || a == b)
+		return b;
+	if (a == NOT(b))
+		return CONST_FALSE;
+
+	if (2*(num_and_nodes+1) > int(hash_table.size()))
+		rehash(2*hash_table.size());
+
+	int mask = hash_table.size() - 1;
+	int idx = node_hash(a, b) & mask;
+	while (hash_table[idx] != 0) {
+		const node_t &n = nodes[hash_table[idx]];
+		if (n.fanin0 == a && n.fanin1 == b)
+			return make_lit(hash_table[idx]);
+		idx = (idx + 1) & mask;
+	}
+
+	nodes.push_back(node_t{a, b});
+	hash_table[idx] = nodes.size() - 1;
+	num_and_nodes++;
+	return make_lit(nodes.size() - 1);
+}
+
+void ezAIG::levels(std::vector<int> &node_levels) const
+{
+	node_levels.clear();
+	node_levels.resize(nodes.size());
+	for (int node = 1; node < int(nodes.size()); node++)
+		if (is_and(node))
+			node_levels[node] = 1 + std::max(node_levels[lit_node(nodes[node].fanin0)], node_levels[lit_node(nodes[node].fanin1)]);
+}
+
+int ezAIG::depth() const
+{
+	std::vector<int> node_levels;
+	levels(node_levels);
+
+	int max_level = 0;
+	for (int lit : output_lits)
+		max_level = std::max(max_level, node_levels[lit_node(lit)]);
+	return max_level;
+}
+
+void ezAIG::fanout_counts(std::vector<int> &refs) const
+{
+	refs.clear();
+	refs.resize(nodes.size());
+	for (int node = 1; node < int(nodes.size()); node++)
+		if (is_and(node)) {
+			refs[lit_node(nodes[node].fanin0)]++;
+			refs[lit_node(nodes[node].fanin1)]++;
+		}
+	for (int lit : output_lits)
+		refs[lit_node(lit)]++;
+}
+
+void ezAIG::cleanup()
+{
+	std::vector<bool> used(nodes.size());
+	for (int lit : output_lits)
+		used[lit_node(lit)] = true;
+	for (int node = nodes.size()-1; node > 0; node--)
+		if (used[node] && is_and(node))
+			used[lit_node(nodes[node].fanin0)] = used[lit_node(nodes[node].fanin1)] = true;
+
+	ezAIG new_aig;
+	std::vector<int> node_map(nodes.size());
+	auto map_lit = [&](int lit) { return node_map[lit_node(lit)] ^ (lit & 1); };
+
+	for (int node : input_nodes)
+		node_map[node] = new_aig.add_input();
+	for (int node = 1; node < int(nodes.size()); node++)
+		if (used[node] && is_and(node))
+			node_map[node] = new_aig.AND(map_lit(nodes[node].fanin0), map_lit(nodes[node].fanin1));
+	for (int lit : output_lits)
+		new_aig.add_output(map_lit(lit));
+
+	std::swap(*this, new_aig);
+}
+
+void ezAIG::balance()
+{
+	std::vector<int> refs;
+	fanout_counts(refs);
+
+	// collect the leaves of the multi-input AND trees (super gates) that are needed for the outputs
+	std::vector<bool> needed(nodes.size());
+	std::vector<std::vector<int>> super_gates(nodes.size());
+	for (int lit : output_lits)
+		needed[lit_node(lit)] = true;
+
+	for (int node = nodes.size()-1; node > 0; node--)
+	{
+		if (!needed[node] || !is_and(node))
+			continue;
+
+		std::vector<int> stack = { nodes[node].fanin0, nodes[node].fanin1 };
+		while (!stack.empty()) {
+			int lit = stack.back();
+			stack.pop_back();
+			if (!lit_inverted(lit) && is_and(lit_node(lit)) && refs[lit_node(lit)] == 1) {
+				stack.push_back(nodes[lit_node(lit)].fanin0);
+				stack.push_back(nodes[lit_node(lit)].fanin1);
+			} else
+				super_gates[node].push_back(lit);
+		}
+
+		for (int lit : super_gates[node])
+			needed[lit_node(lit)] = true;
+	}
+
+	// rebuild the super gates, always combining the two inputs with the lowest level
+	ezAIG new_aig;
+	std::vector<int> node_map(nodes.size()), new_levels(1);
+	auto map_lit = [&](int lit) { return node_map[lit_node(lit)] ^ (lit & 1); };
+
+	for (int node : input_nodes) {
+		node_map[node] = new_aig.add_input();
+		new_levels.push_back(0);
+	}
+
+	for (int node = 1; node < int(nodes.size()); node++)
+	{
+		if (!needed[node] || !is_and(node))
+			continue;
+
+		std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<std::pair<int, int>>> queue;
+		for (int lit : super_gates[node]) {
+			int new_lit = map_lit(lit);
+			queue.push(std::pair<int, int>(new_levels[lit_node(new_lit)], new_lit));
+		}
+
+		while (queue.size() > 1) {
+			int a = queue.top().second;
+			queue.pop();
+			int b = queue.top().second;
+			queue.pop();
+			int new_lit = new_aig.AND(a, b);
+			if (lit_node(new_lit) == int(new_levels.size()))
+				new_levels.push_back(1 + std::max(new_levels[lit_node(a)], new_levels[lit_node(b)]));
+			queue.push(std::pair<int, int>(new_levels[lit_node(new_lit)], new_lit));
+		}
+
+		node_map[node] = queue.top().second;
+	}
+
+	for (int lit : output_lits)
+		new_aig.add_output(map_lit(lit));
+
+	new_aig.cleanup();
+	std::swap(*this, new_aig);
+}
+
+bool ezAIG::rewrite(int cut_size, int max_cuts)
+{
+	std::vector<std::vector<Cut>> cuts;
+	enumerate_cuts(cuts, cut_size, max_cuts);
+
+	std::vector<int> refs;
+	fanout_counts(refs);
+
+	// replaced[node] is the index of the cut that is used to re-implement the node, or -1
+	std::vector<int> replaced(nodes.size(), -1);
+
+	auto is_leaf = [](const Cut &cut, int node) {
+		for (int i = 0; i < cut.size; i++)
+			if (cut.leaves[i] == node)
+				return true;
+		return false;
+	};
+
+	// (de-)reference the cone of a node down to the cut leaves. the fanins of a
+	// node that is already scheduled for replacement are the leaves of its cut.
+	std::function<int(int, const Cut&, int)> update_refs = [&](int node, const Cut &cut, int delta) -> int
+	{
+		int count = 1;
+		int fanins[6], num_fanins = 0;
+
+		if (replaced[node] >= 0) {
+			const Cut &repl_cut = cuts[node][replaced[node]];
+			for (int i = 0; i < repl_cut.size; i++)
+				fanins[num_fanins++] = repl_cut.leaves[i];
+		} else {
+			fanins[num_fanins++] = lit_node(nodes[node].fanin0);
+			fanins[num_fanins++] = lit_node(nodes[node].fanin1);
+		}
+
+		for (int i = 0; i < num_fanins; i++) {
+			int fanin = fanins[i];
+			if (delta < 0 ? --refs[fanin] == 0 : refs[fanin]++ == 0)
+				if (is_and(fanin) && !is_leaf(cut, fanin))
+					count += update_refs(fanin, cut, delta);
+		}
+		return count;
+	};
+
+	for (int node = 1; node < int(nodes.size()); node++)
+	{
+		if (!is_and(node) || refs[node] == 0)
+			continue;
+
+		int best_gain = 0, best_cut = -1;
+		for (int i = 0; i < int(cuts[node].size()); i++)
+		{
+			const Cut &cut = cuts[node][i];
+			if (cut.size == 1 && cut.leaves[0] == node)
+				continue;
+
+			bool dead_leaf = false;
+			for (int j = 0; j < cut.size; j++)
+				if (is_and(cut.leaves[j]) && refs[cut.leaves[j]] == 0)
+					dead_leaf = true;
+			if (dead_leaf)
+				continue;
+
+			int mffc_size = update_refs(node, cut, -1);
+			update_refs(node, cut, +1);
+
+			int gain = mffc_size - synthesize_cost(cut.truth, cut.size);
+			if (gain > best_gain)
+				best_gain = gain, best_cut = i;
+		}
+
+		if (best_cut >= 0) {
+			const Cut &cut = cuts[node][best_cut];
+			update_refs(node, cut, -1);
+			replaced[node] = best_cut;
+			for (int j = 0; j < cut.size; j++)
+				refs[cut.leaves[j]]++;
+		}
+	}
+
+	// rebuild the graph using the new implementations
+	std::vector<bool> needed(nodes.size());
+	for (int lit : output_lits)
+		needed[lit_node(lit)] = true;
+	for (int node = nodes.size()-1; node > 0; node--) {
+		if (!needed[node] || !is_and(node))
+			continue;
+		if (replaced[node] >= 0) {
+			const Cut &cut = cuts[node][replaced[node]];
+			for (int j = 0; j < cut.size; j++)
+				needed[cut.leaves[j]] = true;
+		} else
+			needed[lit_node(nodes[node].fanin0)] = needed[lit_node(nodes[node].fanin1)] = true;
+	}
+
+	ezAIG new_aig;
+	std::vector<int> node_map(nodes.size());
+	auto map_lit = [&](int lit) { return node_map[lit_node(lit)] ^ (lit & 1); };
+
+	for (int node : input_nodes)
+		node_map[node] = new_aig.add_input();
+
+	for (int node = 1; node < int(nodes.size()); node++) {
+		if (!needed[node] || !is_and(node))
+			continue;
+		if (replaced[node] >= 0) {
+			const Cut &cut = cuts[node][replaced[node]];
+			int leaf_lits[6];
+			for (int j = 0; j < cut.size; j++)
+				leaf_lits[j] = node_map[cut.leaves[j]];
+			node_map[node] = new_aig.synthesize(cut.truth, cut.size, leaf_lits);
+		} else
+			node_map[node] = new_aig.AND(map_lit(nodes[node].fanin0), map_lit(nodes[node].fanin1));
+	}
+
+	for (int lit : output_lits)
+		new_aig.add_output(map_lit(lit));
+	new_aig.cleanup();
+
+	if (new_aig.num_ands() >= num_ands())
+		return false;
+
+	std::swap(*this, new_aig);
+	return true;
+}
+
+void ezAIG::enumerate_cuts(std::vector<std::vector<Cut>> &cuts, int cut_size, int max_cuts) const
+{
+	assert(cut_size >= 1 && cut_size <= 6 && max_cuts >= 2);
+
+	cuts.clear();
+	cuts.resize(nodes.size());
+
+	Cut const_cut;
+	const_cut.size = 0;
+	const_cut.truth = 0;
+	cuts[0].push_back(const_cut);
+
+	for (int node = 1; node < int(nodes.size()); node++)
+	{
+		Cut trivial_cut;
+		trivial_cut.size = 1;
+		trivial_cut.leaves[0] = node;
+		trivial_cut.truth = var_truth(0);
+
+		if (!is_and(node)) {
+			cuts[node].push_back(trivial_cut);
+			continue;
+		}
+
+		int lit0 = nodes[node].fanin0, lit1 = nodes[node].fanin1;
+		std::vector<Cut> &node_cuts = cuts[node];
+
+		for (auto &cut0 : cuts[lit_node(lit0)])
+		for (auto &cut1 : cuts[lit_node(lit1)])
+		{
+			Cut cut;
+			cut.size = 0;
+
+			int i = 0, j = 0;
+			while (i < cut0.size || j < cut1.size) {
+				int leaf;
+				if (j == cut1.size || (i < cut0.size && cut0.leaves[i] < cut1.leaves[j]))
+					leaf = cut0.leaves[i++];
+				else if (i == cut0.size || cut1.leaves[j] < cut0.leaves[i])
+					leaf = cut1.leaves[j++];
+				else
+					leaf = cut0.leaves[i++], j++;
+				if (cut.size == cut_size)
+					goto next_pair;
+				cut.leaves[cut.size++] = leaf;
+			}
+
+			{
+				uint64_t truth0 = truth_stretch(cut0.truth, cut0.leaves, cut0.size, cut.leaves, cut.size);
+				uint64_t truth1 = truth_stretch(cut1.truth, cut1.leaves, cut1.size, cut.leaves, cut.size);
+				cut.truth = (lit_inverted(lit0) ? ~truth0 : truth0) & (lit_inverted(lit1) ? ~truth1 : truth1);
+			}
+
+			for (int k = cut.size-1; k >= 0; k--)
+				if (!truth_depends_on(cut.truth, k)) {
+					cut.truth = truth_remove_var(cut.truth, k, cut.size);
+					for (int l = k; l+1 < cut.size; l++)
+						cut.leaves[l] = cut.leaves[l+1];
+					cut.size--;
+				}
+
+			// skip the new cut if it is dominated by an existing cut and remove existing cuts dominated by the new cut
+			for (int k = 0; k < int(node_cuts.size()); k++) {
+				const Cut &other = node_cuts[k];
+				if (other.size <= cut.size && std::includes(cut.leaves, cut.leaves + cut.size, other.leaves, other.leaves + other.size))
+					goto next_pair;
+				if (cut.size < other.size && std::includes(other.leaves, other.leaves + other.size, cut.leaves, cut.leaves + cut.size))
+					node_cuts.erase(node_cuts.begin() + (k--));
+			}
+
+			node_cuts.push_back(cut);
+		next_pair:;
+		}
+
+		std::stable_sort(node_cuts.begin(), node_cuts.end(), [](const Cut &a, const Cut &b) { return a.size < b.size; });
+		if (int(node_cuts.size()) > max_cuts-1)
+			node_cuts.resize(max_cuts-1);
+
+		if (node_cuts.empty() || node_cuts.back().size != 1 || node_cuts.back().leaves[0] != node)
+			node_cuts.push_back(trivial_cut);
+	}
+}
+
+uint64_t ezAIG::isop(uint64_t lower, uint64_t upper, int num_vars, std::vector<cube_t> &cubes)
+{
+	if (lower == 0)
+		return 0;
+
+	if (upper == ~uint64_t(0)) {
+		cubes.push_back(cube_t{0, 0});
+		return ~uint64_t(0);
+	}
+
+	int var = num_vars - 1;
+	while (var >= 0 && !truth_depends_on(lower, var) && !truth_depends_on(upper, var))
+		var--;
+	assert(var >= 0);
+
+	uint64_t mask = var_truth(var);
+	int shift = 1 << var;
+
+	uint64_t lower0 = (lower & ~mask) | ((lower & ~mask) << shift);
+	uint64_t lower1 = (lower & mask) | ((lower & mask) >> shift);
+	uint64_t upper0 = (upper & ~mask) | ((upper & ~mask) << shift);
+	uint64_t upper1 = (upper & mask) | ((upper & mask) >> shift);
+
+	size_t begin0 = cubes.size();
+	uint64_t cover0 = isop(lower0 & ~upper1, upper0, var, cubes);
+	for (size_t i = begin0; i < cubes.size(); i++)
+		cubes[i].neg |= 1 << var;
+
+	size_t begin1 = cubes.size();
+	uint64_t cover1 = isop(lower1 & ~upper0, upper1, var, cubes);
+	for (size_t i = begin1; i < cubes.size(); i++)
+		cubes[i].pos |= 1 << var;
+
+	uint64_t cover_star = isop((lower0 & ~cover0) | (lower1 & ~cover1), upper0 & upper1, var, cubes);
+	return (cover0 & ~mask) | (cover1 & mask) | cover_star;
+}
+
+int ezAIG::factor(const std::vector<cube_t> &cubes, const int *leaf_lits, int &cost, bool build)
+{
+	if (cubes.empty())
+		return CONST_FALSE;
+
+	for (auto &cube : cubes)
+		if (cube.pos == 0 && cube.neg == 0)
+			return CONST_TRUE;
+
+	// find the literal that is used in the largest number of cubes
+	int best_count = 0, best_var = -1;
+	bool best_pos = false;
+	for (int var = 0; var < 6; var++) {
+		int pos_count = 0, neg_count = 0;
+		for (auto &cube : cubes) {
+			pos_count += (cube.pos >> var) & 1;
+			neg_count += (cube.neg >> var) & 1;
+		}
+		if (pos_count > best_count)
+			best_count = pos_count, best_var = var, best_pos = true;
+		if (neg_count > best_count)
+			best_count = neg_count, best_var = var, best_pos = false;
+	}
+
+	if (best_count >= 2 || cubes.size() == 1)
+	{
+		// f = lit * quotient + remainder
+		std::vector<cube_t> quotient, remainder;
+		for (auto &cube : cubes) {
+			if (((best_pos ? cube.pos : cube.neg) >> best_var) & 1) {
+				cube_t new_cube = cube;
+				(best_pos ? new_cube.pos : new_cube.neg) &= ~(1 << best_var);
+				quotient.push_back(new_cube);
+			} else
+				remainder.push_back(cube);
+		}
+
+		int lit = build ? (best_pos ? leaf_lits[best_var] : NOT(leaf_lits[best_var])) : 0;
+		int quotient_lit = factor(quotient, leaf_lits, cost, build);
+		int result = lit;
+		if (quotient_lit != CONST_TRUE) {
+			cost++;
+			if (build)
+				result = AND(lit, quotient_lit);
+		}
+
+		if (!remainder.empty()) {
+			int remainder_lit = factor(remainder, leaf_lits, cost, build);
+			cost++;
+			if (build)
+				result = OR(result, remainder_lit);
+		}
+
+		return result;
+	}
+
+	// no shared literals: plain sum of products
+	int result = CONST_FALSE;
+	for (size_t i = 0; i < cubes.size(); i++) {
+		int cube_lit = CONST_TRUE, num_lits = 0;
+		for (int var = 0; var < 6; var++) {
+			if ((cubes[i].pos >> var) & 1)
+				num_lits++, cube_lit = build ? AND(cube_lit, leaf_lits[var]) : 0;
+			if ((cubes[i].neg >> var) & 1)
+				num_lits++, cube_lit = build ? AND(cube_lit, NOT(leaf_lits[var])) : 0;
+		}
+		cost += num_lits - 1 + (i > 0 ? 1 : 0);
+		if (build)
+			result = OR(result, cube_lit);
+	}
+	return result;
+}
+
+int ezAIG::synthesize(uint64_t truth, int num_vars, const int *leaf_lits)
+{
+	std::vector<cube_t> on_cubes, off_cubes;
+	int on_cost = 0, off_cost = 0;
+
+	isop(truth, truth, num_vars, on_cubes);
+	factor(on_cubes, leaf_lits, on_cost, false);
+
+	isop(~truth, ~truth, num_vars, off_cubes);
+	factor(off_cubes, leaf_lits, off_cost, false);
+
+	if (off_cost < on_cost)
+		return NOT(factor(off_cubes, leaf_lits, off_cost, true));
+	return factor(on_cubes, leaf_lits, on_cost, true);
+}
+
+int ezAIG::synthesize_cost(uint64_t truth, int num_vars)
+{
+	std::vector<cube_t> on_cubes, off_cubes;
+	int on_cost = 0, off_cost = 0;
+
+	isop(truth, truth, num_vars, on_cubes);
+	factor(on_cubes, NULL, on_cost, false);
+
+	isop(~truth, ~truth, num_vars, off_cubes);
+	factor(off_cubes, NULL, off_cost, false);
+
+	return std::min(on_cost, off_cost);
+}
+
+uint64_t ezAIG::var_truth(int var)
+{
+	return var_truth_table[var];
+}
+
+bool ezAIG::truth_depends_on(uint64_t truth, int var)
+{
+	uint64_t mask = var_truth(var);
+	return ((truth >> (1 << var)) & ~mask) != (truth & ~mask);
+}
+
+uint64_t ezAIG::truth_stretch(uint64_t truth, const int *from_leaves, int from_size, const int *to_leaves, int to_size)
+{
+	int positions[6];
+	for (int i = 0, j = 0; i < from_size; i++) {
+		while (to_leaves[j] != from_leaves[i])
+			j++, assert(j < to_size);
+		positions[i] = j;
+	}
+
+	uint64_t result = 0;
+	for (int m = 0; m < 64; m++) {
+		int index = 0;
+		for (int i = 0; i < from_size; i++)
+			index |= ((m >> positions[i]) & 1) << i;
+		result |= ((truth >> index) & 1) << m;
+	}
+	return result;
+}
+
+uint64_t ezAIG::truth_remove_var(uint64_t truth, int var, int num_vars)
+{
+	int new_vars = num_vars - 1;
+	uint64_t result = 0;
+
+	for (int m = 0; m < (1 << new_vars); m++) {
+		int old_m = (m & ((1 << var) - 1)) | ((m >> var) << (var + 1));
+		result |= ((truth >> old_m) & 1) << m;
+	}
+
+	for (int width = 1 << new_vars; width < 64; width *= 2)
+		result |= result << width;
+	return result;
+}
+
+void ezAIG::simulate(const std::vector<uint64_t> &input_patterns, std::vector<uint64_t> &output_patterns) const
+{
+	std::vector<uint64_t> values(nodes.size());
+	auto lit_value = [&](int lit) { return lit_inverted(lit) ? ~values[lit_node(lit)] : values[lit_node(lit)]; };
+
+	for (int i = 0; i < int(input_nodes.size()); i++)
+		values[input_nodes[i]] = input_patterns.at(i);
+	for (int node = 1; node < int(nodes.size()); node++)
+		if (is_and(node))
+			values[node] = lit_value(nodes[node].fanin0) & lit_value(nodes[node].fanin1);
+
+	output_patterns.clear();
+	for (int lit : output_lits)
+		output_patterns.push_back(lit_value(lit));
+}
+
+void ezAIG::print_stats(FILE *f) const
+{
+	fprintf(f, "inputs=%d outputs=%d and_nodes=%d depth=%d\n", num_inputs(), num_outputs(), num_ands(), depth());
+}
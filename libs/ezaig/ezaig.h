@@ -0,0 +1,145 @@
+/*
+ *  ezAIG -- A small And-Inverter Graph library for logic optimization
+ *
+ *  Copyright (C) 2013  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef EZAIG_H
+#define EZAIG_H
+
+#include <vector>
+#include <stdio.h>
+#include <stdint.h>
+
+class ezAIG
+{
+	// the graph is a list of nodes in topological order. node 0 is the constant
+	// false node, all other nodes are either primary inputs or two-input AND
+	// gates. edges are literals: 2*node for the node itself and 2*node+1 for
+	// the inverted node. so literal 0 is constant false and 1 is constant true.
+	//
+	// AND nodes are structurally hashed: an open addressing hash table (linear
+	// probing, 0 = empty slot, otherwise the node index) is used to find an
+	// existing node with the same (normalized) fanins.
+
+public:
+	static const int CONST_FALSE;
+	static const int CONST_TRUE;
+
+	// a k-feasible cut with k <= 6, the truth table is over the leaves in the
+	// order given (leaf i = variable i) and uses the 64 bit encoding where bit
+	// m is the function value for the minterm m.
+	struct Cut {
+		int size;
+		int leaves[6];
+		uint64_t truth;
+	};
+
+private:
+	struct node_t {
+		int fanin0, fanin1;
+	};
+
+	std::vector<node_t> nodes;
+	std::vector<int> input_nodes, output_lits;
+	std::vector<int> hash_table;
+	int num_and_nodes;
+
+	static unsigned int node_hash(int fanin0, int fanin1);
+	void rehash(int new_size);
+
+	// helper functions for building logic from truth tables
+	struct cube_t {
+		int pos, neg;
+	};
+	static uint64_t isop(uint64_t lower, uint64_t upper, int num_vars, std::vector<cube_t> &cubes);
+	int factor(const std::vector<cube_t> &cubes, const int *leaf_lits, int &cost, bool build);
+
+public:
+	ezAIG();
+	void clear();
+
+	static int NOT(int lit) { return lit ^ 1; }
+	static int lit_node(int lit) { return lit >> 1; }
+	static bool lit_inverted(int lit) { return (lit & 1) != 0; }
+	static int make_lit(int node, bool inverted = false) { return 2*node + (inverted ? 1 : 0); }
+
+	int add_input();
+	int add_output(int lit);
+	void set_output(int index, int lit) { output_lits.at(index) = lit; }
+
+	int AND(int a, int b);
+	int OR(int a, int b) { return NOT(AND(NOT(a), NOT(b))); }
+	int XOR(int a, int b) { return OR(AND(a, NOT(b)), AND(NOT(a), b)); }
+	int MUX(int s, int a, int b) { return OR(AND(NOT(s), a), AND(s, b)); }
+
+	int num_nodes() const { return nodes.size(); }
+	int num_inputs() const { return input_nodes.size(); }
+	int num_outputs() const { return output_lits.size(); }
+	int num_ands() const { return num_and_nodes; }
+
+	bool is_and(int node) const { return nodes[node].fanin0 >= 0; }
+	bool is_input(int node) const { return node > 0 && nodes[node].fanin0 < 0; }
+	int fanin0(int node) const { return nodes[node].fanin0; }
+	int fanin1(int node) const { return nodes[node].fanin1; }
+	int input_node(int index) const { return input_nodes.at(index); }
+	int output_lit(int index) const { return output_lits.at(index); }
+
+	// the node levels (inputs and constants have level 0) and the maximum level of an output
+	void levels(std::vector<int> &node_levels) const;
+	int depth() const;
+
+	// the number of references to each node from AND nodes and outputs
+	void fanout_counts(std::vector<int> &refs) const;
+
+	// the graph transformations replace the graph with an equivalent graph that
+	// has the same inputs and outputs (with the same indices).
+	//
+	// cleanup() removes all nodes that do not drive an output, balance() rebuilds
+	// all multi-input AND trees (of single-fanout AND nodes) with minimum depth and
+	// rewrite() replaces cones by smaller implementations of their cut functions,
+	// using the size of the maximum fanout-free cone to account for shared logic.
+	// rewrite() returns false (and does not change the graph) if it can not find
+	// an improvement.
+	void cleanup();
+	void balance();
+	bool rewrite(int cut_size = 4, int max_cuts = 8);
+
+	// enumerate up to max_cuts k-feasible cuts for each node (with k = cut_size <= 6).
+	// the trivial cut of a node is always the last cut in its list. cuts are stored
+	// with the smallest possible support, i.e. leaves the function does not depend on
+	// are removed.
+	void enumerate_cuts(std::vector<std::vector<Cut>> &cuts, int cut_size, int max_cuts) const;
+
+	// build an implementation of the truth table over the given leaf literals. the
+	// estimated number of new AND nodes (without considering structural hashing) can
+	// be obtained with synthesize_cost() without modifying the graph.
+	int synthesize(uint64_t truth, int num_vars, const int *leaf_lits);
+	int synthesize_cost(uint64_t truth, int num_vars);
+
+	// helper functions for 64 bit truth tables
+	static uint64_t var_truth(int var);
+	static bool truth_depends_on(uint64_t truth, int var);
+	static uint64_t truth_stretch(uint64_t truth, const int *from_leaves, int from_size, const int *to_leaves, int to_size);
+	static uint64_t truth_remove_var(uint64_t truth, int var, int num_vars);
+
+	// evaluate the outputs for 64 parallel input patterns
+	void simulate(const std::vector<uint64_t> &input_patterns, std::vector<uint64_t> &output_patterns) const;
+
+	void print_stats(FILE *f) const;
+};
+
+#endif
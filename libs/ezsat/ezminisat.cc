@@ -25,8 +25,12 @@
 
 #include <limits.h>
 #include <stdint.h>
-#include <csignal>
+#include <time.h>
 #include <cinttypes>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <pthread.h>
 
 #ifdef _YOSYS_
 #  include "libs/minisat/Solver.h"
@@ -40,6 +44,7 @@ ezMiniSAT::ezMiniSAT() : minisatSolver(NULL)
 {
 	minisatSolver = NULL;
 	foundContradiction = false;
+	portfolioSize = 1;
 
 	freeze(TRUE);
 	freeze(FALSE);
@@ -49,6 +54,8 @@ ezMiniSAT::~ezMiniSAT()
 {
 	if (minisatSolver != NULL)
 		delete minisatSolver;
+	for (auto solver : minisatPortfolio)
+		delete solver;
 }
 
 void ezMiniSAT::clear()
@@ -57,6 +64,9 @@ void ezMiniSAT::clear()
 		delete minisatSolver;
 		minisatSolver = NULL;
 	}
+	for (auto solver : minisatPortfolio)
+		delete solver;
+	minisatPortfolio.clear();
 	foundContradiction = false;
 	minisatVars.clear();
 #if EZMINISAT_SIMPSOLVER && EZMINISAT_INCREMENTAL
@@ -74,22 +84,111 @@ void ezMiniSAT::freeze(int id)
 bool ezMiniSAT::eliminated(int idx)
 {
 	idx = idx < 0 ? -idx : idx;
-	if (minisatSolver != NULL && idx > 0 && idx <= int(minisatVars.size()))
-		return minisatSolver->isEliminated(minisatVars.at(idx-1));
+	if (minisatSolver != NULL && idx > 0 && idx <= int(minisatVars.size())) {
+		if (minisatSolver->isEliminated(minisatVars.at(idx-1)))
+			return true;
+		for (auto solver : minisatPortfolio)
+			if (solver->isEliminated(minisatVars.at(idx-1)))
+				return true;
+	}
 	return false;
 }
 #endif
 
-ezMiniSAT *ezMiniSAT::alarmHandlerThis = NULL;
-clock_t ezMiniSAT::alarmHandlerTimeout = 0;
+static double solverClock(clockid_t clk)
+{
+	struct timespec ts;
+	clock_gettime(clk, &ts);
+	return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+struct solverTimeBudget
+{
+	const ezSAT *ez;
+	clockid_t cpuClock;
+	double startCpu, startWall;
+	bool timedOut;
+};
 
-void ezMiniSAT::alarmHandler(int)
+static bool solverTimeCallback(void *data)
 {
-	if (clock() > alarmHandlerTimeout) {
-		alarmHandlerThis->minisatSolver->interrupt();
-		alarmHandlerTimeout = 0;
-	} else
-		alarm(1);
+	solverTimeBudget *tb = (solverTimeBudget*)data;
+	if (tb->ez->solverTimeout > 0 && solverClock(tb->cpuClock) - tb->startCpu >= tb->ez->solverTimeout)
+		tb->timedOut = true;
+	if (tb->ez->solverWallTimeout > 0 && solverClock(CLOCK_MONOTONIC) - tb->startWall >= tb->ez->solverWallTimeout)
+		tb->timedOut = true;
+	return tb->timedOut;
+}
+
+// Run the solver once with the conflict and propagation budgets of the
+// ezSAT object. Time budgets are checked cooperatively from MiniSat's search
+// loop (see libs/minisat/00_PATCH_termCallback.patch), so MiniSat's restart
+// and clause database schedules are not disturbed. Nothing here is
+// process-wide (no signals, no statics), so any number of solver instances
+// can do this concurrently. Returns l_Undef if a budget was exhausted or if
+// the solver was interrupted by someone else. The caller must clear the
+// interrupt flag of the solver afterwards.
+
+template<typename SolverType>
+static Minisat::lbool solveWithBudget(SolverType *solver, const Minisat::vec<Minisat::Lit> &assumps, const ezSAT *ez, bool &budgetExhausted)
+{
+	budgetExhausted = false;
+
+	int64_t startConflicts = solver->conflicts;
+	int64_t startPropagations = solver->propagations;
+
+	solver->budgetOff();
+	if (ez->solverConflictBudget > 0)
+		solver->setConfBudget(ez->solverConflictBudget);
+	if (ez->solverPropagationBudget > 0)
+		solver->setPropBudget(ez->solverPropagationBudget);
+
+	solverTimeBudget tb;
+	tb.ez = ez;
+	tb.timedOut = false;
+
+	if (ez->solverTimeout > 0 || ez->solverWallTimeout > 0)
+	{
+		// the CPU time of the solving thread is measured, so that portfolio
+		// threads and other concurrent instances have independent deadlines
+		if (pthread_getcpuclockid(pthread_self(), &tb.cpuClock) != 0)
+			tb.cpuClock = CLOCK_PROCESS_CPUTIME_ID;
+		tb.startCpu = solverClock(tb.cpuClock);
+		tb.startWall = solverClock(CLOCK_MONOTONIC);
+		solver->setTermCallback(solverTimeCallback, &tb);
+	}
+
+	Minisat::lbool result = solver->solveLimited(assumps);
+
+	solver->setTermCallback(NULL, NULL);
+	solver->budgetOff();
+
+	if (result == Minisat::l_Undef) {
+		if (tb.timedOut)
+			budgetExhausted = true;
+		if (ez->solverConflictBudget > 0 && int64_t(solver->conflicts - startConflicts) >= ez->solverConflictBudget)
+			budgetExhausted = true;
+		if (ez->solverPropagationBudget > 0 && int64_t(solver->propagations - startPropagations) >= ez->solverPropagationBudget)
+			budgetExhausted = true;
+	}
+
+	return result;
+}
+
+void ezMiniSAT::configurePortfolioSolver(Solver *solver, int index)
+{
+	// instance 0 keeps the default configuration, the others differ in
+	// random seed, initial activities, restart policy and (for the simp
+	// solver) whether variable elimination is performed.
+
+	solver->random_seed = 91648253 + 7919 * index;
+	solver->rnd_init_act = (index % 2) == 1;
+	solver->luby_restart = (index % 3) != 2;
+	solver->restart_first = 100 << (index % 4);
+	solver->random_var_freq = (index % 4) == 3 ? 0.02 : 0;
+#if EZMINISAT_SIMPSOLVER
+	solver->use_elim = (index % 2) == 0;
+#endif
 }
 
 bool ezMiniSAT::solver(const std::vector<int> &modelExpressions, std::vector<bool> &modelValues, const std::vector<int> &assumptions)
@@ -100,6 +199,9 @@ bool ezMiniSAT::solver(const std::vector<int> &modelExpressions, std::vector<boo
 contradiction:
 		delete minisatSolver;
 		minisatSolver = NULL;
+		for (auto solver : minisatPortfolio)
+			delete solver;
+		minisatPortfolio.clear();
 		minisatVars.clear();
 		foundContradiction = true;
 		return false;
@@ -120,8 +222,19 @@ contradiction:
 	if (minisatSolver == NULL) {
 		minisatSolver = new Solver;
 		minisatSolver->verbosity = EZMINISAT_VERBOSITY;
+		for (int i = 1; i < portfolioSize; i++) {
+			minisatPortfolio.push_back(new Solver);
+			minisatPortfolio.back()->verbosity = EZMINISAT_VERBOSITY;
+			configurePortfolioSolver(minisatPortfolio.back(), i);
+		}
 	}
 
+	// all portfolio instances see the same sequence of newVar() calls,
+	// thus the same minisatVars mapping is valid for all of them.
+	std::vector<Solver*> allSolvers;
+	allSolvers.push_back(minisatSolver);
+	allSolvers.insert(allSolvers.end(), minisatPortfolio.begin(), minisatPortfolio.end());
+
 #if EZMINISAT_INCREMENTAL
 	std::vector<std::vector<int>> cnf;
 	consumeCnf(cnf);
@@ -129,12 +242,16 @@ contradiction:
 	const std::vector<std::vector<int>> &cnf = this->cnf();
 #endif
 
-	while (int(minisatVars.size()) < numCnfVariables())
+	while (int(minisatVars.size()) < numCnfVariables()) {
 		minisatVars.push_back(minisatSolver->newVar());
+		for (auto solver : minisatPortfolio)
+			solver->newVar();
+	}
 
 #if EZMINISAT_SIMPSOLVER && EZMINISAT_INCREMENTAL
 	for (auto idx : cnfFrozenVars)
-		minisatSolver->setFrozen(minisatVars.at(idx > 0 ? idx-1 : -idx-1), true);
+		for (auto solver : allSolvers)
+			solver->setFrozen(minisatVars.at(idx > 0 ? idx-1 : -idx-1), true);
 	cnfFrozenVars.clear();
 #endif
 
@@ -146,19 +263,25 @@ contradiction:
 			else
 				ps.push(Minisat::mkLit(minisatVars.at(-idx-1), true));
 #if EZMINISAT_SIMPSOLVER
-			if (minisatSolver->isEliminated(minisatVars.at(idx > 0 ? idx-1 : -idx-1))) {
+			if (eliminated(idx)) {
 				fprintf(stderr, "Assert in %s:%d failed! Missing call to ezsat->freeze(): %s (lit=%d)\n",
 						__FILE__, __LINE__, cnfLiteralInfo(idx).c_str(), idx);
 				abort();
 			}
 #endif
 		}
-		if (!minisatSolver->addClause(ps))
-			goto contradiction;
+		for (auto solver : allSolvers) {
+			Minisat::vec<Minisat::Lit> ps_copy;
+			ps.copyTo(ps_copy);
+			if (!solver->addClause(ps_copy))
+				goto contradiction;
+		}
 	}
 
-	if (cnf.size() > 0 && !minisatSolver->simplify())
-		goto contradiction;
+	if (cnf.size() > 0)
+		for (auto solver : allSolvers)
+			if (!solver->simplify())
+				goto contradiction;
 
 	Minisat::vec<Minisat::Lit> assumps;
 
@@ -168,42 +291,72 @@ contradiction:
 		else
 			assumps.push(Minisat::mkLit(minisatVars.at(-idx-1), true));
 #if EZMINISAT_SIMPSOLVER
-		if (minisatSolver->isEliminated(minisatVars.at(idx > 0 ? idx-1 : -idx-1))) {
+		if (eliminated(idx)) {
 			fprintf(stderr, "Assert in %s:%d failed! Missing call to ezsat->freeze(): %s\n", __FILE__, __LINE__, cnfLiteralInfo(idx).c_str());
 			abort();
 		}
 #endif
 	}
 
-	struct sigaction sig_action;
-	struct sigaction old_sig_action;
-	int old_alarm_timeout = 0;
-
-	if (solverTimeout > 0) {
-		sig_action.sa_handler = alarmHandler;
-		sigemptyset(&sig_action.sa_mask);
-		sig_action.sa_flags = SA_RESTART;
-		alarmHandlerThis = this;
-		alarmHandlerTimeout = clock() + solverTimeout*CLOCKS_PER_SEC;
-		old_alarm_timeout = alarm(0);
-		sigaction(SIGALRM, &sig_action, &old_sig_action);
-		alarm(1);
+	bool foundSolution = false;
+	Solver *modelSolver = minisatSolver;
+
+	if (minisatPortfolio.empty())
+	{
+		bool budgetExhausted;
+		foundSolution = solveWithBudget(minisatSolver, assumps, this, budgetExhausted) == Minisat::l_True;
+		minisatSolver->clearInterrupt();
+		if (budgetExhausted)
+			solverTimoutStatus = true;
 	}
+	else
+	{
+		// run all instances in parallel, each one with its own budget. the first
+		// instance that returns a definite answer stops the others.
+		std::mutex winnerMutex;
+		Solver *winner = NULL;
+		Minisat::lbool winnerResult = Minisat::l_Undef;
+
+		auto worker = [&](Solver *solver) {
+			bool budgetExhausted;
+			Minisat::lbool result = solveWithBudget(solver, assumps, this, budgetExhausted);
+			std::lock_guard<std::mutex> lock(winnerMutex);
+			if (winner == NULL && result != Minisat::l_Undef) {
+				winner = solver;
+				winnerResult = result;
+				for (auto other : allSolvers)
+					if (other != solver)
+						other->interrupt();
+			}
+		};
+
+		for (auto solver : allSolvers)
+			solver->clearInterrupt();
+
+		std::vector<std::thread> threads;
+		for (auto solver : minisatPortfolio)
+			threads.push_back(std::thread(worker, solver));
+		worker(minisatSolver);
+		for (auto &t : threads)
+			t.join();
 
-	bool foundSolution = minisatSolver->solve(assumps);
+		for (auto solver : allSolvers)
+			solver->clearInterrupt();
 
-	if (solverTimeout > 0) {
-		if (alarmHandlerTimeout == 0)
+		if (winner != NULL) {
+			foundSolution = winnerResult == Minisat::l_True;
+			modelSolver = winner;
+		} else
 			solverTimoutStatus = true;
-		alarm(0);
-		sigaction(SIGALRM, &old_sig_action, NULL);
-		alarm(old_alarm_timeout);
 	}
 
 	if (!foundSolution) {
 #if !EZMINISAT_INCREMENTAL
 		delete minisatSolver;
 		minisatSolver = NULL;
+		for (auto solver : minisatPortfolio)
+			delete solver;
+		minisatPortfolio.clear();
 		minisatVars.clear();
 #endif
 		return false;
@@ -221,13 +374,16 @@ contradiction:
 			idx = -idx, refvalue = false;
 
 		using namespace Minisat;
-		lbool value = minisatSolver->modelValue(minisatVars.at(idx-1));
+		lbool value = modelSolver->modelValue(minisatVars.at(idx-1));
 		modelValues[i] = (value == Minisat::lbool(refvalue));
 	}
 
 #if !EZMINISAT_INCREMENTAL
 	delete minisatSolver;
 	minisatSolver = NULL;
+	for (auto solver : minisatPortfolio)
+		delete solver;
+	minisatPortfolio.clear();
 	minisatVars.clear();
 #endif
 	return true;
@@ -25,7 +25,6 @@
 #define EZMINISAT_INCREMENTAL 1
 
 #include "ezsat.h"
-#include <time.h>
 
 // minisat is using limit macros and format macros in their headers that
 // can be the source of some troubles when used from c++11. thefore we
@@ -44,6 +43,7 @@ private:
 	typedef Minisat::Solver Solver;
 #endif
 	Solver *minisatSolver;
+	std::vector<Solver*> minisatPortfolio;
 	std::vector<int> minisatVars;
 	bool foundContradiction;
 
@@ -51,11 +51,14 @@ private:
 	std::set<int> cnfFrozenVars;
 #endif
 
-	static ezMiniSAT *alarmHandlerThis;
-	static clock_t alarmHandlerTimeout;
-	static void alarmHandler(int);
+	static void configurePortfolioSolver(Solver *solver, int index);
 
 public:
+	// number of diversified solver instances that are run in parallel
+	// threads on the same CNF (the first one to find an answer wins).
+	// must be set before the first call to solve().
+	int portfolioSize;
+
 	ezMiniSAT();
 	virtual ~ezMiniSAT();
 	virtual void clear();
@@ -64,6 +67,10 @@ public:
 	virtual bool eliminated(int idx);
 #endif
 	virtual bool solver(const std::vector<int> &modelExpressions, std::vector<bool> &modelValues, const std::vector<int> &assumptions);
+
+	void setPortfolioSize(int newPortfolioSize) {
+		portfolioSize = newPortfolioSize;
+	}
 };
 
 #endif
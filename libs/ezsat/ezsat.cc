@@ -35,6 +35,9 @@ ezSAT::ezSAT()
 	cnfClausesCount = 0;
 
 	solverTimeout = 0;
+	solverWallTimeout = 0;
+	solverConflictBudget = 0;
+	solverPropagationBudget = 0;
 	solverTimoutStatus = false;
 
 	literal("TRUE");
@@ -84,20 +87,24 @@ int ezSAT::frozen_literal(const std::string &name)
 
 int ezSAT::expression(OpId op, int a, int b, int c, int d, int e, int f)
 {
-	std::vector<int> args(6);
-	args[0] = a, args[1] = b, args[2] = c;
-	args[3] = d, args[4] = e, args[5] = f;
-	return expression(op, args);
+	int args[6] = { a, b, c, d, e, f };
+	return expression(op, args, 6);
 }
 
 int ezSAT::expression(OpId op, const std::vector<int> &args)
 {
-	std::vector<int> myArgs;
-	myArgs.reserve(args.size());
+	return expression(op, args.data(), args.size());
+}
+
+int ezSAT::expression(OpId op, const int *args, int numArgs)
+{
+	std::vector<int> &myArgs = expressionsScratch;
+	myArgs.clear();
 	bool xorRemovedOddTrues = false;
 
-	for (auto arg : args)
+	for (int i = 0; i < numArgs; i++)
 	{
+		int arg = args[i];
 		if (arg == 0)
 			continue;
 		if (op == OpAnd && arg == TRUE)
@@ -160,30 +167,96 @@ int ezSAT::expression(OpId op, const std::vector<int> &args)
 		// FIXME: Add proper const folding
 		break;
 
-	case OpITE:
+	case OpITE: {
 		assert(myArgs.size() == 3);
-		if (myArgs[0] == TRUE)
-			return myArgs[1];
-		if (myArgs[0] == FALSE)
-			return myArgs[2];
+		// copies, because the nested calls below reuse expressionsScratch
+		int sel = myArgs[0], a = myArgs[1], b = myArgs[2];
+		if (sel == TRUE)
+			return a;
+		if (sel == FALSE)
+			return b;
+		if (a == b)
+			return a;
+		if (a == TRUE)
+			return OR(sel, b);
+		if (a == FALSE)
+			return AND(NOT(sel), b);
+		if (b == TRUE)
+			return OR(NOT(sel), a);
+		if (b == FALSE)
+			return AND(sel, a);
 		break;
+	}
 
 	default:
 		abort();
 	}
 
-	std::pair<OpId, std::vector<int>> myExpr(op, myArgs);
-	int id = 0;
+	int id = expression_intern(op, myArgs.data(), myArgs.size());
+	return xorRemovedOddTrues ? NOT(id) : id;
+}
 
-	if (expressionsCache.count(myExpr) > 0) {
-		id = expressionsCache.at(myExpr);
-	} else {
-		id = -(expressions.size() + 1);
-		expressionsCache[myExpr] = id;
-		expressions.push_back(myExpr);
+unsigned int ezSAT::expression_hash(OpId op, const int *args, int numArgs)
+{
+	unsigned int hash = 2166136261u ^ op;
+	for (int i = 0; i < numArgs; i++) {
+		hash ^= unsigned(args[i]);
+		hash *= 16777619u;
+		hash ^= hash >> 15;
 	}
+	return hash;
+}
 
-	return xorRemovedOddTrues ? NOT(id) : id;
+bool ezSAT::expression_equal(const expressionNode &node, OpId op, const int *args, int numArgs) const
+{
+	if (node.op != op || node.numArgs != numArgs)
+		return false;
+	const int *nodeArgs = expressionArgs.data() + node.argsOffset;
+	for (int i = 0; i < numArgs; i++)
+		if (nodeArgs[i] != args[i])
+			return false;
+	return true;
+}
+
+void ezSAT::expression_rehash(int newSize)
+{
+	expressionsHashTable.clear();
+	expressionsHashTable.resize(newSize);
+
+	for (int i = 0; i < int(expressions.size()); i++) {
+		const expressionNode &node = expressions[i];
+		unsigned int slot = expression_hash(node.op, expressionArgs.data() + node.argsOffset, node.numArgs) & (newSize - 1);
+		while (expressionsHashTable[slot] != 0)
+			slot = (slot + 1) & (newSize - 1);
+		expressionsHashTable[slot] = i + 1;
+	}
+}
+
+int ezSAT::expression_intern(OpId op, const int *args, int numArgs)
+{
+	// keep the load factor of the hash table below 50%
+	if (2 * (expressions.size() + 1) > expressionsHashTable.size())
+		expression_rehash(expressionsHashTable.empty() ? 1024 : 2 * expressionsHashTable.size());
+
+	unsigned int mask = expressionsHashTable.size() - 1;
+	unsigned int slot = expression_hash(op, args, numArgs) & mask;
+
+	while (expressionsHashTable[slot] != 0) {
+		int idx = expressionsHashTable[slot] - 1;
+		if (expression_equal(expressions[idx], op, args, numArgs))
+			return -(idx + 1);
+		slot = (slot + 1) & mask;
+	}
+
+	expressionNode node;
+	node.op = op;
+	node.argsOffset = expressionArgs.size();
+	node.numArgs = numArgs;
+	expressionArgs.insert(expressionArgs.end(), args, args + numArgs);
+	expressions.push_back(node);
+
+	expressionsHashTable[slot] = expressions.size();
+	return -int(expressions.size());
 }
 
 void ezSAT::lookup_literal(int id, std::string &name) const
@@ -200,16 +273,18 @@ const std::string &ezSAT::lookup_literal(int id) const
 
 void ezSAT::lookup_expression(int id, OpId &op, std::vector<int> &args) const
 {
-	assert(0 < -id && -id <= int(expressions.size()));
-	op = expressions[-id - 1].first;
-	args = expressions[-id - 1].second;
+	int numArgs;
+	const int *argsPtr = lookup_expression(id, op, numArgs);
+	args.assign(argsPtr, argsPtr + numArgs);
 }
 
-const std::vector<int> &ezSAT::lookup_expression(int id, OpId &op) const
+const int *ezSAT::lookup_expression(int id, OpId &op, int &numArgs) const
 {
 	assert(0 < -id && -id <= int(expressions.size()));
-	op = expressions[-id - 1].first;
-	return expressions[-id - 1].second;
+	const expressionNode &node = expressions[-id - 1];
+	op = node.op;
+	numArgs = node.numArgs;
+	return expressionArgs.data() + node.argsOffset;
 }
 
 int ezSAT::parse_string(const std::string &)
@@ -282,13 +357,14 @@ int ezSAT::eval(int id, const std::vector<int> &values) const
 	}
 
 	OpId op;
-	const std::vector<int> &args = lookup_expression(id, op);
+	int numArgs;
+	const int *args = lookup_expression(id, op, numArgs);
 	int a, b;
 
 	switch (op)
 	{
 	case OpNot:
-		assert(args.size() == 1);
+		assert(numArgs == 1);
 		a = eval(args[0], values);
 		if (a == TRUE)
 			return FALSE;
@@ -297,8 +373,8 @@ int ezSAT::eval(int id, const std::vector<int> &values) const
 		return 0;
 	case OpAnd:
 		a = TRUE;
-		for (auto arg : args) {
-			b = eval(arg, values);
+		for (int i = 0; i < numArgs; i++) {
+			b = eval(args[i], values);
 			if (b != TRUE && b != FALSE)
 				a = 0;
 			if (b == FALSE)
@@ -307,8 +383,8 @@ int ezSAT::eval(int id, const std::vector<int> &values) const
 		return a;
 	case OpOr:
 		a = FALSE;
-		for (auto arg : args) {
-			b = eval(arg, values);
+		for (int i = 0; i < numArgs; i++) {
+			b = eval(args[i], values);
 			if (b != TRUE && b != FALSE)
 				a = 0;
 			if (b == TRUE)
@@ -317,8 +393,8 @@ int ezSAT::eval(int id, const std::vector<int> &values) const
 		return a;
 	case OpXor:
 		a = FALSE;
-		for (auto arg : args) {
-			b = eval(arg, values);
+		for (int i = 0; i < numArgs; i++) {
+			b = eval(args[i], values);
 			if (b != TRUE && b != FALSE)
 				return 0;
 			if (b == TRUE)
@@ -326,10 +402,10 @@ int ezSAT::eval(int id, const std::vector<int> &values) const
 		}
 		return a;
 	case OpIFF:
-		assert(args.size() > 0);
+		assert(numArgs > 0);
 		a = eval(args[0], values);
-		for (auto arg : args) {
-			b = eval(arg, values);
+		for (int i = 0; i < numArgs; i++) {
+			b = eval(args[i], values);
 			if (b != TRUE && b != FALSE)
 				return 0;
 			if (b != a)
@@ -337,7 +413,7 @@ int ezSAT::eval(int id, const std::vector<int> &values) const
 		}
 		return TRUE;
 	case OpITE:
-		assert(args.size() == 3);
+		assert(numArgs == 3);
 		a = eval(args[0], values);
 		if (a == TRUE)
 			return eval(args[1], values);
@@ -356,6 +432,7 @@ void ezSAT::clear()
 	cnfClausesCount = 0;
 	cnfLiteralVariables.clear();
 	cnfExpressionVariables.clear();
+	cnfExpressionPolarity.clear();
 	cnfClauses.clear();
 }
 
@@ -382,7 +459,7 @@ void ezSAT::assume(int id)
 			lookup_expression(id, op, args);
 
 			if (op == OpNot) {
-				int idx = bind(args[0]);
+				int idx = bind_polarity(args[0], true, CnfNeg);
 				cnfClauses.push_back(std::vector<int>(1, -idx));
 				cnfClausesCount++;
 				return;
@@ -390,22 +467,29 @@ void ezSAT::assume(int id)
 			if (op == OpOr) {
 				std::vector<int> clause;
 				for (int arg : args)
-					clause.push_back(bind(arg));
+					clause.push_back(bind_polarity(arg, true, CnfPos));
 				cnfClauses.push_back(clause);
 				cnfClausesCount++;
 				return;
 			}
 			if (op == OpAnd) {
-				for (int arg : args) {
-					cnfClauses.push_back(std::vector<int>(1, bind(arg)));
-					cnfClausesCount++;
+				for (int arg : args)
+					assume(arg);
+				return;
+			}
+			if (op == OpIFF) {
+				int idx0 = bind(args[0]);
+				for (int i = 1; i < int(args.size()); i++) {
+					int idx = bind(args[i]);
+					add_clause(-idx0, idx);
+					add_clause(idx0, -idx);
 				}
 				return;
 			}
 		}
 	}
 
-	int idx = bind(id);
+	int idx = bind_polarity(id, true, CnfPos);
 	cnfClauses.push_back(std::vector<int>(1, idx));
 	cnfClausesCount++;
 }
@@ -416,11 +500,12 @@ void ezSAT::add_clause(const std::vector<int> &args)
 	cnfClausesCount++;
 }
 
-void ezSAT::add_clause(const std::vector<int> &args, bool argsPolarity, int a, int b, int c)
+void ezSAT::add_clause(const int *args, int numArgs, bool argsPolarity, int a, int b, int c)
 {
 	std::vector<int> clause;
-	for (auto arg : args)
-		clause.push_back(argsPolarity ? +arg : -arg);
+	clause.reserve(numArgs + 3);
+	for (int i = 0; i < numArgs; i++)
+		clause.push_back(argsPolarity ? +args[i] : -args[i]);
 	if (a != 0)
 		clause.push_back(a);
 	if (b != 0)
@@ -442,34 +527,72 @@ void ezSAT::add_clause(int a, int b, int c)
 	add_clause(clause);
 }
 
-int ezSAT::bind_cnf_not(const std::vector<int> &args)
+int ezSAT::bind_cnf_and(const int *args, int numArgs, int idx, int polarity)
+{
+	assert(numArgs >= 2);
+
+	if (idx == 0)
+		idx = ++cnfVariableCount;
+
+	if (polarity & CnfNeg)
+		add_clause(args, numArgs, false, idx);
+
+	if (polarity & CnfPos)
+		for (int i = 0; i < numArgs; i++)
+			add_clause(-idx, args[i]);
+
+	return idx;
+}
+
+int ezSAT::bind_cnf_or(const int *args, int numArgs, int idx, int polarity)
 {
-	assert(args.size() == 1);
-	return -args[0];
+	assert(numArgs >= 2);
+
+	if (idx == 0)
+		idx = ++cnfVariableCount;
+
+	if (polarity & CnfPos)
+		add_clause(args, numArgs, true, -idx);
+
+	if (polarity & CnfNeg)
+		for (int i = 0; i < numArgs; i++)
+			add_clause(idx, -args[i]);
+
+	return idx;
 }
 
-int ezSAT::bind_cnf_and(const std::vector<int> &args)
+int ezSAT::bind_cnf_xor(int a, int b, int idx, int polarity)
 {
-	assert(args.size() >= 2);
+	if (idx == 0)
+		idx = ++cnfVariableCount;
 
-	int idx = ++cnfVariableCount;
-	add_clause(args, false, idx);
+	if (polarity & CnfPos) {
+		add_clause(-idx, a, b);
+		add_clause(-idx, -a, -b);
+	}
 
-	for (auto arg : args)
-		add_clause(-idx, arg);
+	if (polarity & CnfNeg) {
+		add_clause(idx, -a, b);
+		add_clause(idx, a, -b);
+	}
 
 	return idx;
 }
 
-int ezSAT::bind_cnf_or(const std::vector<int> &args)
+int ezSAT::bind_cnf_ite(int s, int a, int b, int idx, int polarity)
 {
-	assert(args.size() >= 2);
+	if (idx == 0)
+		idx = ++cnfVariableCount;
 
-	int idx = ++cnfVariableCount;
-	add_clause(args, true, -idx);
+	if (polarity & CnfPos) {
+		add_clause(-idx, -s, a);
+		add_clause(-idx, s, b);
+	}
 
-	for (auto arg : args)
-		add_clause(idx, -arg);
+	if (polarity & CnfNeg) {
+		add_clause(idx, -s, -a);
+		add_clause(idx, s, -b);
+	}
 
 	return idx;
 }
@@ -501,6 +624,16 @@ std::string ezSAT::cnfLiteralInfo(int idx) const
 }
 
 int ezSAT::bind(int id, bool auto_freeze)
+{
+	return bind_polarity(id, auto_freeze, CnfBoth);
+}
+
+static int invert_polarity(int polarity)
+{
+	return ((polarity & 1) << 1) | ((polarity & 2) >> 1);
+}
+
+int ezSAT::bind_polarity(int id, bool auto_freeze, int polarity)
 {
 	if (id >= 0) {
 		assert(0 < id && id <= int(literals.size()));
@@ -521,10 +654,12 @@ int ezSAT::bind(int id, bool auto_freeze)
 
 	assert(0 < -id && -id <= int(expressions.size()));
 	cnfExpressionVariables.resize(expressions.size());
+	cnfExpressionPolarity.resize(expressions.size());
 
 	if (eliminated(cnfExpressionVariables[-id-1]))
 	{
 		cnfExpressionVariables[-id-1] = 0;
+		cnfExpressionPolarity[-id-1] = 0;
 
 		// this will recursively call bind(id). within the recursion
 		// the cnf is pre-set to 0. an idx is allocated there, then it
@@ -533,59 +668,118 @@ int ezSAT::bind(int id, bool auto_freeze)
 			freeze(id);
 	}
 
-	if (cnfExpressionVariables[-id-1] == 0)
+	int missing = polarity & ~cnfExpressionPolarity[-id-1];
+
+	if (missing != 0)
 	{
-		OpId op;
-		std::vector<int> args;
-		lookup_expression(id, op, args);
-		int idx = 0;
+		OpId op = expressions[-id-1].op;
+		int argsOffset = expressions[-id-1].argsOffset;
+		int numArgs = expressions[-id-1].numArgs;
+		int idx = cnfExpressionVariables[-id-1];
 
-		if (op == OpXor) {
+		// expressions that are rewritten to other expressions are deterministic
+		// thanks to hash-consing, so adding a missing polarity later will bind
+		// the very same rewritten expression again.
+
+		if (op == OpNot) {
+			idx = -bind_polarity(expressionArgs[argsOffset], false, invert_polarity(missing));
+			goto assign_idx;
+		}
+
+		if (op == OpXor && numArgs > 2) {
+			std::vector<int> args;
+			lookup_expression(id, op, args);
 			while (args.size() > 1) {
 				std::vector<int> newArgs;
 				for (int i = 0; i < int(args.size()); i += 2)
 					if (i+1 == int(args.size()))
 						newArgs.push_back(args[i]);
 					else
-						newArgs.push_back(OR(AND(args[i], NOT(args[i+1])), AND(NOT(args[i]), args[i+1])));
+						newArgs.push_back(XOR(args[i], args[i+1]));
 				args.swap(newArgs);
 			}
-			idx = bind(args.at(0), false);
+			idx = bind_polarity(args.at(0), false, missing);
 			goto assign_idx;
 		}
 
 		if (op == OpIFF) {
-			std::vector<int> invArgs;
-			for (auto arg : args)
-				invArgs.push_back(NOT(arg));
-			idx = bind(OR(expression(OpAnd, args), expression(OpAnd, invArgs)), false);
+			std::vector<int> args, invArgs;
+			lookup_expression(id, op, args);
+			if (args.size() == 2) {
+				idx = -bind_polarity(XOR(args[0], args[1]), false, invert_polarity(missing));
+			} else {
+				for (auto arg : args)
+					invArgs.push_back(NOT(arg));
+				idx = bind_polarity(OR(expression(OpAnd, args), expression(OpAnd, invArgs)), false, missing);
+			}
+			goto assign_idx;
+		}
+
+		if (op == OpXor) {
+			int a = expressionArgs[argsOffset], b = expressionArgs[argsOffset + 1];
+			a = bind_polarity(a, false, CnfBoth);
+			b = bind_polarity(b, false, CnfBoth);
+			idx = bind_cnf_xor(a, b, idx, missing);
 			goto assign_idx;
 		}
 
 		if (op == OpITE) {
-			idx = bind(OR(AND(args[0], args[1]), AND(NOT(args[0]), args[2])), false);
+			int s = expressionArgs[argsOffset], a = expressionArgs[argsOffset + 1], b = expressionArgs[argsOffset + 2];
+			s = bind_polarity(s, false, CnfBoth);
+			a = bind_polarity(a, false, missing);
+			b = bind_polarity(b, false, missing);
+			idx = bind_cnf_ite(s, a, b, idx, missing);
 			goto assign_idx;
 		}
 
-		for (int i = 0; i < int(args.size()); i++)
-			args[i] = bind(args[i], false);
+		// binding the arguments may add new expressions and thus reallocate
+		// the argument arena, so the arguments are re-read by offset here
+		// and the resulting cnf indices are collected in a scratch buffer
+		// that is only used after the recursion has finished.
+
+		for (int i = 0; i < numArgs; i++)
+			bind_polarity(expressionArgs[argsOffset + i], false, missing);
+
+		cnfArgsScratch.resize(numArgs);
+		for (int i = 0; i < numArgs; i++)
+			cnfArgsScratch[i] = bound(expressionArgs[argsOffset + i]);
 
 		switch (op)
 		{
-			case OpNot: idx = bind_cnf_not(args); break;
-			case OpAnd: idx = bind_cnf_and(args); break;
-			case OpOr:  idx = bind_cnf_or(args);  break;
+			case OpAnd: idx = bind_cnf_and(cnfArgsScratch.data(), numArgs, idx, missing); break;
+			case OpOr:  idx = bind_cnf_or(cnfArgsScratch.data(), numArgs, idx, missing);  break;
 			default: abort();
 		}
 
 	assign_idx:
 		assert(idx != 0);
 		cnfExpressionVariables[-id-1] = idx;
+		cnfExpressionPolarity[-id-1] |= missing;
 	}
 
 	return cnfExpressionVariables[-id-1];
 }
 
+int ezSAT::numCnfClausesSaved() const
+{
+	int count = 0;
+	for (int i = 0; i < int(cnfExpressionPolarity.size()); i++)
+	{
+		int polarity = cnfExpressionPolarity[i];
+		if (polarity == 0 || polarity == CnfBoth)
+			continue;
+
+		const expressionNode &node = expressions[i];
+		if (node.op == OpAnd)
+			count += polarity == CnfPos ? 1 : node.numArgs;
+		if (node.op == OpOr)
+			count += polarity == CnfNeg ? 1 : node.numArgs;
+		if ((node.op == OpXor && node.numArgs == 2) || node.op == OpITE)
+			count += 2;
+	}
+	return count;
+}
+
 void ezSAT::consumeCnf()
 {
 	cnfConsumed = true;
@@ -725,9 +919,11 @@ std::vector<int> ezSAT::vec_ite(int sel, const std::vector<int> &vec1, const std
 // 'y' is the MSB (carry) and x the LSB (sum) output
 static void fulladder(ezSAT *that, int a, int b, int c, int &y, int &x)
 {
+	// the carry is 'c' if exactly one of 'a' and 'b' is set and 'a' otherwise. this
+	// reuses the XOR of the sum and binds to a single compact ITE in the CNF.
 	int tmp = that->XOR(a, b);
 	int new_x = that->XOR(tmp, c);
-	int new_y = that->OR(that->AND(a, b), that->AND(c, tmp));
+	int new_y = that->ITE(tmp, c, a);
 #if 0
 	printf("FULLADD> a=%s, b=%s, c=%s, carry=%s, sum=%s\n", that->to_string(a).c_str(), that->to_string(b).c_str(),
 			that->to_string(c).c_str(), that->to_string(new_y).c_str(), that->to_string(new_x).c_str());
@@ -831,6 +1027,67 @@ std::vector<int> ezSAT::vec_neg(const std::vector<int> &vec)
 	return vec_sub(zero, vec);
 }
 
+std::vector<int> ezSAT::vec_mul(const std::vector<int> &vec1, const std::vector<int> &vec2)
+{
+	// carry-save multiplier: all partial products are summed up column by column
+	// using full and half adders (Wallace tree), only the final carry-propagation
+	// uses a ripple adder. the result is truncated to the width of vec1.
+
+	assert(vec1.size() == vec2.size());
+	int numBits = vec1.size();
+
+	std::vector<std::vector<int>> columns(numBits);
+	for (int i = 0; i < numBits; i++)
+	for (int j = 0; i+j < numBits; j++) {
+		int bit = AND(vec1[j], vec2[i]);
+		if (bit != FALSE)
+			columns[i+j].push_back(bit);
+	}
+
+	bool reduced = true;
+	while (reduced)
+	{
+		reduced = false;
+		std::vector<std::vector<int>> newColumns(numBits);
+
+		for (int i = 0; i < numBits; i++)
+		{
+			std::vector<int> &col = columns[i];
+			int k = 0;
+			for (; k+2 < int(col.size()); k += 3) {
+				int carry, sum;
+				fulladder(this, col[k], col[k+1], col[k+2], carry, sum);
+				newColumns[i].push_back(sum);
+				if (i+1 < numBits)
+					newColumns[i+1].push_back(carry);
+				reduced = true;
+			}
+			if (k+2 == int(col.size()) && col.size() > 2) {
+				int carry, sum;
+				halfadder(this, col[k], col[k+1], carry, sum);
+				newColumns[i].push_back(sum);
+				if (i+1 < numBits)
+					newColumns[i+1].push_back(carry);
+				k += 2;
+			}
+			for (; k < int(col.size()); k++)
+				newColumns[i].push_back(col[k]);
+		}
+
+		columns.swap(newColumns);
+	}
+
+	std::vector<int> vecA(numBits, FALSE), vecB(numBits, FALSE);
+	for (int i = 0; i < numBits; i++) {
+		if (columns[i].size() > 0)
+			vecA[i] = columns[i][0];
+		if (columns[i].size() > 1)
+			vecB[i] = columns[i][1];
+	}
+
+	return vec_add(vecA, vecB);
+}
+
 void ezSAT::vec_cmp(const std::vector<int> &vec1, const std::vector<int> &vec2, int &carry, int &overflow, int &sign, int &zero)
 {
 	assert(vec1.size() == vec2.size());
@@ -1100,10 +1357,10 @@ void ezSAT::printDIMACS(FILE *f, bool verbose) const
 	}
 }
 
-static std::string expression2str(const std::pair<ezSAT::OpId, std::vector<int>> &data)
+static std::string expression2str(ezSAT::OpId op, const std::vector<int> &args)
 {
 	std::string text;
-	switch (data.first) {
+	switch (op) {
 #define X(op) case ezSAT::op: text += #op; break;
 		X(OpNot)
 		X(OpAnd)
@@ -1116,7 +1373,7 @@ static std::string expression2str(const std::pair<ezSAT::OpId, std::vector<int>>
 #undef X
 	}
 	text += ":";
-	for (auto it : data.second)
+	for (auto it : args)
 		text += " " + std::to_string(it);
 	return text;
 }
@@ -1133,13 +1390,18 @@ void ezSAT::printInternalState(FILE *f) const
 	for (int i = 0; i < int(literals.size()); i++)
 		fprintf(f, "    %d: `%s'\n", i+1, literals[i].c_str());
 
-	fprintf(f, "expressionsCache:\n");
-	for (auto &it : expressionsCache)
-		fprintf(f, "    `%s' -> %d\n", expression2str(it.first).c_str(), it.second);
+	fprintf(f, "expressionsHashTable (size=%d):\n", int(expressionsHashTable.size()));
+	for (int i = 0; i < int(expressionsHashTable.size()); i++)
+		if (expressionsHashTable[i] != 0)
+			fprintf(f, "    slot %d -> %d\n", i, -expressionsHashTable[i]);
 
 	fprintf(f, "expressions:\n");
-	for (int i = 0; i < int(expressions.size()); i++)
-		fprintf(f, "    %d: `%s'\n", -i-1, expression2str(expressions[i]).c_str());
+	for (int i = 0; i < int(expressions.size()); i++) {
+		OpId op;
+		std::vector<int> args;
+		lookup_expression(-i-1, op, args);
+		fprintf(f, "    %d: `%s'\n", -i-1, expression2str(op, args).c_str());
+	}
 
 	fprintf(f, "cnfVariables (count=%d):\n", cnfVariableCount);
 	for (int i = 0; i < int(cnfLiteralVariables.size()); i++)
@@ -25,6 +25,7 @@
 #include <vector>
 #include <string>
 #include <stdio.h>
+#include <stdint.h>
 
 class ezSAT
 {
@@ -51,24 +52,57 @@ private:
 	std::map<std::string, int> literalsCache;
 	std::vector<std::string> literals;
 
-	std::map<std::pair<OpId, std::vector<int>>, int> expressionsCache;
-	std::vector<std::pair<OpId, std::vector<int>>> expressions;
+	// expressions are hash-consed: all nodes live in one arena with their
+	// arguments stored back-to-back in expressionArgs, and an open addressing
+	// hash table (linear probing, 0 = empty slot, otherwise node index + 1)
+	// is used for finding structurally identical nodes.
+
+	struct expressionNode {
+		OpId op;
+		int argsOffset, numArgs;
+	};
+
+	std::vector<expressionNode> expressions;
+	std::vector<int> expressionArgs;
+	std::vector<int> expressionsHashTable;
+	std::vector<int> expressionsScratch;
+	std::vector<int> cnfArgsScratch;
+
+	static unsigned int expression_hash(OpId op, const int *args, int numArgs);
+	bool expression_equal(const expressionNode &node, OpId op, const int *args, int numArgs) const;
+	void expression_rehash(int newSize);
+	int expression_intern(OpId op, const int *args, int numArgs);
+
+	// the cnf is generated polarity-aware (Plaisted-Greenbaum): for each bound
+	// expression only the clauses for the directions that are actually needed
+	// are generated (CnfPos = 'variable implies expression', CnfNeg = 'expression
+	// implies variable'). missing directions are added when a later bind() needs
+	// them, so the cnf stays equisatisfiable with the full Tseitin encoding.
+
+	enum { CnfPos = 1, CnfNeg = 2, CnfBoth = 3 };
 
 	bool cnfConsumed;
 	int cnfVariableCount, cnfClausesCount;
 	std::vector<int> cnfLiteralVariables, cnfExpressionVariables;
+	std::vector<char> cnfExpressionPolarity;
 	std::vector<std::vector<int>> cnfClauses;
 
 	void add_clause(const std::vector<int> &args);
-	void add_clause(const std::vector<int> &args, bool argsPolarity, int a = 0, int b = 0, int c = 0);
+	void add_clause(const int *args, int numArgs, bool argsPolarity, int a = 0, int b = 0, int c = 0);
 	void add_clause(int a, int b = 0, int c = 0);
 
-	int bind_cnf_not(const std::vector<int> &args);
-	int bind_cnf_and(const std::vector<int> &args);
-	int bind_cnf_or(const std::vector<int> &args);
+	int bind_cnf_and(const int *args, int numArgs, int idx, int polarity);
+	int bind_cnf_or(const int *args, int numArgs, int idx, int polarity);
+	int bind_cnf_xor(int a, int b, int idx, int polarity);
+	int bind_cnf_ite(int s, int a, int b, int idx, int polarity);
+	int bind_polarity(int id, bool auto_freeze, int polarity);
 
 public:
-	int solverTimeout;
+	// solver budgets, all are per call to solve() and 0 means unlimited.
+	// the timeouts are in seconds (cpu time of the solving thread and wall
+	// clock time), the conflict and propagation budgets are plain counts.
+	int solverTimeout, solverWallTimeout;
+	int64_t solverConflictBudget, solverPropagationBudget;
 	bool solverTimoutStatus;
 
 	ezSAT();
@@ -83,12 +117,13 @@ public:
 	int frozen_literal(const std::string &name);
 	int expression(OpId op, int a = 0, int b = 0, int c = 0, int d = 0, int e = 0, int f = 0);
 	int expression(OpId op, const std::vector<int> &args);
+	int expression(OpId op, const int *args, int numArgs);
 
 	void lookup_literal(int id, std::string &name) const;
 	const std::string &lookup_literal(int id) const;
 
 	void lookup_expression(int id, OpId &op, std::vector<int> &args) const;
-	const std::vector<int> &lookup_expression(int id, OpId &op) const;
+	const int *lookup_expression(int id, OpId &op, int &numArgs) const;
 
 	int parse_string(const std::string &text);
 	std::string to_string(int id) const;
@@ -135,6 +170,18 @@ public:
 		solverTimeout = newTimeoutSeconds;
 	}
 
+	void setSolverWallTimeout(int newTimeoutSeconds) {
+		solverWallTimeout = newTimeoutSeconds;
+	}
+
+	void setSolverConflictBudget(int64_t newConflictBudget) {
+		solverConflictBudget = newConflictBudget;
+	}
+
+	void setSolverPropagationBudget(int64_t newPropagationBudget) {
+		solverPropagationBudget = newPropagationBudget;
+	}
+
 	bool getSolverTimoutStatus() {
 		return solverTimoutStatus;
 	}
@@ -150,6 +197,7 @@ public:
 
 	int numCnfVariables() const { return cnfVariableCount; }
 	int numCnfClauses() const { return cnfClausesCount; }
+	int numCnfClausesSaved() const;
 	const std::vector<std::vector<int>> &cnf() const { return cnfClauses; }
 
 	void consumeCnf();
@@ -226,6 +274,7 @@ public:
 	std::vector<int> vec_add(const std::vector<int> &vec1, const std::vector<int> &vec2);
 	std::vector<int> vec_sub(const std::vector<int> &vec1, const std::vector<int> &vec2);
 	std::vector<int> vec_neg(const std::vector<int> &vec);
+	std::vector<int> vec_mul(const std::vector<int> &vec1, const std::vector<int> &vec2);
 
 	void vec_cmp(const std::vector<int> &vec1, const std::vector<int> &vec2, int &carry, int &overflow, int &sign, int &zero);
 
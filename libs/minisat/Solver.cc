@@ -103,6 +103,9 @@ Solver::Solver() :
   , conflict_budget    (-1)
   , propagation_budget (-1)
   , asynch_interrupt   (false)
+  , term_callback      (NULL)
+  , term_data          (NULL)
+  , term_next_check    (0)
 {}
 
 
@@ -747,6 +750,7 @@ lbool Solver::search(int nof_conflicts)
 
         }else{
             // NO CONFLICT
+            checkTermCallback();
             if ((nof_conflicts >= 0 && conflictC >= nof_conflicts) || !withinBudget()){
                 // Reached bound on number of conflicts:
                 progress_estimate = progressEstimate();
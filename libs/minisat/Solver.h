@@ -27,6 +27,7 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 #include "libs/minisat/IntMap.h"
 #include "libs/minisat/Options.h"
 #include "libs/minisat/SolverTypes.h"
+#include <atomic>
 
 
 namespace Minisat {
@@ -110,6 +111,8 @@ public:
     void    budgetOff();
     void    interrupt();          // Trigger a (potentially asynchronous) interruption of the solver.
     void    clearInterrupt();     // Clear interrupt indicator flag.
+    void    setTermCallback(bool (*cb)(void*), void *data); // Periodically called from the search loop. Returning
+                                                           // 'true' interrupts the solver (NULL: no callback).
 
     // Memory managment:
     //
@@ -234,7 +237,10 @@ protected:
     //
     int64_t             conflict_budget;    // -1 means no budget.
     int64_t             propagation_budget; // -1 means no budget.
-    bool                asynch_interrupt;
+    std::atomic<bool>   asynch_interrupt;
+    bool              (*term_callback)(void*);
+    void               *term_data;
+    uint64_t            term_next_check;
 
     // Main internal methods:
     //
@@ -279,6 +285,7 @@ protected:
     int      level            (Var x) const;
     double   progressEstimate ()      const; // DELETE THIS ?? IT'S NOT VERY USEFUL ...
     bool     withinBudget     ()      const;
+    void     checkTermCallback();
     void     relocAll         (ClauseAllocator& to);
 
     // Static helpers:
@@ -370,6 +377,12 @@ inline void     Solver::setConfBudget(int64_t x){ conflict_budget    = conflicts
 inline void     Solver::setPropBudget(int64_t x){ propagation_budget = propagations + x; }
 inline void     Solver::interrupt(){ asynch_interrupt = true; }
 inline void     Solver::clearInterrupt(){ asynch_interrupt = false; }
+inline void     Solver::setTermCallback(bool (*cb)(void*), void *data){ term_callback = cb; term_data = data; term_next_check = propagations; }
+inline void     Solver::checkTermCallback(){
+    if (term_callback != NULL && propagations >= term_next_check){
+        term_next_check = propagations + 10000;
+        if (term_callback(term_data))
+            asynch_interrupt = true; } }
 inline void     Solver::budgetOff(){ conflict_budget = propagation_budget = -1; }
 inline bool     Solver::withinBudget() const {
     return !asynch_interrupt &&
@@ -21,8 +21,11 @@
 #include "subcircuit.h"
 
 #include <algorithm>
+#include <thread>
+#include <atomic>
 #include <assert.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
 
 #ifdef _YOSYS_
@@ -286,13 +289,80 @@ class SubCircuit::SolverWorker
 
 	typedef std::vector<std::map<int, int>> adjMatrix_t;
 
+	// dense set of node indices, one bit per node
+	struct NodeBits
+	{
+		std::vector<uint64_t> words;
+
+		NodeBits(int numNodes = 0) : words((numNodes + 63) / 64) { }
+
+		bool get(int idx) const {
+			return (words[idx / 64] >> (idx % 64)) & 1;
+		}
+		void set(int idx) {
+			words[idx / 64] |= uint64_t(1) << (idx % 64);
+		}
+		void clear(int idx) {
+			words[idx / 64] &= ~(uint64_t(1) << (idx % 64));
+		}
+		int count() const {
+			int n = 0;
+			for (uint64_t w : words)
+				n += __builtin_popcountll(w);
+			return n;
+		}
+		// returns the smallest index >= idx in the set or -1
+		int next(int idx = 0) const {
+			int k = idx / 64;
+			if (k >= int(words.size()))
+				return -1;
+			uint64_t w = words[k] & (~uint64_t(0) << (idx % 64));
+			while (w == 0) {
+				if (++k == int(words.size()))
+					return -1;
+				w = words[k];
+			}
+			return k*64 + __builtin_ctzll(w);
+		}
+		int first() const {
+			return next(0);
+		}
+		void swap(NodeBits &other) {
+			words.swap(other.words);
+		}
+	};
+
+	// rows are needle nodes, the bits in each row are haystack nodes
+	typedef std::vector<NodeBits> enumMatrix_t;
+
 	struct GraphData {
 		std::string graphId;
 		Graph graph;
 		adjMatrix_t adjMatrix;
+		std::vector<NodeBits> adjBits;
 		std::vector<bool> usedNodes;
 	};
 
+	// nodes with many neighbours (e.g. everything connected to a supply net) also
+	// get their row of the adjacency matrix as bitset. this is never larger than
+	// the std::map row and lets checkEnumerationMatrix() intersect it word-wise
+	// with the candidates of a needle node.
+	static void generateAdjBits(GraphData &gd)
+	{
+		int numNodes = gd.graph.nodes.size();
+		int minDegree = std::max(numNodes / 64, 8);
+
+		gd.adjBits.clear();
+		gd.adjBits.resize(numNodes);
+		for (int i = 0; i < numNodes; i++) {
+			if (int(gd.adjMatrix[i].size()) < minDegree)
+				continue;
+			gd.adjBits[i] = NodeBits(numNodes);
+			for (const auto &it : gd.adjMatrix[i])
+				gd.adjBits[i].set(it.first);
+		}
+	}
+
 	static void printAdjMatrix(const adjMatrix_t &matrix)
 	{
 		my_printf("%7s", "");
@@ -631,6 +701,10 @@ class SubCircuit::SolverWorker
 
 		static void findEdgesInGraph(const Graph &graph, std::map<std::pair<int, int>, DiEdge> &edges)
 		{
+			std::vector<DiNode> diNodes;
+			for (int i = 0; i < int(graph.nodes.size()); i++)
+				diNodes.push_back(DiNode(graph, i));
+
 			edges.clear();
 			for (const auto &edge : graph.edges) {
 				if (edge.constValue != 0)
@@ -639,10 +713,12 @@ class SubCircuit::SolverWorker
 				for (const auto &toBit : edge.portBits)
 					if (&fromBit != &toBit) {
 						DiEdge &de = edges[std::pair<int, int>(fromBit.nodeIdx, toBit.nodeIdx)];
-						de.fromNode = DiNode(graph, fromBit.nodeIdx);
-						de.toNode = DiNode(graph, toBit.nodeIdx);
-						std::string fromPortId = graph.nodes[fromBit.nodeIdx].ports[fromBit.portIdx].portId;
-						std::string toPortId = graph.nodes[toBit.nodeIdx].ports[toBit.portIdx].portId;
+						if (de.bits.empty()) {
+							de.fromNode = diNodes[fromBit.nodeIdx];
+							de.toNode = diNodes[toBit.nodeIdx];
+						}
+						const std::string &fromPortId = graph.nodes[fromBit.nodeIdx].ports[fromBit.portIdx].portId;
+						const std::string &toPortId = graph.nodes[toBit.nodeIdx].ports[toBit.portIdx].portId;
 						de.bits.insert(DiBit(fromPortId, fromBit.bitIdx, toPortId, toBit.bitIdx));
 					}
 			}
@@ -653,7 +729,7 @@ class SubCircuit::SolverWorker
 	{
 		std::map<DiEdge, int> edgeTypesMap;
 		std::vector<DiEdge> edgeTypes;
-		std::map<std::pair<int, int>, bool> compareCache;
+		std::vector<std::vector<signed char>> compareCache;
 
 		void add(const Graph &graph, adjMatrix_t &adjMatrix, const std::string &graphId, Solver *userSolver)
 		{
@@ -670,21 +746,27 @@ class SubCircuit::SolverWorker
 			}
 
 			for (const auto &it : edges) {
-				if (edgeTypesMap.count(it.second) == 0) {
-					edgeTypesMap[it.second] = edgeTypes.size();
+				auto typeIt = edgeTypesMap.find(it.second);
+				if (typeIt == edgeTypesMap.end()) {
+					typeIt = edgeTypesMap.insert(std::pair<DiEdge, int>(it.second, edgeTypes.size())).first;
 					edgeTypes.push_back(it.second);
 				}
-				adjMatrix[it.first.first][it.first.second] = edgeTypesMap[it.second];
+				std::map<int, int> &adjRow = adjMatrix[it.first.first];
+				adjRow.insert(adjRow.end(), std::pair<int, int>(it.first.second, typeIt->second));
 			}
 		}
 
 		bool compare(int needleEdge, int haystackEdge, const std::map<std::string, std::set<std::set<std::string>>> &swapPorts,
 				const std::map<std::string, std::set<std::map<std::string, std::string>>> &swapPermutations)
 		{
-			std::pair<int, int> key(needleEdge, haystackEdge);
-			if (!compareCache.count(key))
-				compareCache[key] = edgeTypes.at(needleEdge).compare(edgeTypes.at(haystackEdge), swapPorts, swapPermutations);
-			return compareCache[key];
+			if (int(compareCache.size()) <= needleEdge)
+				compareCache.resize(edgeTypes.size());
+			std::vector<signed char> &cacheRow = compareCache[needleEdge];
+			if (int(cacheRow.size()) <= haystackEdge)
+				cacheRow.resize(edgeTypes.size(), -1);
+			if (cacheRow[haystackEdge] < 0)
+				cacheRow[haystackEdge] = edgeTypes.at(needleEdge).compare(edgeTypes.at(haystackEdge), swapPorts, swapPermutations);
+			return cacheRow[haystackEdge];
 		}
 
 		bool compare(int needleEdge, int haystackEdge, const std::map<std::string, std::string> &mapFromPorts, const std::map<std::string, std::set<std::set<std::string>>> &swapPorts,
@@ -844,60 +926,89 @@ class SubCircuit::SolverWorker
 		return false;
 	}
 
-	void generateEnumerationMatrix(std::vector<std::set<int>> &enumerationMatrix, const GraphData &needle, const GraphData &haystack, const std::map<std::string, std::set<std::string>> &initialMappings) const
+	void generateEnumerationMatrix(enumMatrix_t &enumerationMatrix, const GraphData &needle, const GraphData &haystack, const std::map<std::string, std::set<std::string>> &initialMappings) const
 	{
-		std::map<std::string, std::set<int>> haystackNodesByTypeId;
+		std::map<std::string, std::vector<int>> haystackNodesByTypeId;
 		for (int i = 0; i < int(haystack.graph.nodes.size()); i++)
-			haystackNodesByTypeId[haystack.graph.nodes[i].typeId].insert(i);
+			haystackNodesByTypeId[haystack.graph.nodes[i].typeId].push_back(i);
+
+		// a haystack node can only be mapped to a needle node if it has at least as
+		// many neighbours, because the neighbours of the needle node must be mapped
+		// to distinct neighbours of the haystack node
 
 		enumerationMatrix.clear();
-		enumerationMatrix.resize(needle.graph.nodes.size());
+		enumerationMatrix.resize(needle.graph.nodes.size(), NodeBits(haystack.graph.nodes.size()));
 		for (int i = 0; i < int(needle.graph.nodes.size()); i++)
 		{
 			const Graph::Node &nn = needle.graph.nodes[i];
+			size_t needleDegree = needle.adjMatrix.at(i).size();
 
 			for (int j : haystackNodesByTypeId[nn.typeId]) {
 				const Graph::Node &hn = haystack.graph.nodes[j];
+				if (haystack.adjMatrix.at(j).size() < needleDegree)
+					continue;
 				if (initialMappings.count(nn.nodeId) > 0 && initialMappings.at(nn.nodeId).count(hn.nodeId) == 0)
 					continue;
 				if (!matchNodes(needle, i, haystack, j))
 					continue;
-				enumerationMatrix[i].insert(j);
+				enumerationMatrix[i].set(j);
 			}
 
 			if (compatibleTypes.count(nn.typeId) > 0)
 				for (const std::string &compatibleTypeId : compatibleTypes.at(nn.typeId))
 					for (int j : haystackNodesByTypeId[compatibleTypeId]) {
 						const Graph::Node &hn = haystack.graph.nodes[j];
+						if (haystack.adjMatrix.at(j).size() < needleDegree)
+							continue;
 						if (initialMappings.count(nn.nodeId) > 0 && initialMappings.at(nn.nodeId).count(hn.nodeId) == 0)
 							continue;
 						if (!matchNodes(needle, i, haystack, j))
 							continue;
-						enumerationMatrix[i].insert(j);
+						enumerationMatrix[i].set(j);
 					}
 		}
 	}
 
-	bool checkEnumerationMatrix(std::vector<std::set<int>> &enumerationMatrix, int i, int j, const GraphData &needle, const GraphData &haystack)
+	bool checkEnumerationEdge(const GraphData &needle, int needleFrom, int needleTo, int needleEdgeType,
+			const GraphData &haystack, int haystackFrom, int haystackTo, int haystackEdgeType)
 	{
+		if (!diCache.compare(needleEdgeType, haystackEdgeType, swapPorts, swapPermutations))
+			return false;
+
+		const Graph::Node &needleFromNode = needle.graph.nodes[needleFrom];
+		const Graph::Node &needleToNode = needle.graph.nodes[needleTo];
+		const Graph::Node &haystackFromNode = haystack.graph.nodes[haystackFrom];
+		const Graph::Node &haystackToNode = haystack.graph.nodes[haystackTo];
+		return userSolver->userCompareEdge(needle.graphId, needleFromNode.nodeId,  needleFromNode.userData, needleToNode.nodeId,  needleToNode.userData,
+				haystack.graphId, haystackFromNode.nodeId, haystackFromNode.userData, haystackToNode.nodeId, haystackToNode.userData);
+	}
+
+	bool checkEnumerationMatrix(enumMatrix_t &enumerationMatrix, int i, int j, const GraphData &needle, const GraphData &haystack)
+	{
+		const std::map<int, int> &haystackAdj = haystack.adjMatrix.at(j);
+		const NodeBits &haystackAdjBits = haystack.adjBits.at(j);
+
 		for (const auto &it_needle : needle.adjMatrix.at(i))
 		{
 			int needleNeighbour = it_needle.first;
 			int needleEdgeType = it_needle.second;
+			const NodeBits &candidates = enumerationMatrix[needleNeighbour];
 
-			for (int haystackNeighbour : enumerationMatrix[needleNeighbour])
-				if (haystack.adjMatrix.at(j).count(haystackNeighbour) > 0) {
-					int haystackEdgeType = haystack.adjMatrix.at(j).at(haystackNeighbour);
-					if (diCache.compare(needleEdgeType, haystackEdgeType, swapPorts, swapPermutations)) {
-						const Graph::Node &needleFromNode = needle.graph.nodes[i];
-						const Graph::Node &needleToNode = needle.graph.nodes[needleNeighbour];
-						const Graph::Node &haystackFromNode = haystack.graph.nodes[j];
-						const Graph::Node &haystackToNode = haystack.graph.nodes[haystackNeighbour];
-						if (userSolver->userCompareEdge(needle.graphId, needleFromNode.nodeId,  needleFromNode.userData, needleToNode.nodeId,  needleToNode.userData,
-								haystack.graphId, haystackFromNode.nodeId, haystackFromNode.userData, haystackToNode.nodeId, haystackToNode.userData))
+			if (haystackAdjBits.words.empty())
+			{
+				for (const auto &it_haystack : haystackAdj)
+					if (candidates.get(it_haystack.first) && checkEnumerationEdge(needle, i, needleNeighbour, needleEdgeType, haystack, j, it_haystack.first, it_haystack.second))
+						goto found_match;
+			}
+			else
+			{
+				for (int k = 0; k < int(candidates.words.size()); k++)
+					for (uint64_t w = candidates.words[k] & haystackAdjBits.words[k]; w != 0; w &= w - 1) {
+						int haystackNeighbour = k*64 + __builtin_ctzll(w);
+						if (checkEnumerationEdge(needle, i, needleNeighbour, needleEdgeType, haystack, j, haystackNeighbour, haystackAdj.at(haystackNeighbour)))
 							goto found_match;
 					}
-				}
+			}
 
 			return false;
 		found_match:;
@@ -906,7 +1017,7 @@ class SubCircuit::SolverWorker
 		return true;
 	}
 
-	bool pruneEnumerationMatrix(std::vector<std::set<int>> &enumerationMatrix, const GraphData &needle, const GraphData &haystack, int &nextRow, bool allowOverlap)
+	bool pruneEnumerationMatrix(enumMatrix_t &enumerationMatrix, const GraphData &needle, const GraphData &haystack, int &nextRow, bool allowOverlap)
 	{
 		bool didSomething = true;
 		while (didSomething)
@@ -914,30 +1025,28 @@ class SubCircuit::SolverWorker
 			nextRow = -1;
 			didSomething = false;
 			for (int i = 0; i < int(enumerationMatrix.size()); i++) {
-				std::set<int> newRow;
-				for (int j : enumerationMatrix[i]) {
-					if (!checkEnumerationMatrix(enumerationMatrix, i, j, needle, haystack))
+				NodeBits &row = enumerationMatrix[i];
+				for (int j = row.first(); j >= 0; j = row.next(j+1)) {
+					if (!checkEnumerationMatrix(enumerationMatrix, i, j, needle, haystack) || (!allowOverlap && haystack.usedNodes[j])) {
+						row.clear(j);
 						didSomething = true;
-					else if (!allowOverlap && haystack.usedNodes[j])
-						didSomething = true;
-					else
-						newRow.insert(j);
+					}
 				}
-				if (newRow.size() == 0)
+				int firstCandidate = row.first();
+				if (firstCandidate < 0)
 					return false;
-				if (newRow.size() >= 2 && (nextRow < 0 || needle.adjMatrix.at(nextRow).size() < needle.adjMatrix.at(i).size()))
+				if (row.next(firstCandidate+1) >= 0 && (nextRow < 0 || needle.adjMatrix.at(nextRow).size() < needle.adjMatrix.at(i).size()))
 					nextRow = i;
-				enumerationMatrix[i].swap(newRow);
 			}
 		}
 		return true;
 	}
 
-	void printEnumerationMatrix(const std::vector<std::set<int>> &enumerationMatrix, int maxHaystackNodeIdx = -1) const
+	void printEnumerationMatrix(const enumMatrix_t &enumerationMatrix, int maxHaystackNodeIdx = -1) const
 	{
 		if (maxHaystackNodeIdx < 0) {
 			for (const auto &it : enumerationMatrix)
-				for (int idx : it)
+				for (int idx = it.first(); idx >= 0; idx = it.next(idx+1))
 					maxHaystackNodeIdx = std::max(maxHaystackNodeIdx, idx);
 		}
 
@@ -952,16 +1061,16 @@ class SubCircuit::SolverWorker
 			for (int j = 0; j < maxHaystackNodeIdx; j++) {
 				if (j % 5 == 0)
 					my_printf(" ");
-				my_printf("%c", enumerationMatrix[i].count(j) > 0 ? '*' : '.');
+				my_printf("%c", enumerationMatrix[i].get(j) ? '*' : '.');
 			}
 			my_printf("\n");
 		}
 	}
 
-	bool checkPortmapCandidate(const std::vector<std::set<int>> &enumerationMatrix, const GraphData &needle,  const GraphData &haystack, int idx, const std::map<std::string, std::string> &currentCandidate)
+	bool checkPortmapCandidate(const enumMatrix_t &enumerationMatrix, const GraphData &needle,  const GraphData &haystack, int idx, const std::map<std::string, std::string> &currentCandidate)
 	{
-		assert(enumerationMatrix[idx].size() == 1);
-		int idxHaystack = *enumerationMatrix[idx].begin();
+		assert(enumerationMatrix[idx].count() == 1);
+		int idxHaystack = enumerationMatrix[idx].first();
 
 		const Graph::Node &nn = needle.graph.nodes[idx];
 		const Graph::Node &hn = haystack.graph.nodes[idxHaystack];
@@ -975,8 +1084,8 @@ class SubCircuit::SolverWorker
 			int needleNeighbour = it_needle.first;
 			int needleEdgeType = it_needle.second;
 
-			assert(enumerationMatrix[needleNeighbour].size() == 1);
-			int haystackNeighbour = *enumerationMatrix[needleNeighbour].begin();
+			assert(enumerationMatrix[needleNeighbour].count() == 1);
+			int haystackNeighbour = enumerationMatrix[needleNeighbour].first();
 
 			assert(haystack.adjMatrix.at(idxHaystack).count(haystackNeighbour) > 0);
 			int haystackEdgeType = haystack.adjMatrix.at(idxHaystack).at(haystackNeighbour);
@@ -987,7 +1096,7 @@ class SubCircuit::SolverWorker
 		return true;
 	}
 
-	void generatePortmapCandidates(std::set<std::map<std::string, std::string>> &portmapCandidates, const std::vector<std::set<int>> &enumerationMatrix,
+	void generatePortmapCandidates(std::set<std::map<std::string, std::string>> &portmapCandidates, const enumMatrix_t &enumerationMatrix,
 			const GraphData &needle, const GraphData &haystack, int idx)
 	{
 		std::map<std::string, std::string> currentCandidate;
@@ -1037,7 +1146,7 @@ class SubCircuit::SolverWorker
 		}
 	}
 
-	bool prunePortmapCandidates(std::vector<std::set<std::map<std::string, std::string>>> &portmapCandidates, std::vector<std::set<int>> enumerationMatrix, const GraphData &needle, const GraphData &haystack)
+	bool prunePortmapCandidates(std::vector<std::set<std::map<std::string, std::string>>> &portmapCandidates, const enumMatrix_t &enumerationMatrix, const GraphData &needle, const GraphData &haystack)
 	{
 		bool didSomething = false;
 
@@ -1045,8 +1154,8 @@ class SubCircuit::SolverWorker
 
 		for (int i = 0; i < int(needle.graph.nodes.size()); i++)
 		{
-			assert(enumerationMatrix[i].size() == 1);
-			int j = *enumerationMatrix[i].begin();
+			assert(enumerationMatrix[i].count() == 1);
+			int j = enumerationMatrix[i].first();
 
 			std::set<std::map<std::string, std::string>> thisCandidates;
 			portmapCandidates[i].swap(thisCandidates);
@@ -1058,8 +1167,8 @@ class SubCircuit::SolverWorker
 					int needleNeighbour = it_needle.first;
 					int needleEdgeType = it_needle.second;
 
-					assert(enumerationMatrix[needleNeighbour].size() == 1);
-					int haystackNeighbour = *enumerationMatrix[needleNeighbour].begin();
+					assert(enumerationMatrix[needleNeighbour].count() == 1);
+					int haystackNeighbour = enumerationMatrix[needleNeighbour].first();
 
 					assert(haystack.adjMatrix.at(j).count(haystackNeighbour) > 0);
 					int haystackEdgeType = haystack.adjMatrix.at(j).at(haystackNeighbour);
@@ -1100,7 +1209,11 @@ class SubCircuit::SolverWorker
 		return false;
 	}
 
-	void ullmannRecursion(std::vector<Solver::Result> &results, std::vector<std::set<int>> &enumerationMatrix, int iter, const GraphData &needle, GraphData &haystack, bool allowOverlap, int limitResults)
+	// with distinctSets != NULL only one solution per set of haystack nodes is
+	// reported (and the haystack nodes are not marked as used). this is used for
+	// mining, where only the matched node sets are of interest.
+	void ullmannRecursion(std::vector<Solver::Result> &results, enumMatrix_t &enumerationMatrix, int iter, const GraphData &needle, GraphData &haystack,
+			bool allowOverlap, int limitResults, std::set<std::vector<int>> *distinctSets = NULL)
 	{
 		int i = -1;
 		if (!pruneEnumerationMatrix(enumerationMatrix, needle, haystack, i, allowOverlap))
@@ -1108,6 +1221,15 @@ class SubCircuit::SolverWorker
 
 		if (i < 0)
 		{
+			std::vector<int> resultNodes;
+			if (distinctSets != NULL) {
+				for (int j = 0; j < int(enumerationMatrix.size()); j++)
+					resultNodes.push_back(enumerationMatrix[j].first());
+				std::sort(resultNodes.begin(), resultNodes.end());
+				if (distinctSets->count(resultNodes) > 0)
+					return;
+			}
+
 			Solver::Result result;
 			result.needleGraphId = needle.graphId;
 			result.haystackGraphId = haystack.graphId;
@@ -1119,8 +1241,8 @@ class SubCircuit::SolverWorker
 				Solver::ResultNodeMapping mapping;
 				mapping.needleNodeId = needle.graph.nodes[j].nodeId;
 				mapping.needleUserData = needle.graph.nodes[j].userData;
-				mapping.haystackNodeId = haystack.graph.nodes[*enumerationMatrix[j].begin()].nodeId;
-				mapping.haystackUserData = haystack.graph.nodes[*enumerationMatrix[j].begin()].userData;
+				mapping.haystackNodeId = haystack.graph.nodes[enumerationMatrix[j].first()].nodeId;
+				mapping.haystackUserData = haystack.graph.nodes[enumerationMatrix[j].first()].userData;
 				generatePortmapCandidates(portmapCandidates[j], enumerationMatrix, needle, haystack, j);
 				result.mappings[needle.graph.nodes[j].nodeId] = mapping;
 			}
@@ -1161,9 +1283,12 @@ class SubCircuit::SolverWorker
 				return;
 			}
 
-			for (int j = 0; j < int(enumerationMatrix.size()); j++)
-				if (!haystack.graph.nodes[*enumerationMatrix[j].begin()].shared)
-					haystack.usedNodes[*enumerationMatrix[j].begin()] = true;
+			if (distinctSets != NULL)
+				distinctSets->insert(resultNodes);
+			else
+				for (int j = 0; j < int(enumerationMatrix.size()); j++)
+					if (!haystack.graph.nodes[enumerationMatrix[j].first()].shared)
+						haystack.usedNodes[enumerationMatrix[j].first()] = true;
 
 			if (verbose) {
 				my_printf("\nSolution:\n");
@@ -1180,10 +1305,10 @@ class SubCircuit::SolverWorker
 			printEnumerationMatrix(enumerationMatrix, haystack.graph.nodes.size());
 		}
 
-		std::set<int> activeRow;
+		NodeBits activeRow(haystack.graph.nodes.size());
 		enumerationMatrix[i].swap(activeRow);
 
-		for (int j : activeRow)
+		for (int j = activeRow.first(); j >= 0; j = activeRow.next(j+1))
 		{
 			// found enough?
 			if (limitResults >= 0 && int(results.size()) >= limitResults)
@@ -1194,13 +1319,13 @@ class SubCircuit::SolverWorker
 				continue;
 
 			// create enumeration matrix for child in recursion tree
-			std::vector<std::set<int>> nextEnumerationMatrix = enumerationMatrix;
+			enumMatrix_t nextEnumerationMatrix = enumerationMatrix;
 			for (int k = 0; k < int(nextEnumerationMatrix.size()); k++)
-				nextEnumerationMatrix[k].erase(j);
-			nextEnumerationMatrix[i].insert(j);
+				nextEnumerationMatrix[k].clear(j);
+			nextEnumerationMatrix[i].set(j);
 
 			// recursion
-			ullmannRecursion(results, nextEnumerationMatrix, iter+1, needle, haystack, allowOverlap, limitResults);
+			ullmannRecursion(results, nextEnumerationMatrix, iter+1, needle, haystack, allowOverlap, limitResults, distinctSets);
 
 			// we just have found something -> unroll to top recursion level
 			if (!allowOverlap && haystack.usedNodes[j] && iter > 0)
@@ -1256,89 +1381,211 @@ class SubCircuit::SolverWorker
 		}
 	};
 
-	void solveForMining(std::vector<Solver::Result> &results, const GraphData &needle)
+	struct MineCandidate
 	{
-		bool backupVerbose = verbose;
-		verbose = false;
+		NodeSet nodeSet;
+		GraphData needle;
+		std::string form;
+		int sameAs;
+		std::vector<NodeSet> matches;
+		MineCandidate(const NodeSet &nodeSet) : nodeSet(nodeSet), sameAs(-1) { }
+	};
+
+	int mineMaxPoolSize, mineThreads;
+
+	static const int maxCanonicalOrders = 5040;
+
+	// canonical form of a needle graph created for mining: needles with the same
+	// form are isomorphic. the nodes are ordered by a label that does not depend
+	// on the order of the nodes in the graph and the adjacency matrix is encoded
+	// for all orders of the nodes with equal labels. the smallest encoding is used.
+	// an empty string is returned if there are too many such orders.
+	std::string canonicalForm(const GraphData &needle) const
+	{
+		const Graph &graph = needle.graph;
+		int numNodes = graph.nodes.size();
+
+		std::vector<std::string> labels(numNodes);
+		for (int i = 0; i < numNodes; i++) {
+			std::map<std::string, std::string> ports;
+			for (const auto &port : graph.nodes[i].ports) {
+				std::string &str = ports[port.portId];
+				for (const auto &bit : port.bits)
+					str += my_stringf(",%d", graph.edges[bit.edgeIdx].constValue);
+			}
+			labels[i] = graph.nodes[i].typeId + "(";
+			for (const auto &it : ports)
+				labels[i] += it.first + it.second + ";";
+			labels[i] += ")";
+		}
+
+		std::vector<std::string> invariants(numNodes);
+		for (int i = 0; i < numNodes; i++) {
+			std::vector<std::string> neighbours;
+			for (const auto &it : needle.adjMatrix[i])
+				neighbours.push_back(my_stringf(">%d:", it.second) + labels[it.first]);
+			for (int j = 0; j < numNodes; j++)
+				if (needle.adjMatrix[j].count(i) > 0)
+					neighbours.push_back(my_stringf("<%d:", needle.adjMatrix[j].at(i)) + labels[j]);
+			std::sort(neighbours.begin(), neighbours.end());
+			invariants[i] = labels[i];
+			for (const auto &str : neighbours)
+				invariants[i] += str;
+		}
+
+		std::vector<int> order;
+		for (int i = 0; i < numNodes; i++)
+			order.push_back(i);
+		std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return invariants[a] < invariants[b]; });
+
+		std::vector<std::pair<int, int>> groups;
+		int numOrders = 1;
+		for (int i = 0, j; i < numNodes; i = j) {
+			for (j = i+1; j < numNodes && invariants[order[j]] == invariants[order[i]]; j++)
+				if ((numOrders *= j-i+1) > maxCanonicalOrders)
+					return std::string();
+			groups.push_back(std::pair<int, int>(i, j));
+		}
+
+		std::string form, bestMatrix;
+		for (int idx : order)
+			form += invariants[idx] + "\n";
+
+		while (1)
+		{
+			std::string matrix;
+			for (int i = 0; i < numNodes; i++)
+			for (int j = 0; j < numNodes; j++) {
+				auto it = needle.adjMatrix[order[i]].find(order[j]);
+				matrix += it == needle.adjMatrix[order[i]].end() ? "-," : my_stringf("%d,", it->second);
+			}
+			if (bestMatrix.empty() || matrix < bestMatrix)
+				bestMatrix = matrix;
+
+			size_t k;
+			for (k = 0; k < groups.size(); k++)
+				if (std::next_permutation(order.begin() + groups[k].first, order.begin() + groups[k].second))
+					break;
+			if (k == groups.size())
+				break;
+		}
+
+		return form + bestMatrix;
+	}
+
+	// create the needle graph for the candidate. returns false if an isomorphic
+	// candidate has already been tested.
+	bool prepareMineCandidate(MineCandidate &candidate, const std::set<std::string> &minedForms)
+	{
+		const std::string &graphId = candidate.nodeSet.graphId;
+		const Graph &graph = graphData.at(graphId).graph;
+
+		std::vector<std::string> needle_nodes;
+		for (int nodeIdx : candidate.nodeSet.nodes)
+			needle_nodes.push_back(graph.nodes[nodeIdx].nodeId);
+		candidate.needle.graph = Graph(graph, needle_nodes);
+		candidate.needle.graph.markAllExtern();
+		diCache.add(candidate.needle.graph, candidate.needle.adjMatrix, graphId, userSolver);
+
+		candidate.form = canonicalForm(candidate.needle);
+		if (!candidate.form.empty() && minedForms.count(candidate.form) > 0)
+			return false;
+
+		// fill the edge compare cache now, so the parallel searches only read it
+		for (const auto &row : candidate.needle.adjMatrix)
+			for (const auto &it : row)
+				for (int i = 0; i < int(diCache.edgeTypes.size()); i++)
+					diCache.compare(it.second, i, swapPorts, swapPermutations);
 
+		return true;
+	}
+
+	// find the distinct sets of matched nodes in all graphs. with a limit for the
+	// number of matches per graph the search stops when the limit is reached.
+	void solveMineCandidate(MineCandidate &candidate, int limitMatchesPerGraph)
+	{
 		for (auto &it : graphData)
 		{
 			GraphData &haystack = it.second;
 
-			std::vector<std::set<int>> enumerationMatrix;
+			enumMatrix_t enumerationMatrix;
 			std::map<std::string, std::set<std::string>> initialMappings;
-			generateEnumerationMatrix(enumerationMatrix, needle, haystack, initialMappings);
+			generateEnumerationMatrix(enumerationMatrix, candidate.needle, haystack, initialMappings);
 
-			haystack.usedNodes.resize(haystack.graph.nodes.size());
-			ullmannRecursion(results, enumerationMatrix, 0, needle, haystack, true, -1);
-		}
+			std::vector<Solver::Result> ullmannResults;
+			std::set<std::vector<int>> distinctSets;
+			ullmannRecursion(ullmannResults, enumerationMatrix, 0, candidate.needle, haystack, true, limitMatchesPerGraph, &distinctSets);
 
-		verbose = backupVerbose;
+			for (const auto &nodes : distinctSets)
+				candidate.matches.push_back(NodeSet(it.first, nodes));
+		}
 	}
 
-	int testForMining(std::vector<Solver::MineResult> &results, std::set<NodeSet> &usedSets, std::set<NodeSet> &nextPool, NodeSet &testSet,
-			const std::string &graphId, const Graph &graph, int minNodes, int minMatches, int limitMatchesPerGraph)
+	void solveMineCandidates(std::vector<MineCandidate> &candidates, int limitMatchesPerGraph)
 	{
-		// my_printf("test: %s\n", testSet.to_string().c_str());
+		bool backupVerbose = verbose;
+		verbose = false;
 
-		GraphData needle;
-		std::vector<std::string> needle_nodes;
-		for (int nodeIdx : testSet.nodes)
-			needle_nodes.push_back(graph.nodes[nodeIdx].nodeId);
-		needle.graph = Graph(graph, needle_nodes);
-		needle.graph.markAllExtern();
-		diCache.add(needle.graph, needle.adjMatrix, graphId, userSolver);
+		std::atomic<int> nextIndex(0);
+		auto worker = [&]() {
+			for (int idx = nextIndex++; idx < int(candidates.size()); idx = nextIndex++)
+				if (candidates[idx].sameAs < 0)
+					solveMineCandidate(candidates[idx], limitMatchesPerGraph);
+		};
+
+		std::vector<std::thread> threads;
+		for (int i = 1; i < std::min(mineThreads, int(candidates.size())); i++)
+			threads.push_back(std::thread(worker));
+		worker();
+		for (auto &thread : threads)
+			thread.join();
+
+		// isomorphic needles have the same matches
+		for (auto &candidate : candidates)
+			if (candidate.sameAs >= 0)
+				candidate.matches = candidates[candidate.sameAs].matches;
 
-		std::vector<Solver::Result> ullmannResults;
-		solveForMining(ullmannResults, needle);
+		verbose = backupVerbose;
+	}
 
+	int processMineCandidate(std::vector<Solver::MineResult> &results, std::set<NodeSet> &usedSets, std::set<NodeSet> &nextPool,
+			const MineCandidate &candidate, int minNodes, int minMatches, int limitMatchesPerGraph)
+	{
 		int matches = 0;
 		std::map<std::string, int> matchesPerGraph;
-		std::set<NodeSet> thisNodeSetSet;
 
-		for (auto &it : ullmannResults)
+		for (const auto &match : candidate.matches)
 		{
-			std::vector<int> resultNodes;
-			for (auto &i2 : it.mappings)
-				resultNodes.push_back(graphData[it.haystackGraphId].graph.nodeMap[i2.second.haystackNodeId]);
-			NodeSet resultSet(it.haystackGraphId, resultNodes);
-
-			// my_printf("match: %s%s\n", resultSet.to_string().c_str(), usedSets.count(resultSet) > 0 ? " (dup)" : "");
-
-#if 0
-			if (usedSets.count(resultSet) > 0) {
-				// Because of shorted pins isomorphisim is not always bidirectional!
-				//
-				// This means that the following assert is not true in all cases and subgraph A might
-				// show up in the matches for subgraph B but not vice versa... This also means that the
-				// order in which subgraphs are processed has an impact on the results set.
-				//
-				assert(thisNodeSetSet.count(resultSet) > 0);
-				continue;
-			}
-#else
-			if (thisNodeSetSet.count(resultSet) > 0)
-				continue;
-#endif
+			// Because of shorted pins isomorphisim is not always bidirectional!
+			//
+			// This means that a match of subgraph A might be in usedSets even though it
+			// did not show up in the matches for subgraph B... This also means that the
+			// order in which subgraphs are processed has an impact on the results set.
 
-			usedSets.insert(resultSet);
-			thisNodeSetSet.insert(resultSet);
+			GraphData &haystack = graphData.at(match.graphId);
+			haystack.usedNodes.resize(haystack.graph.nodes.size());
+			for (int nodeIdx : match.nodes)
+				if (!haystack.graph.nodes[nodeIdx].shared)
+					haystack.usedNodes[nodeIdx] = true;
 
-			matchesPerGraph[it.haystackGraphId]++;
-			if (limitMatchesPerGraph < 0 || matchesPerGraph[it.haystackGraphId] < limitMatchesPerGraph)
+			usedSets.insert(match);
+
+			matchesPerGraph[match.graphId]++;
+			if (limitMatchesPerGraph < 0 || matchesPerGraph[match.graphId] < limitMatchesPerGraph)
 				matches++;
 		}
 
 		if (matches < minMatches)
 			return matches;
 
-		if (minNodes <= int(testSet.nodes.size()))
+		if (minNodes <= int(candidate.nodeSet.nodes.size()))
 		{
+			const Graph &graph = graphData.at(candidate.nodeSet.graphId).graph;
 			Solver::MineResult result;
-			result.graphId = graphId;
+			result.graphId = candidate.nodeSet.graphId;
 			result.totalMatchesAfterLimits = matches;
 			result.matchesPerGraph = matchesPerGraph;
-			for (int nodeIdx : testSet.nodes) {
+			for (int nodeIdx : candidate.nodeSet.nodes) {
 				Solver::MineResultNode resultNode;
 				resultNode.nodeId = graph.nodes[nodeIdx].nodeId;
 				resultNode.userData = graph.nodes[nodeIdx].userData;
@@ -1347,14 +1594,89 @@ class SubCircuit::SolverWorker
 			results.push_back(result);
 		}
 
-		nextPool.insert(thisNodeSetSet.begin(), thisNodeSetSet.end());
+		nextPool.insert(candidate.matches.begin(), candidate.matches.end());
 		return matches;
 	}
 
-	void findNodePairs(std::vector<Solver::MineResult> &results, std::set<NodeSet> &nodePairs, int minNodes, int minMatches, int limitMatchesPerGraph)
+	// test the candidates in batches: the needle graphs are created serially, the
+	// searches run in parallel and the results are processed in the original order.
+	// a candidate that is one of the matches of an earlier candidate or isomorphic
+	// to an earlier candidate is skipped. the result does not depend on the batch size.
+	int testMineCandidates(std::vector<Solver::MineResult> &results, const std::vector<NodeSet> &candidateSets, std::set<NodeSet> &usedSets,
+			std::set<NodeSet> &nextPool, std::set<std::string> &minedForms, int minNodes, int minMatches, int limitMatchesPerGraph)
 	{
 		int groupCounter = 0;
+		int batchSize = 16 * std::max(mineThreads, 1);
+
+		for (size_t begin = 0; begin < candidateSets.size(); begin += batchSize)
+		{
+			std::vector<MineCandidate> batch;
+			std::map<std::string, int> batchForms;
+			batch.reserve(batchSize);
+
+			for (size_t i = begin; i < std::min(candidateSets.size(), begin + batchSize); i++) {
+				if (usedSets.count(candidateSets[i]) > 0)
+					continue;
+				batch.push_back(MineCandidate(candidateSets[i]));
+				if (!prepareMineCandidate(batch.back(), minedForms)) {
+					batch.pop_back();
+					continue;
+				}
+				if (!batch.back().form.empty()) {
+					if (batchForms.count(batch.back().form) > 0)
+						batch.back().sameAs = batchForms.at(batch.back().form);
+					else
+						batchForms[batch.back().form] = batch.size()-1;
+				}
+			}
+
+			solveMineCandidates(batch, limitMatchesPerGraph);
+
+			for (const auto &candidate : batch)
+			{
+				if (usedSets.count(candidate.nodeSet) > 0)
+					continue;
+
+				if (!candidate.form.empty()) {
+					if (minedForms.count(candidate.form) > 0)
+						continue;
+					minedForms.insert(candidate.form);
+				}
+
+				int matches = processMineCandidate(results, usedSets, nextPool, candidate, minNodes, minMatches, limitMatchesPerGraph);
+
+				if (verbose) {
+					const Graph &graph = graphData.at(candidate.nodeSet.graphId).graph;
+					my_printf("Found %s[", candidate.nodeSet.graphId.c_str());
+					bool first = true;
+					for (int nodeIdx : candidate.nodeSet.nodes) {
+						my_printf("%s%s", first ? "" : ",", graph.nodes[nodeIdx].nodeId.c_str());
+						first = false;
+					}
+					my_printf("] -> %d%s\n", matches, matches < minMatches ? "  *purge*" : "");
+				}
+
+				if (minMatches <= matches)
+					groupCounter++;
+			}
+
+			// keeping the smallest sets after each batch is the same as keeping
+			// the smallest sets of the complete pool
+			if (mineMaxPoolSize >= 0 && int(nextPool.size()) > mineMaxPoolSize) {
+				auto it = nextPool.begin();
+				std::advance(it, mineMaxPoolSize);
+				nextPool.erase(it, nextPool.end());
+			}
+		}
+
+		return groupCounter;
+	}
+
+	void findNodePairs(std::vector<Solver::MineResult> &results, std::set<NodeSet> &nodePairs, std::set<std::string> &minedForms,
+			int minNodes, int minMatches, int limitMatchesPerGraph)
+	{
 		std::set<NodeSet> usedPairs;
+		std::vector<NodeSet> candidateSets;
 		nodePairs.clear();
 
 		if (verbose)
@@ -1364,33 +1686,18 @@ class SubCircuit::SolverWorker
 		for (int node1 = 0; node1 < int(graph_it.second.graph.nodes.size()); node1++)
 		for (auto &adj_it : graph_it.second.adjMatrix.at(node1))
 		{
-			const std::string &graphId = graph_it.first;
-			const auto &graph = graph_it.second.graph;
 			int node2 = adj_it.first;
-
-			if (node1 == node2)
-				continue;
-
-			NodeSet pair(graphId, node1, node2);
-
-			if (usedPairs.count(pair) > 0)
-				continue;
-
-			int matches = testForMining(results, usedPairs, nodePairs, pair, graphId, graph, minNodes, minMatches, limitMatchesPerGraph);
-
-			if (verbose)
-				my_printf("Pair %s[%s,%s] -> %d%s\n", graphId.c_str(), graph.nodes[node1].nodeId.c_str(),
-						graph.nodes[node2].nodeId.c_str(), matches, matches < minMatches ? "  *purge*" : "");
-
-			if (minMatches <= matches)
-				groupCounter++;
+			if (node1 < node2 || (node1 > node2 && graph_it.second.adjMatrix.at(node2).count(node1) == 0))
+				candidateSets.push_back(NodeSet(graph_it.first, node1, node2));
 		}
 
+		int groupCounter = testMineCandidates(results, candidateSets, usedPairs, nodePairs, minedForms, minNodes, minMatches, limitMatchesPerGraph);
+
 		if (verbose)
 			my_printf("Found a total of %d subgraphs in %d groups.\n", int(nodePairs.size()), groupCounter);
 	}
 
-	void findNextPool(std::vector<Solver::MineResult> &results, std::set<NodeSet> &pool,
+	void findNextPool(std::vector<Solver::MineResult> &results, std::set<NodeSet> &pool, std::set<std::string> &minedForms,
 			int oldSetSize, int increment, int minNodes, int minMatches, int limitMatchesPerGraph)
 	{
 		int groupCounter = 0;
@@ -1403,18 +1710,18 @@ class SubCircuit::SolverWorker
 		if (verbose)
 			my_printf("\nMining for frequent subcircuits of size %d using increment %d:\n", oldSetSize+increment, increment);
 
-		int count = 0;
 		for (auto &it : poolPerGraph)
 		{
 			std::map<int, std::set<int>> node2sets;
-			std::set<NodeSet> usedSets;
+			std::set<NodeSet> usedSets, candidateSetsSet;
+			std::vector<NodeSet> candidateSets;
 
 			for (int idx = 0; idx < int(it.second.size()); idx++) {
 				for (int node : it.second[idx]->nodes)
 					node2sets[node].insert(idx);
 			}
 
-			for (int idx1 = 0; idx1 < int(it.second.size()); idx1++, count++)
+			for (int idx1 = 0; idx1 < int(it.second.size()); idx1++)
 			{
 				std::set<int> idx2set;
 
@@ -1431,31 +1738,14 @@ class SubCircuit::SolverWorker
 					NodeSet mergedSet = *it.second[idx1];
 					mergedSet.extend(*it.second[idx2]);
 
-					if (usedSets.count(mergedSet) > 0)
-						continue;
-
-					const std::string &graphId = it.first;
-					const auto &graph = graphData[it.first].graph;
-
-					if (verbose) {
-						my_printf("<%d%%/%d> Found %s[", int(100*count/pool.size()), oldSetSize+increment, graphId.c_str());
-						bool first = true;
-						for (int nodeIdx : mergedSet.nodes) {
-							my_printf("%s%s", first ? "" : ",", graph.nodes[nodeIdx].nodeId.c_str());
-							first = false;
-						}
-						my_printf("] ->");
+					if (candidateSetsSet.count(mergedSet) == 0) {
+						candidateSetsSet.insert(mergedSet);
+						candidateSets.push_back(mergedSet);
 					}
-
-					int matches = testForMining(results, usedSets, nextPool, mergedSet, graphId, graph, minNodes, minMatches, limitMatchesPerGraph);
-
-					if (verbose)
-						my_printf(" %d%s\n", matches, matches < minMatches ? "  *purge*" : "");
-
-					if (minMatches <= matches)
-						groupCounter++;
 				}
 			}
+
+			groupCounter += testMineCandidates(results, candidateSets, usedSets, nextPool, minedForms, minNodes, minMatches, limitMatchesPerGraph);
 		}
 
 		pool.swap(nextPool);
@@ -1467,7 +1757,7 @@ class SubCircuit::SolverWorker
 	// interface to the public solver class
 
 protected:
-	SolverWorker(Solver *userSolver) : userSolver(userSolver), verbose(false)
+	SolverWorker(Solver *userSolver) : userSolver(userSolver), verbose(false), mineMaxPoolSize(-1), mineThreads(1)
 	{
 	}
 
@@ -1484,6 +1774,7 @@ protected:
 		gd.graphId = graphId;
 		gd.graph = graph;
 		diCache.add(gd.graph, gd.adjMatrix, graphId, userSolver);
+		generateAdjBits(gd);
 	}
 
 	void addCompatibleTypes(std::string needleTypeId, std::string haystackTypeId)
@@ -1517,7 +1808,7 @@ protected:
 		const GraphData &needle = graphData[needleGraphId];
 		GraphData &haystack = graphData[haystackGraphId];
 
-		std::vector<std::set<int>> enumerationMatrix;
+		enumMatrix_t enumerationMatrix;
 		generateEnumerationMatrix(enumerationMatrix, needle, haystack, initialMappings);
 
 		if (verbose)
@@ -1553,11 +1844,15 @@ protected:
 		ullmannRecursion(results, enumerationMatrix, 0, needle, haystack, allowOverlap, maxSolutions > 0 ? results.size() + maxSolutions : -1);
 	}
 
-	void mine(std::vector<Solver::MineResult> &results, int minNodes, int maxNodes, int minMatches, int limitMatchesPerGraph)
+	void mine(std::vector<Solver::MineResult> &results, int minNodes, int maxNodes, int minMatches, int limitMatchesPerGraph, int maxPoolSize, int numThreads)
 	{
+		mineMaxPoolSize = maxPoolSize;
+		mineThreads = numThreads;
+
 		int nodeSetSize = 2;
 		std::set<NodeSet> pool;
-		findNodePairs(results, pool, minNodes, minMatches, limitMatchesPerGraph);
+		std::set<std::string> minedForms;
+		findNodePairs(results, pool, minedForms, minNodes, minMatches, limitMatchesPerGraph);
 
 		while ((maxNodes < 0 || nodeSetSize < maxNodes) && pool.size() > 0)
 		{
@@ -1567,7 +1862,7 @@ protected:
 			if (nodeSetSize >= minNodes)
 				increment = 1;
 
-			findNextPool(results, pool, nodeSetSize, increment, minNodes, minMatches, limitMatchesPerGraph);
+			findNextPool(results, pool, minedForms, nodeSetSize, increment, minNodes, minMatches, limitMatchesPerGraph);
 			nodeSetSize += increment;
 		}
 	}
@@ -1673,9 +1968,9 @@ void SubCircuit::Solver::solve(std::vector<Result> &results, std::string needleG
 	worker->solve(results, needleGraphId, haystackGraphId, initialMappings, allowOverlap, maxSolutions);
 }
 
-void SubCircuit::Solver::mine(std::vector<MineResult> &results, int minNodes, int maxNodes, int minMatches, int limitMatchesPerGraph)
+void SubCircuit::Solver::mine(std::vector<MineResult> &results, int minNodes, int maxNodes, int minMatches, int limitMatchesPerGraph, int maxPoolSize, int numThreads)
 {
-	worker->mine(results, minNodes, maxNodes, minMatches, limitMatchesPerGraph);
+	worker->mine(results, minNodes, maxNodes, minMatches, limitMatchesPerGraph, maxPoolSize, numThreads);
 }
 
 void SubCircuit::Solver::clearOverlapHistory()
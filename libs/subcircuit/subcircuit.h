@@ -145,7 +145,7 @@ namespace SubCircuit
 		void solve(std::vector<Result> &results, std::string needleGraphId, std::string haystackGraphId,
 				const std::map<std::string, std::set<std::string>> &initialMapping, bool allowOverlap = true, int maxSolutions = -1);
 
-		void mine(std::vector<MineResult> &results, int minNodes, int maxNodes, int minMatches, int limitMatchesPerGraph = -1);
+		void mine(std::vector<MineResult> &results, int minNodes, int maxNodes, int minMatches, int limitMatchesPerGraph = -1, int maxPoolSize = -1, int numThreads = 1);
 
 		void clearOverlapHistory();
 		void clearConfig();
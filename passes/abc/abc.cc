@@ -38,6 +38,10 @@
 #include "kernel/sigtools.h"
 #include "kernel/log.h"
 #include <unistd.h>
+#include <utime.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
 #include <stdlib.h>
 #include <assert.h>
 #include <stdio.h>
@@ -46,8 +50,18 @@
 #include <cerrno>
 #include <sstream>
 #include <climits>
+#include <algorithm>
+#include <tuple>
+#include <functional>
+#include <thread>
+#include <atomic>
 
-#include "blifparse.h"
+#include "libs/sha1/sha1.h"
+#include "frontends/blif/blifparse.h"
+
+#ifdef __linux__
+#  include <sys/syscall.h>
+#endif
 
 struct gate_t
 {
@@ -67,6 +81,50 @@ static std::map<RTLIL::SigSpec, int> signal_map;
 static bool clk_polarity;
 static RTLIL::SigSpec clk_sig;
 
+// everything that is needed to run ABC on one module and to re-integrate the
+// results later, so that the ABC processes for many modules can run in parallel
+struct abc_job_t
+{
+	RTLIL::Module *module;
+	int map_autoidx;
+	std::vector<gate_t> signal_list;
+	bool clk_polarity;
+	RTLIL::SigSpec clk_sig;
+
+	std::string tempdir_name, exe_file, command;
+	bool builtin_lib;
+	int count_output;
+
+	// the ABC input files (name and contents) and the ABC output netlist. the files
+	// are written to the temp directory, or passed to ABC as in-memory files when
+	// use_pipes is set (see -pipe). key_command is the ABC command line with all
+	// file names relative to "<tempdir>", for the cache key.
+	bool use_pipes, got_output;
+	std::vector<std::pair<std::string, std::string>> input_files;
+	std::string output_data, key_command;
+
+	// set for the clusters of a partitioned module (see -partition)
+	int partition_idx, partition_count, cut_signals;
+	bool qor_reference;
+	std::map<std::string, int> cell_stats;
+
+	// set when the ABC result cache is used (see -cache)
+	std::string cache_file;
+	bool cache_hit, cache_stored;
+
+	std::vector<std::string> output_lines;
+	std::string error;
+	int ret;
+
+	abc_job_t() : module(NULL), map_autoidx(0), clk_polarity(true), builtin_lib(false), count_output(0),
+			use_pipes(false), got_output(false), partition_idx(0), partition_count(0), cut_signals(0), qor_reference(false),
+			cache_hit(false), cache_stored(false), ret(0) { }
+};
+
+static std::string abc_cache_dir;
+static int abc_cache_hits, abc_cache_misses, abc_cache_stored;
+static bool abc_use_pipes;
+
 static int map_signal(RTLIL::SigSpec sig, char gate_type = -1, int in1 = -1, int in2 = -1, int in3 = -1)
 {
 	assert(sig.width == 1);
@@ -409,120 +467,405 @@ static std::string fold_abc_cmd(std::string str)
 	return new_str;
 }
 
-static void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::string script_file, std::string exe_file,
-		std::string liberty_file, std::string constr_file, bool cleanup, int lut_mode, bool dff_mode, std::string clk_str, bool keepff)
+static std::string make_tempdir(bool cleanup)
 {
-	module = current_module;
-	map_autoidx = RTLIL::autoidx++;
-
-	signal_map.clear();
-	signal_list.clear();
-	assign_map.set(module);
-
-	clk_polarity = true;
-	clk_sig = RTLIL::SigSpec();
-
 	char tempdir_name[] = "/tmp/yosys-abc-XXXXXX";
 	if (!cleanup)
 		tempdir_name[0] = tempdir_name[4] = '_';
-	char *p = mkdtemp(tempdir_name);
-	log_header("Extracting gate netlist of module `%s' to `%s/input.blif'..\n", module->name.c_str(), tempdir_name);
-	if (p == NULL)
+	if (mkdtemp(tempdir_name) == NULL)
 		log_error("For some reason mkdtemp() failed!\n");
+	return tempdir_name;
+}
 
-	std::string abc_command;
-	if (!script_file.empty()) {
-		if (script_file[0] == '+') {
-			for (size_t i = 1; i < script_file.size(); i++)
-				if (script_file[i] == '\'')
-					abc_command += "'\\''";
-				else if (script_file[i] == ',')
-					abc_command += " ";
-				else
-					abc_command += script_file[i];
-		} else
-			abc_command = stringf("source %s", script_file.c_str());
-	} else if (lut_mode)
-		abc_command = ABC_COMMAND_LUT;
-	else if (!liberty_file.empty())
-		abc_command = constr_file.empty() ? ABC_COMMAND_LIB : ABC_COMMAND_CTR;
-	else
-		abc_command = ABC_COMMAND_DFL;
-	abc_command = add_echos_to_abc_cmd(abc_command);
-
-	if (abc_command.size() > 128) {
-		for (size_t i = 0; i+1 < abc_command.size(); i++)
-			if (abc_command[i] == ';' && abc_command[i+1] == ' ')
-				abc_command[i+1] = '\n';
-		FILE *f = fopen(stringf("%s/abc.script", tempdir_name).c_str(), "wt");
-		fprintf(f, "%s\n", abc_command.c_str());
-		fclose(f);
-		abc_command = stringf("source %s/abc.script", tempdir_name);
-	}
+// split the extracted gate netlist in clusters of at most max_size gates. the
+// netlist is first cut at the register outputs, the connected components of
+// what remains are split by greedy graph growing (always adding the gate with
+// the most connections into the current cluster) and the resulting pieces are
+// packed into as few clusters as possible. returns the number of cut signals.
+static int partition_signal_list(int max_size, std::vector<std::vector<gate_t>> &parts)
+{
+	int num_signals = signal_list.size();
+	std::vector<std::vector<int>> adjacent(num_signals), readers(num_signals);
+	std::vector<int> level(num_signals), in_count(num_signals);
 
-	if (clk_str.empty()) {
-		if (clk_str[0] == '!') {
-			clk_polarity = false;
-			clk_str = clk_str.substr(1);
+	for (auto &si : signal_list) {
+		if (si.type < 0)
+			continue;
+		for (int in : { si.in1, si.in2, si.in3 }) {
+			if (in < 0)
+				continue;
+			readers[in].push_back(si.id);
+			if (signal_list[in].type >= 0 && signal_list[in].type != 'f') {
+				adjacent[si.id].push_back(in);
+				adjacent[in].push_back(si.id);
+				in_count[si.id]++;
+			}
 		}
-		if (module->wires.count(RTLIL::escape_id(clk_str)) != 0)
-			clk_sig = assign_map(RTLIL::SigSpec(module->wires.at(RTLIL::escape_id(clk_str)), 1));
 	}
 
-	if (dff_mode && clk_sig.width == 0)
+	// the combinatorial part of the netlist is acyclic after handle_loops()
+	std::vector<int> queue;
+	for (auto &si : signal_list)
+		if (si.type >= 0 && in_count[si.id] == 0)
+			queue.push_back(si.id);
+	for (size_t i = 0; i < queue.size(); i++)
+		for (int id : readers[queue[i]])
+			if (signal_list[queue[i]].type != 'f') {
+				level[id] = std::max(level[id], level[queue[i]] + 1);
+				if (--in_count[id] == 0)
+					queue.push_back(id);
+			}
+
+	std::vector<std::vector<int>> chunks;
+	std::vector<int> chunk_of(num_signals, -1), gain(num_signals);
+
+	for (auto &seed_si : signal_list)
 	{
-		int best_dff_counter = 0;
-		std::map<std::pair<bool, RTLIL::SigSpec>, int> dff_counters;
+		if (seed_si.type < 0 || chunk_of[seed_si.id] >= 0)
+			continue;
 
-		for (auto &it : module->cells)
+		std::vector<int> component;
+		component.push_back(seed_si.id);
+		chunk_of[seed_si.id] = -2;
+		for (size_t i = 0; i < component.size(); i++)
+			for (int id : adjacent[component[i]])
+				if (chunk_of[id] == -1)
+					chunk_of[id] = -2, component.push_back(id);
+
+		if (int(component.size()) <= max_size) {
+			for (int id : component)
+				chunk_of[id] = chunks.size();
+			chunks.push_back(component);
+			continue;
+		}
+
+		std::sort(component.begin(), component.end(), [&](int a, int b) {
+			return std::make_pair(level[a], a) < std::make_pair(level[b], b);
+		});
+
+		size_t next_seed = 0;
+		std::set<std::tuple<int, int, int>> frontier;
+
+		while (1)
 		{
-			RTLIL::Cell *cell = it.second;
-			if (cell->type != "$_DFF_N_" && cell->type != "$_DFF_P_")
-				continue;
+			while (next_seed < component.size() && chunk_of[component[next_seed]] != -2)
+				next_seed++;
+			if (next_seed == component.size())
+				break;
 
-			std::pair<bool, RTLIL::SigSpec> key(cell->type == "$_DFF_P_", assign_map(cell->connections.at("\\C")));
-			if (++dff_counters[key] > best_dff_counter) {
-				best_dff_counter = dff_counters[key];
-				clk_polarity = key.first;
-				clk_sig = key.second;
+			std::vector<int> chunk;
+			while (int(chunk.size()) < max_size)
+			{
+				int id;
+				if (frontier.empty()) {
+					while (next_seed < component.size() && chunk_of[component[next_seed]] != -2)
+						next_seed++;
+					if (next_seed == component.size())
+						break;
+					id = component[next_seed];
+				} else {
+					id = std::get<2>(*frontier.begin());
+					frontier.erase(frontier.begin());
+				}
+
+				chunk_of[id] = chunks.size();
+				chunk.push_back(id);
+
+				for (int nb : adjacent[id]) {
+					if (chunk_of[nb] != -2)
+						continue;
+					frontier.erase(std::make_tuple(-gain[nb], level[nb], nb));
+					frontier.insert(std::make_tuple(-(++gain[nb]), level[nb], nb));
+				}
 			}
+
+			for (auto &it : frontier)
+				gain[std::get<2>(it)] = 0;
+			frontier.clear();
+			chunks.push_back(chunk);
 		}
 	}
 
-	if (dff_mode || !clk_str.empty()) {
-		if (clk_sig.width == 0)
-			log("No (matching) clock domain found. Not extracting any FF cells.\n");
-		else
-			log("Found (matching) %s clock domain: %s\n", clk_polarity ? "posedge" : "negedge", log_signal(clk_sig));
+	// best-fit decreasing packing of the chunks into clusters
+	std::vector<int> chunk_order(chunks.size()), part_of_chunk(chunks.size());
+	for (size_t i = 0; i < chunks.size(); i++)
+		chunk_order[i] = i;
+	std::stable_sort(chunk_order.begin(), chunk_order.end(), [&](int a, int b) {
+		return chunks[a].size() > chunks[b].size();
+	});
+
+	int num_parts = 0;
+	std::set<std::pair<int, int>> free_space;
+	for (int idx : chunk_order) {
+		int size = chunks[idx].size();
+		auto it = free_space.lower_bound(std::make_pair(size, 0));
+		if (it == free_space.end()) {
+			part_of_chunk[idx] = num_parts;
+			free_space.insert(std::make_pair(max_size - size, num_parts++));
+		} else {
+			part_of_chunk[idx] = it->second;
+			free_space.insert(std::make_pair(it->first - size, it->second));
+			free_space.erase(it);
+		}
 	}
 
-	if (clk_sig.width != 0)
-		mark_port(clk_sig);
+	std::vector<int> part_of(num_signals, -1);
+	for (auto &si : signal_list)
+		if (si.type >= 0)
+			part_of[si.id] = part_of_chunk[chunk_of[si.id]];
 
-	std::vector<RTLIL::Cell*> cells;
-	cells.reserve(module->cells.size());
-	for (auto &it : module->cells)
-		if (design->selected(current_module, it.second))
-			cells.push_back(it.second);
-	for (auto c : cells)
-		extract_cell(c, keepff);
+	int cut_signals = 0;
+	for (auto &si : signal_list) {
+		if (si.type < 0)
+			continue;
+		for (int id : readers[si.id])
+			if (part_of[id] != part_of[si.id]) {
+				cut_signals++;
+				break;
+			}
+	}
 
-	for (auto &wire_it : module->wires) {
-		if (wire_it.second->port_id > 0 || wire_it.second->get_bool_attribute("\\keep"))
-			mark_port(RTLIL::SigSpec(wire_it.second));
+	// each cluster gets its own copy of the gates and the signals driving them,
+	// with signals that cross the cluster boundary marked as ports
+	parts.clear();
+	parts.resize(num_parts);
+	std::vector<int> local_id(num_signals, -1), marker(num_signals, -1);
+
+	for (int part = 0; part < num_parts; part++)
+	{
+		std::vector<int> used;
+		for (auto &si : signal_list) {
+			if (part_of[si.id] != part)
+				continue;
+			for (int id : { si.id, si.in1, si.in2, si.in3 })
+				if (id >= 0 && marker[id] != part)
+					marker[id] = part, used.push_back(id);
+		}
+		std::sort(used.begin(), used.end());
+
+		for (int id : used)
+			local_id[id] = parts[part].size(), parts[part].push_back(signal_list[id]);
+
+		for (auto &gate : parts[part]) {
+			if (part_of[gate.id] == part) {
+				for (int id : readers[gate.id])
+					if (part_of[id] != part)
+						gate.is_port = true;
+				gate.in1 = gate.in1 >= 0 ? local_id[gate.in1] : -1;
+				gate.in2 = gate.in2 >= 0 ? local_id[gate.in2] : -1;
+				gate.in3 = gate.in3 >= 0 ? local_id[gate.in3] : -1;
+			} else {
+				gate.type = -1;
+				gate.in1 = gate.in2 = gate.in3 = -1;
+				if (gate.sig.chunks[0].wire != NULL)
+					gate.is_port = true;
+			}
+			gate.id = local_id[gate.id];
+		}
 	}
 
-	for (auto &cell_it : module->cells)
-	for (auto &port_it : cell_it.second->connections)
-		mark_port(port_it.second);
-	
-	handle_loops();
+	return cut_signals;
+}
+
+static bool read_file(std::string filename, std::string &data)
+{
+	FILE *f = fopen(filename.c_str(), "rb");
+	if (f == NULL)
+		return false;
+	char buffer[4096];
+	size_t n;
+	data.clear();
+	while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0)
+		data.append(buffer, n);
+	fclose(f);
+	return true;
+}
 
-	if (asprintf(&p, "%s/input.blif", tempdir_name) < 0) log_abort();
-	FILE *f = fopen(p, "wt");
+static bool write_file(std::string filename, const std::string &data)
+{
+	FILE *f = fopen(filename.c_str(), "wb");
 	if (f == NULL)
-		log_error("Opening %s for writing failed: %s\n", p, strerror(errno));
-	free(p);
+		return false;
+	bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+	return fclose(f) == 0 && ok;
+}
+
+// in-memory files for passing data to ABC without a temp directory (see -pipe)
+static int abc_memfd_create(const char *name)
+{
+#if defined(__linux__) && defined(SYS_memfd_create)
+	return syscall(SYS_memfd_create, name, 1 /* MFD_CLOEXEC */);
+#else
+	(void)name;
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+// the pipe must be created close-on-exec atomically: with -j another worker
+// thread could fork between pipe() and fcntl() and its ABC process would then
+// hold the write end open and delay the EOF for this job.
+static int abc_pipe_cloexec(int fds[2])
+{
+#if defined(__linux__)
+	return pipe2(fds, O_CLOEXEC);
+#else
+	(void)fds;
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+static bool abc_memfd_supported()
+{
+	int fd = abc_memfd_create("yosys-abc-test");
+	if (fd < 0)
+		return false;
+	close(fd);
+	return true;
+}
+
+// the path under which ABC finds an input file (or the output file "output.blif").
+// in pipe mode the files are passed as file descriptors 3, 4, ... to ABC.
+static std::string abc_job_path(const abc_job_t &job, std::string name)
+{
+	if (!job.use_pipes)
+		return job.tempdir_name + "/" + name;
+	for (size_t i = 0; i < job.input_files.size(); i++)
+		if (job.input_files[i].first == name)
+			return stringf("/dev/fd/%d", int(i) + 3);
+	return stringf("/dev/fd/%d", int(job.input_files.size()) + 3);
+}
+
+static std::string abc_job_input_desc(const abc_job_t &job)
+{
+	return job.use_pipes ? std::string("memory") : "`" + job.tempdir_name + "/input.blif'";
+}
+
+// identify the ABC binary by its resolved path, size and modification time
+static std::string abc_exe_identity(std::string exe_file)
+{
+	std::vector<std::string> candidates;
+	if (exe_file.find('/') == std::string::npos && getenv("PATH") != NULL) {
+		std::stringstream path(getenv("PATH"));
+		std::string dir;
+		while (std::getline(path, dir, ':'))
+			candidates.push_back((dir.empty() ? "." : dir) + "/" + exe_file);
+	} else
+		candidates.push_back(exe_file);
+
+	for (auto &filename : candidates) {
+		struct stat st;
+		if (stat(filename.c_str(), &st) == 0 && S_ISREG(st.st_mode))
+			return stringf("%s %lld %lld", filename.c_str(), (long long)st.st_size, (long long)st.st_mtime);
+	}
+	return exe_file;
+}
+
+// the cache key is the hash of everything that has an influence on the ABC output:
+// the ABC binary, the command line, all ABC input files (without the comment lines
+// in input.blif that only carry signal names) and the external script, liberty and
+// constraints files.
+static void abc_job_cache_key(abc_job_t &job, std::string script_file, std::string liberty_file, std::string constr_file)
+{
+	std::string data = "exe " + abc_exe_identity(job.exe_file) + "\n";
+	data += "command " + job.key_command + "\n";
+
+	std::vector<std::string> file_names = { "input.blif", "stdcells.genlib", "lutdefs.txt", "abc.script" };
+	std::vector<std::string> files(file_names.size());
+	for (auto &it : job.input_files)
+		files[std::find(file_names.begin(), file_names.end(), it.first) - file_names.begin()] = it.second;
+
+	std::vector<std::string> ext_files = { liberty_file, constr_file };
+	if (!script_file.empty() && script_file[0] != '+')
+		ext_files.push_back(script_file);
+	for (auto &filename : ext_files) {
+		std::string contents;
+		if (!filename.empty())
+			read_file(filename, contents);
+		files.push_back(contents);
+	}
+
+	for (size_t i = 0; i < files.size(); i++) {
+		std::string contents = files[i];
+		if (contents.empty())
+			continue;
+		if (i == 0) {
+			std::stringstream ss(files[i]);
+			std::string line;
+			contents.clear();
+			while (std::getline(ss, line))
+				if (line.compare(0, 1, "#") != 0)
+					contents += line + "\n";
+		}
+		data += stringf("file %d %zd\n", int(i), contents.size());
+		data += contents;
+	}
+
+	unsigned char hash[20];
+	char hash_hex_string[41];
+	sha1::calc(data.c_str(), data.size(), hash);
+	sha1::toHexString(hash, hash_hex_string);
+	job.cache_file = abc_cache_dir + "/" + hash_hex_string + ".blif";
+}
+
+// remove the least recently used entries until the cache is smaller than max_size bytes
+static void abc_cache_trim(long long max_size)
+{
+	std::vector<std::pair<time_t, std::string>> entries;
+	long long total_size = 0;
+	int evicted = 0;
+
+	struct dirent **namelist;
+	int n = scandir(abc_cache_dir.c_str(), &namelist, 0, alphasort);
+	for (int i = 0; i < n; i++) {
+		std::string name = namelist[i]->d_name;
+		struct stat st;
+		if (name.size() == 45 && name.substr(40) == ".blif" && stat((abc_cache_dir + "/" + name).c_str(), &st) == 0) {
+			entries.push_back(std::pair<time_t, std::string>(st.st_mtime, name));
+			total_size += st.st_size;
+		}
+		free(namelist[i]);
+	}
+	if (n >= 0)
+		free(namelist);
+
+	std::sort(entries.begin(), entries.end());
+	for (auto &it : entries) {
+		if (total_size <= max_size)
+			break;
+		struct stat st;
+		std::string filename = abc_cache_dir + "/" + it.second;
+		if (stat(filename.c_str(), &st) == 0 && remove(filename.c_str()) == 0)
+			total_size -= st.st_size, evicted++;
+	}
+
+	log("ABC cache `%s': %d hits, %d misses, %d new entries.\n", abc_cache_dir.c_str(), abc_cache_hits, abc_cache_misses, abc_cache_stored);
+	log("ABC cache `%s': %d entries (%.1f MB) after evicting %d entries.\n", abc_cache_dir.c_str(),
+			int(entries.size()) - evicted, total_size / 1048576.0, evicted);
+}
+
+// create the ABC input files for a job (and write them to its temp directory unless
+// pipe mode is used) and set up the ABC command line
+static void abc_job_write(abc_job_t &job, std::string abc_command, std::string exe_file,
+		std::string script_file, std::string liberty_file, std::string constr_file, int lut_mode)
+{
+	std::vector<gate_t> &signal_list = job.signal_list;
+	bool use_script = false;
+
+	if (abc_command.size() > 128) {
+		for (size_t i = 0; i+1 < abc_command.size(); i++)
+			if (abc_command[i] == ';' && abc_command[i+1] == ' ')
+				abc_command[i+1] = '\n';
+		job.input_files.push_back(std::pair<std::string, std::string>("abc.script", abc_command + "\n"));
+		use_script = true;
+	}
+
+	char *buffer;
+	size_t buffer_size;
+	FILE *f = open_memstream(&buffer, &buffer_size);
+	if (f == NULL)
+		log_error("Opening memory stream for the ABC input netlist failed: %s\n", strerror(errno));
 
 	fprintf(f, ".model netlist\n");
 
@@ -591,110 +934,498 @@ static void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std
 	fprintf(f, ".end\n");
 	fclose(f);
 
+	job.input_files.push_back(std::pair<std::string, std::string>("input.blif", std::string(buffer, buffer_size)));
+	free(buffer);
+
 	log("Extracted %d gates and %zd wires to a netlist network with %d inputs and %d outputs.\n",
 			count_gates, signal_list.size(), count_input, count_output);
-	log_push();
-	
+
+	job.count_output = count_output;
+
 	if (count_output > 0)
 	{
-		log_header("Executing ABC.\n");
-
-		if (asprintf(&p, "%s/stdcells.genlib", tempdir_name) < 0) log_abort();
-		f = fopen(p, "wt");
-		if (f == NULL)
-			log_error("Opening %s for writing failed: %s\n", p, strerror(errno));
-		fprintf(f, "GATE ZERO 1 Y=CONST0;\n");
-		fprintf(f, "GATE ONE  1 Y=CONST1;\n");
-		fprintf(f, "GATE BUF  1 Y=A;                  PIN * NONINV  1 999 1 0 1 0\n");
-		fprintf(f, "GATE INV  1 Y=!A;                 PIN * INV     1 999 1 0 1 0\n");
-		fprintf(f, "GATE AND  1 Y=A*B;                PIN * NONINV  1 999 1 0 1 0\n");
-		fprintf(f, "GATE OR   1 Y=A+B;                PIN * NONINV  1 999 1 0 1 0\n");
-		fprintf(f, "GATE XOR  1 Y=(A*!B)+(!A*B);      PIN * UNKNOWN 1 999 1 0 1 0\n");
-		fprintf(f, "GATE MUX  1 Y=(A*B)+(S*B)+(!S*A); PIN * UNKNOWN 1 999 1 0 1 0\n");
-		fclose(f);
-		free(p);
+		job.input_files.push_back(std::pair<std::string, std::string>("stdcells.genlib",
+				"GATE ZERO 1 Y=CONST0;\n"
+				"GATE ONE  1 Y=CONST1;\n"
+				"GATE BUF  1 Y=A;                  PIN * NONINV  1 999 1 0 1 0\n"
+				"GATE INV  1 Y=!A;                 PIN * INV     1 999 1 0 1 0\n"
+				"GATE AND  1 Y=A*B;                PIN * NONINV  1 999 1 0 1 0\n"
+				"GATE OR   1 Y=A+B;                PIN * NONINV  1 999 1 0 1 0\n"
+				"GATE XOR  1 Y=(A*!B)+(!A*B);      PIN * UNKNOWN 1 999 1 0 1 0\n"
+				"GATE MUX  1 Y=(A*B)+(S*B)+(!S*A); PIN * UNKNOWN 1 999 1 0 1 0\n"));
 
 		if (lut_mode) {
-			if (asprintf(&p, "%s/lutdefs.txt", tempdir_name) < 0) log_abort();
-			f = fopen(p, "wt");
-			if (f == NULL)
-				log_error("Opening %s for writing failed: %s\n", p, strerror(errno));
+			std::string lutdefs;
 			for (int i = 0; i < lut_mode; i++)
-				fprintf(f, "%d 1.00 1.00\n", i+1);
-			fclose(f);
-			free(p);
+				lutdefs += stringf("%d 1.00 1.00\n", i+1);
+			job.input_files.push_back(std::pair<std::string, std::string>("lutdefs.txt", lutdefs));
+		}
+
+		auto build_command = [&](std::function<std::string(std::string)> path) -> std::string
+		{
+			std::string command = use_script ? "source " + path("abc.script") : abc_command;
+			std::string buffer;
+			if (!liberty_file.empty()) {
+				buffer += stringf("%s -s -c 'read_blif %s; read_lib -w %s; ",
+						exe_file.c_str(), path("input.blif").c_str(), liberty_file.c_str());
+				if (!constr_file.empty())
+					buffer += stringf("read_constr -v %s; ", constr_file.c_str());
+				buffer += command + "; ";
+			} else
+			if (lut_mode)
+				buffer += stringf("%s -s -c 'read_blif %s; read_lut %s; %s; ",
+						exe_file.c_str(), path("input.blif").c_str(), path("lutdefs.txt").c_str(), command.c_str());
+			else
+				buffer += stringf("%s -s -c 'read_blif %s; read_library %s; %s; ",
+						exe_file.c_str(), path("input.blif").c_str(), path("stdcells.genlib").c_str(), command.c_str());
+			buffer += stringf("write_blif %s' 2>&1", path("output.blif").c_str());
+			return buffer;
+		};
+
+		job.command = build_command([&](std::string name) { return abc_job_path(job, name); });
+		job.key_command = build_command([](std::string name) { return "<tempdir>/" + name; });
+
+		if (!abc_cache_dir.empty())
+			abc_job_cache_key(job, script_file, liberty_file, constr_file);
+	}
+
+	if (!job.use_pipes)
+		for (auto &it : job.input_files) {
+			std::string filename = job.tempdir_name + "/" + it.first;
+			if (!write_file(filename, it.second))
+				log_error("Writing %s failed: %s\n", filename.c_str(), strerror(errno));
 		}
+}
+
+static void abc_module_extract(std::vector<abc_job_t> &jobs, RTLIL::Design *design, RTLIL::Module *current_module, std::string script_file, std::string exe_file,
+		std::string liberty_file, std::string constr_file, bool cleanup, int lut_mode, bool dff_mode, std::string clk_str, bool keepff,
+		int partition_size, bool partition_qor)
+{
+	module = current_module;
+	map_autoidx = RTLIL::autoidx++;
+
+	signal_map.clear();
+	signal_list.clear();
+	assign_map.set(module);
 
-		std::string buffer;
-		if (!liberty_file.empty()) {
-			buffer += stringf("%s -s -c 'read_blif %s/input.blif; read_lib -w %s; ",
-					exe_file.c_str(), tempdir_name, liberty_file.c_str());
-			if (!constr_file.empty())
-				buffer += stringf("read_constr -v %s; ", constr_file.c_str());
-			buffer += abc_command + "; ";
+	clk_polarity = true;
+	clk_sig = RTLIL::SigSpec();
+
+	size_t first_job = jobs.size();
+	std::string first_tempdir = abc_use_pipes ? std::string() : make_tempdir(cleanup);
+	if (abc_use_pipes)
+		log_header("Extracting gate netlist of module `%s'..\n", module->name.c_str());
+	else
+		log_header("Extracting gate netlist of module `%s' to `%s/input.blif'..\n", module->name.c_str(), first_tempdir.c_str());
+
+	std::string abc_command;
+	if (!script_file.empty()) {
+		if (script_file[0] == '+') {
+			for (size_t i = 1; i < script_file.size(); i++)
+				if (script_file[i] == '\'')
+					abc_command += "'\\''";
+				else if (script_file[i] == ',')
+					abc_command += " ";
+				else
+					abc_command += script_file[i];
 		} else
-		if (lut_mode)
-			buffer += stringf("%s -s -c 'read_blif %s/input.blif; read_lut %s/lutdefs.txt; %s; ",
-					exe_file.c_str(), tempdir_name, tempdir_name, abc_command.c_str());
+			abc_command = stringf("source %s", script_file.c_str());
+	} else if (lut_mode)
+		abc_command = ABC_COMMAND_LUT;
+	else if (!liberty_file.empty())
+		abc_command = constr_file.empty() ? ABC_COMMAND_LIB : ABC_COMMAND_CTR;
+	else
+		abc_command = ABC_COMMAND_DFL;
+	abc_command = add_echos_to_abc_cmd(abc_command);
+
+	if (clk_str.empty()) {
+		if (clk_str[0] == '!') {
+			clk_polarity = false;
+			clk_str = clk_str.substr(1);
+		}
+		if (module->wires.count(RTLIL::escape_id(clk_str)) != 0)
+			clk_sig = assign_map(RTLIL::SigSpec(module->wires.at(RTLIL::escape_id(clk_str)), 1));
+	}
+
+	if (dff_mode && clk_sig.width == 0)
+	{
+		int best_dff_counter = 0;
+		std::map<std::pair<bool, RTLIL::SigSpec>, int> dff_counters;
+
+		for (auto &it : module->cells)
+		{
+			RTLIL::Cell *cell = it.second;
+			if (cell->type != "$_DFF_N_" && cell->type != "$_DFF_P_")
+				continue;
+
+			std::pair<bool, RTLIL::SigSpec> key(cell->type == "$_DFF_P_", assign_map(cell->connections.at("\\C")));
+			if (++dff_counters[key] > best_dff_counter) {
+				best_dff_counter = dff_counters[key];
+				clk_polarity = key.first;
+				clk_sig = key.second;
+			}
+		}
+	}
+
+	if (dff_mode || !clk_str.empty()) {
+		if (clk_sig.width == 0)
+			log("No (matching) clock domain found. Not extracting any FF cells.\n");
 		else
-			buffer += stringf("%s -s -c 'read_blif %s/input.blif; read_library %s/stdcells.genlib; %s; ",
-					exe_file.c_str(), tempdir_name, tempdir_name, abc_command.c_str());
-		buffer += stringf("write_blif %s/output.blif' 2>&1", tempdir_name);
+			log("Found (matching) %s clock domain: %s\n", clk_polarity ? "posedge" : "negedge", log_signal(clk_sig));
+	}
 
-		log("%s\n", buffer.c_str());
+	if (clk_sig.width != 0)
+		mark_port(clk_sig);
 
-		errno = ENOMEM;  // popen does not set errno if memory allocation fails, therefore set it by hand
-		f = popen(buffer.c_str(), "r");
-		if (f == NULL)
-			log_error("Opening pipe to `%s' for reading failed: %s\n", buffer.c_str(), strerror(errno));
-#if 0
-		char logbuf[1024];
-		while (fgets(logbuf, 1024, f) != NULL)
-			log("ABC: %s", logbuf);
-#else
-		bool got_cr = false;
-		std::string linebuf;
-		char logbuf[1024];
-		while (fgets(logbuf, 1024, f) != NULL)
-			for (char *p = logbuf; *p; p++) {
-				if (*p == '\r') {
-					got_cr = true;
-					continue;
-				}
-				if (*p == '\n') {
+	std::vector<RTLIL::Cell*> cells;
+	cells.reserve(module->cells.size());
+	for (auto &it : module->cells)
+		if (design->selected(current_module, it.second))
+			cells.push_back(it.second);
+	for (auto c : cells)
+		extract_cell(c, keepff);
+
+	for (auto &wire_it : module->wires) {
+		if (wire_it.second->port_id > 0 || wire_it.second->get_bool_attribute("\\keep"))
+			mark_port(RTLIL::SigSpec(wire_it.second));
+	}
+
+	for (auto &cell_it : module->cells)
+	for (auto &port_it : cell_it.second->connections)
+		mark_port(port_it.second);
+	
+	handle_loops();
+
+	int count_gates = 0;
+	for (auto &si : signal_list)
+		if (si.type >= 0)
+			count_gates++;
+
+	if (partition_size > 0 && count_gates > partition_size)
+	{
+		std::vector<std::vector<gate_t>> parts;
+		int cut_signals = partition_signal_list(partition_size, parts);
+		log("Partitioned %d gates into %d clusters of at most %d gates with %d cut signals.\n",
+				count_gates, int(parts.size()), partition_size, cut_signals);
+
+		// the first job uses the temp directory and autoidx from above
+		bool first = true;
+
+		if (partition_qor) {
+			jobs.push_back(abc_job_t());
+			abc_job_t &job = jobs.back();
+			job.tempdir_name = first_tempdir;
+			job.map_autoidx = map_autoidx;
+			job.use_pipes = abc_use_pipes;
+			job.signal_list = signal_list;
+			job.qor_reference = true;
+			log("Writing unpartitioned netlist for QoR comparison to %s.\n", abc_job_input_desc(job).c_str());
+			first = false;
+		}
+
+		for (size_t i = 0; i < parts.size(); i++) {
+			jobs.push_back(abc_job_t());
+			abc_job_t &job = jobs.back();
+			job.tempdir_name = first ? first_tempdir : abc_use_pipes ? std::string() : make_tempdir(cleanup);
+			job.map_autoidx = first ? map_autoidx : RTLIL::autoidx++;
+			job.use_pipes = abc_use_pipes;
+			job.signal_list.swap(parts[i]);
+			job.partition_idx = i+1;
+			job.partition_count = parts.size();
+			job.cut_signals = cut_signals;
+			log("Writing cluster %d to %s.\n", int(i+1), abc_job_input_desc(job).c_str());
+			first = false;
+		}
+	}
+	else
+	{
+		jobs.push_back(abc_job_t());
+		abc_job_t &job = jobs.back();
+		job.tempdir_name = first_tempdir;
+		job.map_autoidx = map_autoidx;
+		job.use_pipes = abc_use_pipes;
+		job.signal_list.swap(signal_list);
+	}
+
+	for (size_t i = first_job; i < jobs.size(); i++) {
+		abc_job_t &job = jobs[i];
+		job.module = module;
+		job.clk_polarity = clk_polarity;
+		job.clk_sig = clk_sig;
+		job.exe_file = exe_file;
+		job.builtin_lib = liberty_file.empty() && script_file.empty() && !lut_mode;
+		abc_job_write(job, abc_command, exe_file, script_file, liberty_file, constr_file, lut_mode);
+	}
+
+	signal_list.clear();
+}
+
+static void abc_read_log(FILE *f, abc_job_t &job, bool live_log)
+{
+	bool got_cr = false;
+	std::string linebuf;
+	char logbuf[1024];
+	while (fgets(logbuf, 1024, f) != NULL)
+		for (char *p = logbuf; *p; p++) {
+			if (*p == '\r') {
+				got_cr = true;
+				continue;
+			}
+			if (*p == '\n') {
+				if (live_log)
 					log("ABC: %s\n", linebuf.c_str());
-					got_cr = false, linebuf.clear();
-					continue;
-				}
-				if (got_cr)
-					got_cr = false, linebuf.clear();
-				linebuf += *p;
+				else
+					job.output_lines.push_back(linebuf);
+				got_cr = false, linebuf.clear();
+				continue;
 			}
-		if (!linebuf.empty())
+			if (got_cr)
+				got_cr = false, linebuf.clear();
+			linebuf += *p;
+		}
+	if (!linebuf.empty()) {
+		if (live_log)
 			log("ABC: %s\n", linebuf.c_str());
-#endif
-		errno = 0;
-		int ret = pclose(f);
-		if (ret < 0)
-			log_error("Closing pipe to `%s' failed: %s\n", buffer.c_str(), strerror(errno));
-		if (WEXITSTATUS(ret) != 0) {
-			switch (WEXITSTATUS(ret)) {
-				case 127: log_error("ABC: execution of command \"%s\" failed: Command not found\n", exe_file.c_str()); break;
-				case 126: log_error("ABC: execution of command \"%s\" failed: Command not executable\n", exe_file.c_str()); break;
-				default:  log_error("ABC: execution of command \"%s\" failed: the shell returned %d\n", exe_file.c_str(), WEXITSTATUS(ret)); break;
+		else
+			job.output_lines.push_back(linebuf);
+	}
+}
+
+// run ABC with the input files and the output file as in-memory files that are
+// passed to the ABC process as file descriptors 3, 4, ... (see abc_job_path())
+static void abc_run_pipes(abc_job_t &job, bool live_log)
+{
+	std::vector<int> fds;
+	auto close_fds = [&]() {
+		for (int fd : fds)
+			close(fd);
+	};
+
+	for (size_t i = 0; i <= job.input_files.size(); i++) {
+		int fd = abc_memfd_create(i < job.input_files.size() ? job.input_files[i].first.c_str() : "output.blif");
+		if (fd < 0) {
+			job.error = stringf("Creating in-memory file for ABC failed: %s\n", strerror(errno));
+			close_fds();
+			return;
+		}
+		fds.push_back(fd);
+		if (i == job.input_files.size())
+			break;
+		const std::string &data = job.input_files[i].second;
+		for (size_t pos = 0; pos < data.size();) {
+			ssize_t n = write(fd, data.data() + pos, data.size() - pos);
+			if (n <= 0) {
+				job.error = stringf("Writing in-memory file for ABC failed: %s\n", strerror(errno));
+				close_fds();
+				return;
 			}
+			pos += n;
 		}
+	}
 
-		if (asprintf(&p, "%s/%s", tempdir_name, "output.blif") < 0) log_abort();
-		f = fopen(p, "rt");
-		if (f == NULL)
-			log_error("Can't open ABC output file `%s'.\n", p);
+	int pipe_fds[2];
+	if (abc_pipe_cloexec(pipe_fds) != 0) {
+		job.error = stringf("Creating pipe for ABC failed: %s\n", strerror(errno));
+		close_fds();
+		return;
+	}
 
-		bool builtin_lib = liberty_file.empty() && script_file.empty() && !lut_mode;
-		RTLIL::Design *mapped_design = abc_parse_blif(f, builtin_lib ? "\\DFF" : "\\_dff_");
+	// only async-signal-safe functions may be called in the child process
+	const char *argv[] = { "sh", "-c", job.command.c_str(), NULL };
+	int num_fds = fds.size();
+	std::vector<int> high_fds(num_fds);
+
+	pid_t pid = fork();
+	if (pid == 0) {
+		dup2(pipe_fds[1], 1);
+		dup2(pipe_fds[1], 2);
+		for (int i = 0; i < num_fds; i++)
+			high_fds[i] = fcntl(fds[i], F_DUPFD, num_fds + 3);
+		for (int i = 0; i < num_fds; i++) {
+			dup2(high_fds[i], i + 3);
+			close(high_fds[i]);
+		}
+		execve("/bin/sh", (char**)argv, environ);
+		_exit(127);
+	}
 
-		fclose(f);
-		free(p);
+	close(pipe_fds[1]);
+	if (pid < 0) {
+		job.error = stringf("Running `%s' failed: %s\n", job.command.c_str(), strerror(errno));
+		close(pipe_fds[0]);
+		close_fds();
+		return;
+	}
+
+	FILE *f = fdopen(pipe_fds[0], "r");
+	abc_read_log(f, job, live_log);
+	fclose(f);
+
+	if (waitpid(pid, &job.ret, 0) < 0)
+		job.error = stringf("Waiting for `%s' failed: %s\n", job.command.c_str(), strerror(errno));
+
+	// the ABC process opened its own file description for the output file, so the
+	// offset of our file descriptor is still at the start of the file
+	char buffer[4096];
+	ssize_t n;
+	while ((n = read(fds.back(), buffer, sizeof(buffer))) > 0)
+		job.output_data.append(buffer, n);
+	job.got_output = !job.output_data.empty();
+
+	close_fds();
+}
+
+// this function does not use any of the global state and does not call log()
+// when live_log is false, so it is safe to call it from a worker thread
+static void abc_module_run(abc_job_t &job, bool live_log)
+{
+	std::string output_file = job.tempdir_name + "/output.blif";
+
+	if (!job.cache_file.empty() && read_file(job.cache_file, job.output_data)) {
+		utime(job.cache_file.c_str(), NULL);
+		if (!job.use_pipes)
+			write_file(output_file, job.output_data);
+		job.got_output = true;
+		job.cache_hit = true;
+		return;
+	}
+
+	if (job.use_pipes)
+		abc_run_pipes(job, live_log);
+	else
+	{
+		errno = ENOMEM;  // popen does not set errno if memory allocation fails, therefore set it by hand
+		FILE *f = popen(job.command.c_str(), "r");
+		if (f == NULL) {
+			job.error = stringf("Opening pipe to `%s' for reading failed: %s\n", job.command.c_str(), strerror(errno));
+			return;
+		}
+
+		abc_read_log(f, job, live_log);
+
+		errno = 0;
+		job.ret = pclose(f);
+		if (job.ret < 0)
+			job.error = stringf("Closing pipe to `%s' failed: %s\n", job.command.c_str(), strerror(errno));
+
+		job.got_output = read_file(output_file, job.output_data);
+	}
+
+	// write to a temporary file first, so that concurrent runs never see partial cache entries
+	if (!job.cache_file.empty() && job.got_output && job.error.empty() && WEXITSTATUS(job.ret) == 0) {
+		std::string temp_file = abc_cache_dir + "/new-XXXXXX";
+		int fd = mkstemp(&temp_file[0]);
+		if (fd >= 0) {
+			close(fd);
+			if (write_file(temp_file, job.output_data) && rename(temp_file.c_str(), job.cache_file.c_str()) == 0)
+				job.cache_stored = true;
+			else
+				remove(temp_file.c_str());
+		}
+	}
+}
+
+// log the ABC output (running ABC first if run_now is set) and parse the mapped netlist
+static RTLIL::Design *abc_module_output(abc_job_t &job, bool run_now)
+{
+	log_header("Executing ABC.\n");
+	log("%s\n", job.command.c_str());
+
+	if (run_now)
+		abc_module_run(job, true);
+	else
+		for (auto &line : job.output_lines)
+			log("ABC: %s\n", line.c_str());
+
+	if (job.cache_hit) {
+		log("Using cached ABC result `%s' instead of running ABC.\n", job.cache_file.c_str());
+		abc_cache_hits++;
+	} else if (!job.cache_file.empty()) {
+		abc_cache_misses++;
+		if (job.cache_stored) {
+			log("Stored ABC result in cache as `%s'.\n", job.cache_file.c_str());
+			abc_cache_stored++;
+		}
+	}
+
+	if (!job.error.empty())
+		log_error("%s", job.error.c_str());
+	if (WEXITSTATUS(job.ret) != 0) {
+		switch (WEXITSTATUS(job.ret)) {
+			case 127: log_error("ABC: execution of command \"%s\" failed: Command not found\n", job.exe_file.c_str()); break;
+			case 126: log_error("ABC: execution of command \"%s\" failed: Command not executable\n", job.exe_file.c_str()); break;
+			default:  log_error("ABC: execution of command \"%s\" failed: the shell returned %d\n", job.exe_file.c_str(), WEXITSTATUS(job.ret)); break;
+		}
+	}
+
+	if (!job.got_output) {
+		if (job.use_pipes)
+			log_error("ABC did not write an output netlist.\n");
+		log_error("Can't open ABC output file `%s'.\n", abc_job_path(job, "output.blif").c_str());
+	}
+
+	RTLIL::Design *mapped_design = new RTLIL::Design;
+	parse_blif(mapped_design, job.output_data.data(), job.output_data.size(), "netlist", job.builtin_lib ? "\\DFF" : "\\_dff_", "");
+
+	std::string().swap(job.output_data);
+
+	return mapped_design;
+}
+
+static void abc_module_cleanup(abc_job_t &job)
+{
+	const char *tempdir_name = job.tempdir_name.c_str();
+	char *p;
+
+	if (job.use_pipes)
+		return;
+
+	log_header("Removing temp directory `%s':\n", tempdir_name);
+
+	struct dirent **namelist;
+	int n = scandir(tempdir_name, &namelist, 0, alphasort);
+	assert(n >= 0);
+	for (int i = 0; i < n; i++) {
+		if (strcmp(namelist[i]->d_name, ".") && strcmp(namelist[i]->d_name, "..")) {
+			if (asprintf(&p, "%s/%s", tempdir_name, namelist[i]->d_name) < 0) log_abort();
+			log("Removing `%s'.\n", p);
+			remove(p);
+			free(p);
+		}
+		free(namelist[i]);
+	}
+	free(namelist);
+	log("Removing `%s'.\n", tempdir_name);
+	rmdir(tempdir_name);
+}
+
+static void abc_module_integrate(RTLIL::Design *design, abc_job_t &job, bool cleanup, bool run_now)
+{
+	module = job.module;
+	map_autoidx = job.map_autoidx;
+	signal_list.swap(job.signal_list);
+	clk_polarity = job.clk_polarity;
+	clk_sig = job.clk_sig;
+
+	log_push();
+
+	if (job.qor_reference)
+	{
+		if (job.count_output > 0) {
+			RTLIL::Design *mapped_design = abc_module_output(job, run_now);
+			for (auto &it : mapped_design->modules)
+			for (auto &cell_it : it.second->cells)
+				job.cell_stats[RTLIL::unescape_id(cell_it.second->type)]++;
+			for (auto &it : job.cell_stats)
+				log("ABC RESULTS (unpartitioned):   %15s cells: %8d\n", it.first.c_str(), it.second);
+			delete mapped_design;
+		}
+	}
+	else
+	if (job.count_output > 0)
+	{
+		bool builtin_lib = job.builtin_lib;
+		RTLIL::Design *mapped_design = abc_module_output(job, run_now);
 
 		log_header("Re-integrating ABC results.\n");
 		RTLIL::Module *mapped_mod = mapped_design->modules["\\netlist"];
@@ -708,7 +1439,7 @@ static void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std
 			design->select(module, wire);
 		}
 
-		std::map<std::string, int> cell_stats;
+		std::map<std::string, int> &cell_stats = job.cell_stats;
 		if (builtin_lib)
 		{
 			for (auto &it : mapped_mod->cells) {
@@ -859,27 +1590,68 @@ static void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std
 	}
 
 	if (cleanup)
+		abc_module_cleanup(job);
+
+	signal_list.clear();
+	log_pop();
+}
+
+// summarize the results for partitioned modules and compare them with the unpartitioned mapping
+static void abc_report_partitions(std::vector<abc_job_t> &jobs)
+{
+	for (size_t i = 0; i < jobs.size(); i++)
 	{
-		log_header("Removing temp directory `%s':\n", tempdir_name);
-
-		struct dirent **namelist;
-		int n = scandir(tempdir_name, &namelist, 0, alphasort);
-		assert(n >= 0);
-		for (int i = 0; i < n; i++) {
-			if (strcmp(namelist[i]->d_name, ".") && strcmp(namelist[i]->d_name, "..")) {
-				if (asprintf(&p, "%s/%s", tempdir_name, namelist[i]->d_name) < 0) log_abort();
-				log("Removing `%s'.\n", p);
-				remove(p);
-				free(p);
-			}
-			free(namelist[i]);
+		if (jobs[i].partition_idx != 1)
+			continue;
+
+		std::map<std::string, int> part_stats, ref_stats;
+		bool got_reference = false;
+		for (auto &job : jobs) {
+			if (job.module != jobs[i].module)
+				continue;
+			if (job.qor_reference)
+				ref_stats = job.cell_stats, got_reference = true;
+			else
+				for (auto &it : job.cell_stats)
+					part_stats[it.first] += it.second;
 		}
-		free(namelist);
-		log("Removing `%s'.\n", tempdir_name);
-		rmdir(tempdir_name);
+
+		log_header("Partitioned ABC mapping results for module `%s'.\n", jobs[i].module->name.c_str());
+		log("Mapped %d clusters with %d cut signals.\n", jobs[i].partition_count, jobs[i].cut_signals);
+
+		if (!got_reference) {
+			for (auto &it : part_stats)
+				log("ABC RESULTS:   %15s cells: %8d\n", it.first.c_str(), it.second);
+			continue;
+		}
+
+		int part_total = 0, ref_total = 0;
+		std::set<std::string> cell_types;
+		for (auto &it : part_stats)
+			cell_types.insert(it.first), part_total += it.second;
+		for (auto &it : ref_stats)
+			cell_types.insert(it.first), ref_total += it.second;
+
+		log("%21s %12s %14s %10s\n", "", "partitioned", "unpartitioned", "delta");
+		for (auto &type : cell_types)
+			log("%15s cells: %12d %14d %+10d\n", type.c_str(), part_stats[type], ref_stats[type], part_stats[type] - ref_stats[type]);
+		log("%15s cells: %12d %14d %+10d", "total", part_total, ref_total, part_total - ref_total);
+		if (ref_total > 0)
+			log(" (%+.1f%%)", 100.0 * (part_total - ref_total) / ref_total);
+		log("\n");
 	}
+}
 
-	log_pop();
+static void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::string script_file, std::string exe_file,
+		std::string liberty_file, std::string constr_file, bool cleanup, int lut_mode, bool dff_mode, std::string clk_str, bool keepff,
+		int partition_size, bool partition_qor)
+{
+	std::vector<abc_job_t> jobs;
+	abc_module_extract(jobs, design, current_module, script_file, exe_file, liberty_file, constr_file, cleanup, lut_mode, dff_mode, clk_str, keepff,
+			partition_size, partition_qor);
+	for (auto &job : jobs)
+		abc_module_integrate(design, job, cleanup, true);
+	abc_report_partitions(jobs);
 }
 
 struct AbcPass : public Pass {
@@ -955,6 +1727,41 @@ struct AbcPass : public Pass {
 		log("        when this option is used, the temporary files created by this pass\n");
 		log("        are not removed. this is useful for debugging.\n");
 		log("\n");
+		log("    -pipe\n");
+		log("        do not create a temp directory. the netlist, the cell library and the\n");
+		log("        script are passed to ABC as in-memory files and the mapped netlist is\n");
+		log("        read back from an in-memory file (this needs memfd support, i.e.\n");
+		log("        Linux). this option is ignored when -nocleanup is used.\n");
+		log("\n");
+		log("    -j <n>\n");
+		log("        run up to <n> ABC processes in parallel. the gate netlists of all\n");
+		log("        selected modules are extracted first, then ABC is executed for all of\n");
+		log("        them and finally the results are re-integrated in module order. the\n");
+		log("        ABC output is logged when the results for a module are re-integrated.\n");
+		log("\n");
+		log("    -partition <size>\n");
+		log("        split the gate netlist of modules with more than <size> gates into\n");
+		log("        clusters of at most <size> gates and map each cluster with a separate\n");
+		log("        ABC process (in parallel when used with -j). the netlist is cut at the\n");
+		log("        register outputs first and large combinatorial regions are split so\n");
+		log("        that only few signals cross cluster boundaries. ABC can not optimize\n");
+		log("        across the cluster boundaries, so this trades QoR for run time.\n");
+		log("\n");
+		log("    -partition_qor\n");
+		log("        also map the unpartitioned netlist of each partitioned module (without\n");
+		log("        using the result) and report the difference in the cell counts.\n");
+		log("\n");
+		log("    -cache <dir>\n");
+		log("        store the ABC results in the specified directory and reuse them instead\n");
+		log("        of running ABC when the same netlist is mapped again. the results are\n");
+		log("        identified by a hash of the extracted netlist, the ABC script, the\n");
+		log("        liberty and constraints files and the ABC executable (path, size and\n");
+		log("        modification time).\n");
+		log("\n");
+		log("    -cache_size <mbytes>\n");
+		log("        remove the least recently used entries from the cache directory when\n");
+		log("        it grows larger than the specified size. (default: 256)\n");
+		log("\n");
 		log("When neither -liberty nor -lut is used, the Yosys standard cell library is\n");
 		log("loaded into ABC before the ABC script is executed.\n");
 		log("\n");
@@ -971,8 +1778,14 @@ struct AbcPass : public Pass {
 
 		std::string exe_file = proc_self_dirname() + "yosys-abc";
 		std::string script_file, liberty_file, constr_file, clk_str;
-		bool dff_mode = false, keepff = false, cleanup = true;
-		int lut_mode = 0;
+		bool dff_mode = false, keepff = false, cleanup = true, use_pipes = false;
+		int lut_mode = 0, num_jobs = 1, partition_size = 0, cache_size = 256;
+		bool partition_qor = false;
+
+		abc_cache_dir.clear();
+		abc_cache_hits = 0;
+		abc_cache_misses = 0;
+		abc_cache_stored = 0;
 
 		size_t argidx;
 		char pwd [PATH_MAX];
@@ -1024,6 +1837,32 @@ struct AbcPass : public Pass {
 				cleanup = false;
 				continue;
 			}
+			if (arg == "-pipe") {
+				use_pipes = true;
+				continue;
+			}
+			if (arg == "-j" && argidx+1 < args.size()) {
+				num_jobs = std::max(atoi(args[++argidx].c_str()), 1);
+				continue;
+			}
+			if (arg == "-partition" && argidx+1 < args.size()) {
+				partition_size = std::max(atoi(args[++argidx].c_str()), 1);
+				continue;
+			}
+			if (arg == "-partition_qor") {
+				partition_qor = true;
+				continue;
+			}
+			if (arg == "-cache" && argidx+1 < args.size()) {
+				abc_cache_dir = args[++argidx];
+				if (!abc_cache_dir.empty() && abc_cache_dir[0] != '/')
+					abc_cache_dir = std::string(pwd) + "/" + abc_cache_dir;
+				continue;
+			}
+			if (arg == "-cache_size" && argidx+1 < args.size()) {
+				cache_size = std::max(atoi(args[++argidx].c_str()), 0);
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
@@ -1032,15 +1871,68 @@ struct AbcPass : public Pass {
 			log_cmd_error("Got -lut and -liberty! This two options are exclusive.\n");
 		if (!constr_file.empty() && liberty_file.empty())
 			log_cmd_error("Got -constr but no -liberty!\n");
+		if (!abc_cache_dir.empty() && mkdir(abc_cache_dir.c_str(), 0777) != 0 && errno != EEXIST)
+			log_cmd_error("Can't create ABC cache directory `%s': %s\n", abc_cache_dir.c_str(), strerror(errno));
+
+		abc_use_pipes = false;
+		if (use_pipes && !cleanup)
+			log("Ignoring -pipe because of -nocleanup, using a temp directory.\n");
+		else if (use_pipes && !abc_memfd_supported())
+			log("In-memory files are not supported on this system, ignoring -pipe.\n");
+		else
+			abc_use_pipes = use_pipes;
 
+		std::vector<RTLIL::Module*> modules;
 		for (auto &mod_it : design->modules)
 			if (design->selected(mod_it.second)) {
 				if (mod_it.second->processes.size() > 0)
 					log("Skipping module %s as it contains processes.\n", mod_it.second->name.c_str());
+				else if (num_jobs == 1)
+					abc_module(design, mod_it.second, script_file, exe_file, liberty_file, constr_file, cleanup, lut_mode, dff_mode, clk_str, keepff,
+							partition_size, partition_qor);
 				else
-					abc_module(design, mod_it.second, script_file, exe_file, liberty_file, constr_file, cleanup, lut_mode, dff_mode, clk_str, keepff);
+					modules.push_back(mod_it.second);
 			}
 
+		if (!modules.empty())
+		{
+			std::vector<abc_job_t> jobs;
+			for (auto mod : modules)
+				abc_module_extract(jobs, design, mod, script_file, exe_file, liberty_file, constr_file, cleanup, lut_mode, dff_mode, clk_str, keepff,
+						partition_size, partition_qor);
+
+			std::vector<abc_job_t*> run_jobs;
+			for (auto &job : jobs)
+				if (job.count_output > 0)
+					run_jobs.push_back(&job);
+
+			log("Running %d ABC processes with up to %d parallel jobs.\n", int(run_jobs.size()), num_jobs);
+
+			std::atomic<int> next_index(0);
+			std::vector<std::thread> threads;
+			for (int i = 0; i < std::min(num_jobs, int(run_jobs.size())); i++)
+				threads.push_back(std::thread([&]() {
+					for (int idx = next_index++; idx < int(run_jobs.size()); idx = next_index++)
+						abc_module_run(*run_jobs[idx], false);
+				}));
+			for (auto &thread : threads)
+				thread.join();
+
+			for (auto &job : jobs) {
+				if (job.partition_idx > 0)
+					log_header("Processing ABC results for cluster %d of module `%s'.\n", job.partition_idx, job.module->name.c_str());
+				else if (job.qor_reference)
+					log_header("Processing unpartitioned ABC results for module `%s'.\n", job.module->name.c_str());
+				else
+					log_header("Processing ABC results for module `%s'.\n", job.module->name.c_str());
+				abc_module_integrate(design, job, cleanup, false);
+			}
+			abc_report_partitions(jobs);
+		}
+
+		if (!abc_cache_dir.empty())
+			abc_cache_trim(cache_size * 1048576LL);
+
 		assign_map.clear();
 		signal_list.clear();
 		signal_map.clear();
@@ -0,0 +1,150 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/register.h"
+#include "kernel/aiggen.h"
+#include "kernel/log.h"
+#include <stdlib.h>
+#include <stdio.h>
+
+struct AigoptPass : public Pass {
+	AigoptPass() : Pass("aigopt", "optimize internal gates using an and-inverter graph") { }
+	virtual void help()
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    aigopt [options] [selection]\n");
+		log("\n");
+		log("This pass converts the selected internal gate cells ($_INV_, $_AND_, $_OR_,\n");
+		log("$_XOR_ and $_MUX_) of each module to an and-inverter graph (AIG), optimizes\n");
+		log("the graph and converts it back to $_AND_ and $_INV_ cells. Unlike the 'abc'\n");
+		log("pass this runs in-process and does not need an external tool.\n");
+		log("\n");
+		log("The AIG is structurally hashed when it is created. By default the graph is\n");
+		log("then balanced, rewritten using k-feasible cuts (each cone is replaced by a\n");
+		log("smaller implementation of its cut function, if one is found) and balanced\n");
+		log("again.\n");
+		log("\n");
+		log("    -strash\n");
+		log("        only perform structural hashing and constant propagation\n");
+		log("\n");
+		log("    -nobalance\n");
+		log("        do not balance the graph (balancing reduces the logic depth)\n");
+		log("\n");
+		log("    -norewrite\n");
+		log("        do not rewrite the graph (rewriting reduces the number of nodes)\n");
+		log("\n");
+		log("    -iter <N>\n");
+		log("        perform up to N rewriting passes (default: 3). Rewriting stops\n");
+		log("        early when a pass does not find an improvement.\n");
+		log("\n");
+		log("    -k <num>\n");
+		log("        the maximum number of leaves of the cuts used for rewriting\n");
+		log("        (default: 4, max: 6)\n");
+		log("\n");
+		log("Signals that are not driven by the selected gates are AIG inputs. Signals that\n");
+		log("are driven by the selected gates and used by other cells, by module ports or by\n");
+		log("wires with the 'keep' attribute are AIG outputs. Use 'opt_clean' to remove\n");
+		log("the unused wires afterwards.\n");
+		log("\n");
+	}
+	virtual void execute(std::vector<std::string> args, RTLIL::Design *design)
+	{
+		log_header("Executing AIGOPT pass (optimize internal gates using an AIG).\n");
+		log_push();
+
+		bool strash_only = false, do_balance = true, do_rewrite = true;
+		int iterations = 3, cut_size = 4;
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++) {
+			if (args[argidx] == "-strash") {
+				strash_only = true;
+				continue;
+			}
+			if (args[argidx] == "-nobalance") {
+				do_balance = false;
+				continue;
+			}
+			if (args[argidx] == "-norewrite") {
+				do_rewrite = false;
+				continue;
+			}
+			if (args[argidx] == "-iter" && argidx+1 < args.size()) {
+				iterations = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (args[argidx] == "-k" && argidx+1 < args.size()) {
+				cut_size = atoi(args[++argidx].c_str());
+				if (cut_size < 2 || cut_size > 6)
+					log_cmd_error("Invalid cut size %d (must be between 2 and 6).\n", cut_size);
+				continue;
+			}
+			break;
+		}
+		extra_args(args, argidx, design);
+
+		if (strash_only)
+			do_balance = false, do_rewrite = false;
+
+		for (auto &mod_it : design->modules)
+		{
+			RTLIL::Module *module = mod_it.second;
+			if (!design->selected(module))
+				continue;
+
+			std::vector<RTLIL::Cell*> gate_cells;
+			for (auto &cell_it : module->cells)
+				if (AigGen::is_gate(cell_it.second->type) && design->selected(module, cell_it.second))
+					gate_cells.push_back(cell_it.second);
+
+			if (gate_cells.size() == 0)
+				continue;
+
+			log("Optimizing %d gates in module %s.\n", int(gate_cells.size()), RTLIL::id2cstr(module->name));
+
+			AigGen aiggen(module);
+			aiggen.import_cells(gate_cells);
+			aiggen.aig.cleanup();
+
+			ezAIG &aig = aiggen.aig;
+			log("  AIG after structural hashing: %d inputs, %d outputs, %d AND nodes, depth %d\n",
+					aig.num_inputs(), aig.num_outputs(), aig.num_ands(), aig.depth());
+
+			if (do_balance)
+				aig.balance();
+
+			if (do_rewrite)
+				for (int i = 0; i < iterations; i++) {
+					if (!aig.rewrite(cut_size))
+						break;
+					log("  AIG after rewriting pass %d: %d AND nodes, depth %d\n", i+1, aig.num_ands(), aig.depth());
+				}
+
+			if (do_balance) {
+				aig.balance();
+				log("  AIG after balancing: %d AND nodes, depth %d\n", aig.num_ands(), aig.depth());
+			}
+
+			aiggen.export_cells(design);
+		}
+
+		log_pop();
+	}
+} AigoptPass;
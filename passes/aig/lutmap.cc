@@ -0,0 +1,570 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+// [[CITE]] Priority cuts
+// Alan Mishchenko, Sungmin Cho, Satrajit Chatterjee, Robert Brayton. "Combinational and sequential
+// mapping with priority cuts", Proceedings of the 2007 IEEE/ACM International Conference on
+// Computer-Aided Design (ICCAD), 2007
+
+#include "kernel/register.h"
+#include "kernel/aiggen.h"
+#include "kernel/log.h"
+#include <algorithm>
+#include <functional>
+#include <atomic>
+#include <thread>
+#include <stdlib.h>
+#include <stdio.h>
+
+struct LutMapper
+{
+	struct lut_cut_t {
+		int size;
+		int leaves[6];
+		int delay;
+		float area;
+	};
+
+	enum mode_t {
+		MODE_DELAY,
+		MODE_AREA_FLOW,
+		MODE_EXACT_AREA
+	};
+
+	const ezAIG &aig;
+	int lut_size, max_cuts, recover_rounds;
+	bool area_mode;
+
+	// the priority cuts of each AND node, the best cut is always the first cut in the list
+	std::vector<std::vector<lut_cut_t>> cuts;
+	std::vector<int> arrival, required, map_refs;
+	std::vector<float> area_flow, est_refs;
+	int target_delay;
+	mode_t mode;
+
+	// the number of LUTs and the depth after each mapping round
+	std::vector<std::pair<int, int>> round_stats;
+	int num_luts, depth;
+
+	LutMapper(const ezAIG &aig, int lut_size, int max_cuts, int recover_rounds, bool area_mode) :
+			aig(aig), lut_size(lut_size), max_cuts(max_cuts), recover_rounds(recover_rounds), area_mode(area_mode),
+			target_delay(0), mode(MODE_DELAY), num_luts(0), depth(0) { }
+
+	int cut_ref(const lut_cut_t &cut)
+	{
+		int area = 1;
+		for (int i = 0; i < cut.size; i++)
+			if (map_refs[cut.leaves[i]]++ == 0 && aig.is_and(cut.leaves[i]))
+				area += cut_ref(cuts[cut.leaves[i]].front());
+		return area;
+	}
+
+	int cut_deref(const lut_cut_t &cut)
+	{
+		int area = 1;
+		for (int i = 0; i < cut.size; i++)
+			if (--map_refs[cut.leaves[i]] == 0 && aig.is_and(cut.leaves[i]))
+				area += cut_deref(cuts[cut.leaves[i]].front());
+		return area;
+	}
+
+	bool merge_cuts(const lut_cut_t &cut0, const lut_cut_t &cut1, lut_cut_t &cut)
+	{
+		int i = 0, j = 0;
+		cut.size = 0;
+		while (i < cut0.size || j < cut1.size) {
+			int leaf;
+			if (j == cut1.size || (i < cut0.size && cut0.leaves[i] < cut1.leaves[j]))
+				leaf = cut0.leaves[i++];
+			else if (i == cut0.size || cut1.leaves[j] < cut0.leaves[i])
+				leaf = cut1.leaves[j++];
+			else
+				leaf = cut0.leaves[i++], j++;
+			if (cut.size == lut_size)
+				return false;
+			cut.leaves[cut.size++] = leaf;
+		}
+		return true;
+	}
+
+	static bool cut_contains(const lut_cut_t &cut, const lut_cut_t &other)
+	{
+		return std::includes(cut.leaves, cut.leaves + cut.size, other.leaves, other.leaves + other.size);
+	}
+
+	float cut_area_flow(const lut_cut_t &cut)
+	{
+		float flow = 1;
+		for (int i = 0; i < cut.size; i++)
+			flow += area_flow[cut.leaves[i]];
+		return flow;
+	}
+
+	void eval_cut(lut_cut_t &cut)
+	{
+		cut.delay = 0;
+		for (int i = 0; i < cut.size; i++)
+			cut.delay = std::max(cut.delay, arrival[cut.leaves[i]]);
+		cut.delay++;
+
+		if (mode == MODE_EXACT_AREA) {
+			cut.area = cut_ref(cut);
+			cut_deref(cut);
+		} else
+			cut.area = cut_area_flow(cut);
+	}
+
+	bool cut_better(const lut_cut_t &a, const lut_cut_t &b, int node)
+	{
+		if (mode != MODE_DELAY) {
+			bool a_ok = a.delay <= required[node], b_ok = b.delay <= required[node];
+			if (a_ok != b_ok)
+				return a_ok;
+			if (!a_ok && a.delay != b.delay)
+				return a.delay < b.delay;
+		} else if (!area_mode && a.delay != b.delay)
+			return a.delay < b.delay;
+
+		if (a.area != b.area)
+			return a.area < b.area;
+		if (a.delay != b.delay)
+			return a.delay < b.delay;
+		return a.size < b.size;
+	}
+
+	void map_node(int node)
+	{
+		std::vector<lut_cut_t> candidates;
+
+		bool node_mapped = mode == MODE_EXACT_AREA && map_refs[node] > 0;
+		if (!cuts[node].empty()) {
+			candidates.push_back(cuts[node].front());
+			if (node_mapped)
+				cut_deref(candidates.front());
+		}
+
+		lut_cut_t trivial0, trivial1;
+		trivial0.size = trivial1.size = 1;
+		trivial0.leaves[0] = ezAIG::lit_node(aig.fanin0(node));
+		trivial1.leaves[0] = ezAIG::lit_node(aig.fanin1(node));
+
+		std::vector<lut_cut_t> cuts0 = cuts[trivial0.leaves[0]], cuts1 = cuts[trivial1.leaves[0]];
+		cuts0.push_back(trivial0);
+		cuts1.push_back(trivial1);
+
+		lut_cut_t cut;
+		for (auto &cut0 : cuts0)
+		for (auto &cut1 : cuts1)
+			if (merge_cuts(cut0, cut1, cut))
+				candidates.push_back(cut);
+
+		for (auto &c : candidates)
+			eval_cut(c);
+
+		std::stable_sort(candidates.begin(), candidates.end(), [&](const lut_cut_t &a, const lut_cut_t &b) { return cut_better(a, b, node); });
+
+		// keep the best cuts that are not dominated by a better cut
+		std::vector<lut_cut_t> &node_cuts = cuts[node];
+		node_cuts.clear();
+		for (auto &c : candidates) {
+			if (int(node_cuts.size()) == max_cuts)
+				break;
+			bool dominated = false;
+			for (auto &other : node_cuts)
+				if (cut_contains(c, other)) {
+					dominated = true;
+					break;
+				}
+			if (!dominated)
+				node_cuts.push_back(c);
+		}
+
+		const lut_cut_t &best = node_cuts.front();
+		if (node_mapped)
+			cut_ref(best);
+
+		arrival[node] = best.delay;
+		area_flow[node] = cut_area_flow(best) / est_refs[node];
+	}
+
+	void update_mapping()
+	{
+		map_refs.assign(aig.num_nodes(), 0);
+
+		num_luts = 0, depth = 0;
+		for (int i = 0; i < aig.num_outputs(); i++) {
+			int node = ezAIG::lit_node(aig.output_lit(i));
+			if (map_refs[node]++ == 0 && aig.is_and(node))
+				num_luts += cut_ref(cuts[node].front());
+			depth = std::max(depth, arrival[node]);
+		}
+
+		if (round_stats.empty())
+			target_delay = area_mode ? aig.num_nodes() : depth;
+		round_stats.push_back(std::pair<int, int>(num_luts, depth));
+
+		required.assign(aig.num_nodes(), aig.num_nodes());
+		for (int i = 0; i < aig.num_outputs(); i++)
+			required[ezAIG::lit_node(aig.output_lit(i))] = target_delay;
+
+		for (int node = aig.num_nodes()-1; node > 0; node--) {
+			if (!aig.is_and(node) || map_refs[node] == 0)
+				continue;
+			const lut_cut_t &best = cuts[node].front();
+			for (int i = 0; i < best.size; i++)
+				required[best.leaves[i]] = std::min(required[best.leaves[i]], required[node] - 1);
+		}
+
+		// blend the fanout estimation with the reference counts of the current mapping
+		for (int node = 1; node < aig.num_nodes(); node++)
+			est_refs[node] = std::max(1.0f, (2 * est_refs[node] + map_refs[node]) / 3);
+	}
+
+	void run()
+	{
+		std::vector<int> fanouts;
+		aig.fanout_counts(fanouts);
+
+		cuts.clear();
+		cuts.resize(aig.num_nodes());
+		arrival.assign(aig.num_nodes(), 0);
+		area_flow.assign(aig.num_nodes(), 0);
+		est_refs.resize(aig.num_nodes());
+		for (int node = 0; node < aig.num_nodes(); node++)
+			est_refs[node] = std::max(1, fanouts[node]);
+
+		// area flow recovery can make the mapping worse than the one of the previous
+		// round, so the best cut of each node is saved for the best mapping so far
+		std::vector<lut_cut_t> best_cuts;
+		int best_luts = 0;
+
+		for (int round = 0; round <= recover_rounds; round++)
+		{
+			mode = round == 0 ? MODE_DELAY : round == 1 ? MODE_AREA_FLOW : MODE_EXACT_AREA;
+			for (int node = 1; node < aig.num_nodes(); node++)
+				if (aig.is_and(node))
+					map_node(node);
+			update_mapping();
+
+			if (round == 0 || num_luts < best_luts) {
+				best_cuts.resize(aig.num_nodes());
+				for (int node = 1; node < aig.num_nodes(); node++)
+					if (aig.is_and(node))
+						best_cuts[node] = cuts[node].front();
+				best_luts = num_luts;
+			}
+		}
+
+		if (num_luts != best_luts) {
+			for (int node = 1; node < aig.num_nodes(); node++)
+				if (aig.is_and(node)) {
+					cuts[node].assign(1, best_cuts[node]);
+					eval_cut(cuts[node].front());
+					arrival[node] = cuts[node].front().delay;
+				}
+			update_mapping();
+			round_stats.pop_back();
+		}
+	}
+
+	// the truth table of the best cut of a node, computed by simulating the cone of the cut
+	// the leaves with inverted_leaves[leaf] set are used in negative polarity
+	uint64_t cut_truth(int node, const std::vector<bool> &inverted_leaves)
+	{
+		const lut_cut_t &cut = cuts[node].front();
+		std::map<int, uint64_t> values;
+		for (int i = 0; i < cut.size; i++)
+			values[cut.leaves[i]] = inverted_leaves[cut.leaves[i]] ? ~ezAIG::var_truth(i) : ezAIG::var_truth(i);
+
+		std::function<uint64_t(int)> eval = [&](int n) -> uint64_t {
+			if (values.count(n))
+				return values.at(n);
+			uint64_t v0 = eval(ezAIG::lit_node(aig.fanin0(n)));
+			uint64_t v1 = eval(ezAIG::lit_node(aig.fanin1(n)));
+			if (ezAIG::lit_inverted(aig.fanin0(n)))
+				v0 = ~v0;
+			if (ezAIG::lit_inverted(aig.fanin1(n)))
+				v1 = ~v1;
+			return values[n] = v0 & v1;
+		};
+
+		return eval(node);
+	}
+};
+
+// returns the number of created $lut cells. this can be larger than the number of
+// LUTs in the mapping, because a signal that is needed by outputs in both polarities
+// gets a second LUT with the complemented function (or an inverter for AIG inputs).
+static int lutmap_export(RTLIL::Design *design, AigGen &aiggen, LutMapper &mapper)
+{
+	const ezAIG &aig = aiggen.aig;
+	RTLIL::Module *module = aiggen.module;
+	aiggen.remove_cells();
+
+	// signals for the positive and negative polarity of each node
+	std::vector<RTLIL::SigSpec> node_sigs[2];
+	node_sigs[0].resize(aig.num_nodes());
+	node_sigs[1].resize(aig.num_nodes());
+	std::vector<bool> needed[2];
+	needed[0].resize(aig.num_nodes());
+	needed[1].resize(aig.num_nodes());
+
+	std::set<RTLIL::SigBit> input_set(aiggen.input_bits.begin(), aiggen.input_bits.end());
+	for (int i = 0; i < aig.num_inputs(); i++)
+		node_sigs[0][aig.input_node(i)] = aiggen.input_bits[i];
+
+	for (int node = 1; node < aig.num_nodes(); node++)
+		if (aig.is_and(node) && mapper.map_refs[node] > 0) {
+			const LutMapper::lut_cut_t &cut = mapper.cuts[node].front();
+			for (int i = 0; i < cut.size; i++)
+				needed[0][cut.leaves[i]] = true;
+		}
+
+	// let the LUTs drive the output signals directly where possible
+	std::vector<bool> output_pos(aig.num_nodes());
+	for (int i = 0; i < aig.num_outputs(); i++) {
+		int lit = aig.output_lit(i), node = ezAIG::lit_node(lit), pol = ezAIG::lit_inverted(lit);
+		needed[pol][node] = true;
+		if (pol == 0)
+			output_pos[node] = true;
+		if (aig.is_and(node) && node_sigs[pol][node].width == 0 && input_set.count(aiggen.output_bits[i]) == 0)
+			node_sigs[pol][node] = aiggen.output_bits[i];
+	}
+
+	// a node that is used in negative polarity by an output and in positive polarity
+	// only by other LUTs is only implemented in negative polarity. the other LUTs
+	// use the complemented signal with a complemented input in their function.
+	std::vector<bool> inverted_leaves(aig.num_nodes());
+	for (int node = 1; node < aig.num_nodes(); node++)
+		if (aig.is_and(node) && needed[0][node] && needed[1][node] && !output_pos[node]) {
+			inverted_leaves[node] = true;
+			needed[0][node] = false;
+		}
+
+	int num_cells = 0;
+	auto add_lut = [&](std::vector<RTLIL::SigBit> &inputs, uint64_t truth, RTLIL::SigSpec output)
+	{
+		// remove the inputs the function does not depend on
+		for (int i = int(inputs.size())-1; i >= 0; i--)
+			if (!ezAIG::truth_depends_on(truth, i)) {
+				truth = ezAIG::truth_remove_var(truth, i, inputs.size());
+				inputs.erase(inputs.begin() + i);
+			}
+
+		if (inputs.size() == 0) {
+			module->connections.push_back(RTLIL::SigSig(output, RTLIL::SigSpec(truth & 1 ? RTLIL::State::S1 : RTLIL::State::S0)));
+			return;
+		}
+
+		if (inputs.size() == 1 && (truth & 3) == 2) {
+			module->connections.push_back(RTLIL::SigSig(output, inputs[0]));
+			return;
+		}
+
+		RTLIL::SigSpec sig_i;
+		std::vector<RTLIL::State> lut_bits;
+		for (auto &bit : inputs)
+			sig_i.append(bit);
+		for (int m = 0; m < (1 << inputs.size()); m++)
+			lut_bits.push_back((truth >> m) & 1 ? RTLIL::State::S1 : RTLIL::State::S0);
+
+		RTLIL::Cell *cell = module->addLut(NEW_ID, sig_i, output, RTLIL::Const(lut_bits));
+		design->select(module, cell);
+		num_cells++;
+	};
+
+	for (int pol = 0; pol < 2; pol++)
+	for (int node = 1; node < aig.num_nodes(); node++)
+		if (needed[pol][node] && node_sigs[pol][node].width == 0)
+			node_sigs[pol][node] = module->new_wire(1, NEW_ID);
+
+	for (int node = 1; node < aig.num_nodes(); node++)
+	{
+		if (aig.is_input(node)) {
+			if (needed[1][node]) {
+				std::vector<RTLIL::SigBit> inputs = { RTLIL::SigBit(node_sigs[0][node]) };
+				add_lut(inputs, ~ezAIG::var_truth(0), node_sigs[1][node]);
+			}
+			continue;
+		}
+
+		if (!needed[0][node] && !needed[1][node])
+			continue;
+
+		const LutMapper::lut_cut_t &cut = mapper.cuts[node].front();
+		uint64_t truth = mapper.cut_truth(node, inverted_leaves);
+
+		for (int pol = 0; pol < 2; pol++) {
+			if (!needed[pol][node])
+				continue;
+			std::vector<RTLIL::SigBit> inputs;
+			for (int i = 0; i < cut.size; i++)
+				inputs.push_back(RTLIL::SigBit(node_sigs[inverted_leaves[cut.leaves[i]]][cut.leaves[i]]));
+			add_lut(inputs, pol ? ~truth : truth, node_sigs[pol][node]);
+		}
+	}
+
+	for (int i = 0; i < aig.num_outputs(); i++) {
+		int lit = aig.output_lit(i), node = ezAIG::lit_node(lit);
+		RTLIL::SigSpec sig = node == 0 ? RTLIL::SigSpec(lit == ezAIG::CONST_TRUE ? RTLIL::State::S1 : RTLIL::State::S0) :
+				node_sigs[ezAIG::lit_inverted(lit)][node];
+		if (sig != RTLIL::SigSpec(aiggen.output_bits[i]))
+			module->connections.push_back(RTLIL::SigSig(aiggen.output_bits[i], sig));
+	}
+
+	return num_cells;
+}
+
+struct LutmapPass : public Pass {
+	LutmapPass() : Pass("lutmap", "map internal gates to LUTs") { }
+	virtual void help()
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    lutmap [options] [selection]\n");
+		log("\n");
+		log("This pass maps the selected internal gate cells ($_INV_, $_AND_, $_OR_, $_XOR_\n");
+		log("and $_MUX_) of each module to $lut cells. Unlike 'abc -lut' this runs in-process\n");
+		log("and does not need an external tool.\n");
+		log("\n");
+		log("The gates are converted to an and-inverter graph (see 'aigopt') and mapped\n");
+		log("using priority cuts: only a small number of the best cuts is stored for each\n");
+		log("node, so the run time is linear in the size of the netlist. The first mapping\n");
+		log("round minimizes the logic depth, the following area recovery rounds reduce the\n");
+		log("number of LUTs (using area flow and then exact local area) without increasing\n");
+		log("the depth.\n");
+		log("\n");
+		log("    -k <num>\n");
+		log("        the number of inputs of the LUTs (default: 6, max: 6)\n");
+		log("\n");
+		log("    -area\n");
+		log("        minimize the number of LUTs, the logic depth is not considered\n");
+		log("\n");
+		log("    -cuts <num>\n");
+		log("        the number of priority cuts stored per node (default: 8)\n");
+		log("\n");
+		log("    -recover <num>\n");
+		log("        the number of area recovery rounds (default: 3)\n");
+		log("\n");
+		log("    -j <num>\n");
+		log("        map up to the specified number of modules in parallel (default: 1)\n");
+		log("\n");
+		log("The gates are not optimized before mapping, run 'aigopt' first for better\n");
+		log("results.\n");
+		log("\n");
+	}
+	virtual void execute(std::vector<std::string> args, RTLIL::Design *design)
+	{
+		log_header("Executing LUTMAP pass (map internal gates to LUTs).\n");
+		log_push();
+
+		int lut_size = 6, max_cuts = 8, recover_rounds = 3, num_jobs = 1;
+		bool area_mode = false;
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++) {
+			if (args[argidx] == "-k" && argidx+1 < args.size()) {
+				lut_size = atoi(args[++argidx].c_str());
+				if (lut_size < 2 || lut_size > 6)
+					log_cmd_error("Invalid LUT size %d (must be between 2 and 6).\n", lut_size);
+				continue;
+			}
+			if (args[argidx] == "-area") {
+				area_mode = true;
+				continue;
+			}
+			if (args[argidx] == "-cuts" && argidx+1 < args.size()) {
+				max_cuts = atoi(args[++argidx].c_str());
+				if (max_cuts < 1)
+					log_cmd_error("Invalid number of cuts %d.\n", max_cuts);
+				continue;
+			}
+			if (args[argidx] == "-recover" && argidx+1 < args.size()) {
+				recover_rounds = atoi(args[++argidx].c_str());
+				if (recover_rounds < 0)
+					log_cmd_error("Invalid number of area recovery rounds %d.\n", recover_rounds);
+				continue;
+			}
+			if (args[argidx] == "-j" && argidx+1 < args.size()) {
+				num_jobs = std::max(1, atoi(args[++argidx].c_str()));
+				continue;
+			}
+			break;
+		}
+		extra_args(args, argidx, design);
+
+		std::vector<AigGen*> aiggens;
+		std::vector<LutMapper*> mappers;
+
+		for (auto &mod_it : design->modules)
+		{
+			RTLIL::Module *module = mod_it.second;
+			if (!design->selected(module))
+				continue;
+
+			std::vector<RTLIL::Cell*> gate_cells;
+			for (auto &cell_it : module->cells)
+				if (AigGen::is_gate(cell_it.second->type) && design->selected(module, cell_it.second))
+					gate_cells.push_back(cell_it.second);
+
+			if (gate_cells.size() == 0)
+				continue;
+
+			log("Extracting %d gates from module %s.\n", int(gate_cells.size()), RTLIL::id2cstr(module->name));
+
+			AigGen *aiggen = new AigGen(module);
+			aiggen->import_cells(gate_cells);
+			aiggen->aig.cleanup();
+			aiggens.push_back(aiggen);
+			mappers.push_back(new LutMapper(aiggen->aig, lut_size, max_cuts, recover_rounds, area_mode));
+		}
+
+		std::atomic<int> next_index(0);
+		std::vector<std::thread> threads;
+		for (int i = 0; i < std::min(num_jobs, int(mappers.size())); i++)
+			threads.push_back(std::thread([&]() {
+				for (int idx = next_index++; idx < int(mappers.size()); idx = next_index++)
+					mappers[idx]->run();
+			}));
+		for (auto &thread : threads)
+			thread.join();
+
+		for (size_t i = 0; i < mappers.size(); i++)
+		{
+			LutMapper *mapper = mappers[i];
+			ezAIG &aig = aiggens[i]->aig;
+
+			log("Mapping module %s: %d inputs, %d outputs, %d AND nodes, depth %d.\n", RTLIL::id2cstr(aiggens[i]->module->name),
+					aig.num_inputs(), aig.num_outputs(), aig.num_ands(), aig.depth());
+			for (size_t round = 0; round < mapper->round_stats.size(); round++)
+				log("  %-24s %6d LUTs, depth %d\n", round == 0 ? (area_mode ? "area mapping:" : "delay mapping:") :
+						round == 1 ? "area flow recovery:" : "exact area recovery:",
+						mapper->round_stats[round].first, mapper->round_stats[round].second);
+			int num_cells = lutmap_export(design, *aiggens[i], *mapper);
+			if (num_cells > mapper->num_luts)
+				log("  %d additional LUTs for outputs that are needed in both polarities.\n", num_cells - mapper->num_luts);
+			log("  Final mapping uses %d LUTs with a depth of %d.\n", num_cells, mapper->depth);
+
+			delete mapper;
+			delete aiggens[i];
+		}
+
+		log_pop();
+	}
+} LutmapPass;
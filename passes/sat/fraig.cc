@@ -0,0 +1,452 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/register.h"
+#include "kernel/sigtools.h"
+#include "kernel/log.h"
+#include "kernel/satgen.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <algorithm>
+
+namespace {
+
+struct FraigConfig
+{
+	int sim_words;
+	int conflict_limit;
+	int max_tries;
+	bool verbose;
+};
+
+struct FraigWorker
+{
+	RTLIL::Design *design;
+	RTLIL::Module *module;
+	FraigConfig &config;
+
+	SigMap sigmap;
+	ezDefaultSAT ez;
+	SatGen satgen;
+
+	std::map<RTLIL::SigBit, RTLIL::Cell*> drivers;
+	std::vector<RTLIL::Cell*> topo_cells;
+	std::set<RTLIL::Cell*> sat_cells;
+
+	// all signals (constants, leaves and gate outputs) as nodes, numbered so
+	// that a gate output always has a higher index than all nodes in its cone
+	std::map<RTLIL::SigBit, int> node_index;
+	std::vector<RTLIL::SigBit> node_bits;
+	std::vector<uint64_t> sim_data;
+	uint64_t sim_rng_state;
+
+	struct merge_t {
+		RTLIL::Cell *cell;
+		RTLIL::SigBit master;
+		bool inverted;
+	};
+	std::vector<merge_t> merges;
+
+	int count_strash, count_proven, count_disproven, count_timeout;
+
+	FraigWorker(RTLIL::Design *design, RTLIL::Module *module, FraigConfig &config) :
+			design(design), module(module), config(config), sigmap(module), satgen(&ez, &sigmap)
+	{
+		count_strash = 0;
+		count_proven = 0;
+		count_disproven = 0;
+		count_timeout = 0;
+	}
+
+	static bool is_gate(RTLIL::Cell *cell)
+	{
+		return cell->type == "$_INV_" || cell->type == "$_AND_" || cell->type == "$_OR_" ||
+				cell->type == "$_XOR_" || cell->type == "$_MUX_";
+	}
+
+	std::vector<RTLIL::SigBit> cell_inputs(RTLIL::Cell *cell)
+	{
+		std::vector<RTLIL::SigBit> inputs;
+		inputs.push_back(sigmap(cell->connections.at("\\A")));
+		if (cell->connections.count("\\B") != 0)
+			inputs.push_back(sigmap(cell->connections.at("\\B")));
+		if (cell->connections.count("\\S") != 0)
+			inputs.push_back(sigmap(cell->connections.at("\\S")));
+		return inputs;
+	}
+
+	RTLIL::SigBit cell_output(RTLIL::Cell *cell)
+	{
+		return sigmap(cell->connections.at("\\Y"));
+	}
+
+	void remove_cell(RTLIL::Cell *cell, RTLIL::SigSpec master)
+	{
+		RTLIL::SigSpec sig_y = cell->connections.at("\\Y");
+		drivers.erase(sigmap(sig_y));
+		module->connections.push_back(RTLIL::SigSig(sig_y, master));
+		sigmap.add(sig_y, master);
+		module->cells.erase(cell->name);
+		delete cell;
+	}
+
+	void find_gates()
+	{
+		std::vector<RTLIL::Cell*> cells;
+		for (auto &it : module->cells)
+			if (is_gate(it.second) && design->selected(module, it.second)) {
+				RTLIL::SigBit bit = cell_output(it.second);
+				if (bit.wire == NULL || drivers.count(bit) != 0)
+					continue;
+				drivers[bit] = it.second;
+				cells.push_back(it.second);
+			}
+
+		std::map<RTLIL::Cell*, int> pending_inputs;
+		std::map<RTLIL::Cell*, std::vector<RTLIL::Cell*>> fanout;
+		std::vector<RTLIL::Cell*> queue;
+
+		for (auto cell : cells) {
+			std::set<RTLIL::Cell*> fanin;
+			for (auto &bit : cell_inputs(cell))
+				if (drivers.count(bit) != 0)
+					fanin.insert(drivers.at(bit));
+			for (auto c : fanin)
+				fanout[c].push_back(cell);
+			pending_inputs[cell] = fanin.size();
+			if (fanin.size() == 0)
+				queue.push_back(cell);
+		}
+
+		for (size_t i = 0; i < queue.size(); i++) {
+			topo_cells.push_back(queue[i]);
+			for (auto c : fanout[queue[i]])
+				if (--pending_inputs[c] == 0)
+					queue.push_back(c);
+		}
+
+		// gates in combinational loops are treated like unknown cells
+		if (topo_cells.size() != cells.size()) {
+			log("  Ignoring %d gates in combinational loops.\n", int(cells.size() - topo_cells.size()));
+			std::set<RTLIL::Cell*> topo_set(topo_cells.begin(), topo_cells.end());
+			for (auto cell : cells)
+				if (topo_set.count(cell) == 0)
+					drivers.erase(cell_output(cell));
+		}
+	}
+
+	void strash()
+	{
+		std::map<std::pair<std::string, std::vector<RTLIL::SigBit>>, RTLIL::Cell*> strash_map;
+		std::vector<RTLIL::Cell*> new_topo_cells;
+
+		for (auto cell : topo_cells)
+		{
+			std::pair<std::string, std::vector<RTLIL::SigBit>> key(cell->type, cell_inputs(cell));
+			if (cell->type != "$_MUX_" && key.second.size() == 2 && key.second[1] < key.second[0])
+				std::swap(key.second[0], key.second[1]);
+
+			if (strash_map.count(key) != 0 && !cell->get_bool_attribute("\\keep")) {
+				RTLIL::Cell *master = strash_map.at(key);
+				if (config.verbose)
+					log("  Cell `%s' is structurally identical to cell `%s'.\n", cell->name.c_str(), master->name.c_str());
+				remove_cell(cell, master->connections.at("\\Y"));
+				count_strash++;
+				continue;
+			}
+
+			strash_map[key] = cell;
+			new_topo_cells.push_back(cell);
+		}
+
+		topo_cells.swap(new_topo_cells);
+	}
+
+	uint64_t sim_random()
+	{
+		// xorshift64*, fixed seed so that results are reproducible
+		sim_rng_state ^= sim_rng_state >> 12;
+		sim_rng_state ^= sim_rng_state << 25;
+		sim_rng_state ^= sim_rng_state >> 27;
+		return sim_rng_state * 2685821657736338717ULL;
+	}
+
+	int get_node(RTLIL::SigBit bit)
+	{
+		// undef constants are modelled as 0, just like SatGen does without model_undef
+		if (bit.wire == NULL && bit.data != RTLIL::State::S1)
+			bit = RTLIL::State::S0;
+
+		if (node_index.count(bit) != 0)
+			return node_index.at(bit);
+
+		int idx = node_bits.size();
+		node_index[bit] = idx;
+		node_bits.push_back(bit);
+
+		for (int i = 0; i < config.sim_words; i++)
+			if (bit.wire == NULL)
+				sim_data.push_back(bit.data == RTLIL::State::S1 ? ~uint64_t(0) : 0);
+			else
+				sim_data.push_back(sim_random());
+		return idx;
+	}
+
+	void simulate()
+	{
+		sim_rng_state = 88172645463325252ULL;
+
+		get_node(RTLIL::State::S0);
+		get_node(RTLIL::State::S1);
+
+		for (auto cell : topo_cells)
+		{
+			std::vector<int> in;
+			for (auto &bit : cell_inputs(cell))
+				in.push_back(get_node(bit));
+
+			RTLIL::SigBit out_bit = cell_output(cell);
+			log_assert(node_index.count(out_bit) == 0);
+			int out = node_bits.size();
+			node_index[out_bit] = out;
+			node_bits.push_back(out_bit);
+
+			for (int i = 0; i < config.sim_words; i++)
+			{
+				uint64_t a = sim_data[in[0]*config.sim_words + i], y;
+				uint64_t b = in.size() > 1 ? sim_data[in[1]*config.sim_words + i] : 0;
+				uint64_t s = in.size() > 2 ? sim_data[in[2]*config.sim_words + i] : 0;
+
+				if (cell->type == "$_INV_")
+					y = ~a;
+				else if (cell->type == "$_AND_")
+					y = a & b;
+				else if (cell->type == "$_OR_")
+					y = a | b;
+				else if (cell->type == "$_XOR_")
+					y = a ^ b;
+				else
+					y = (s & b) | (~s & a);
+
+				sim_data.push_back(y);
+			}
+		}
+	}
+
+	int import_node(RTLIL::SigBit bit)
+	{
+		if (drivers.count(bit) != 0 && sat_cells.count(drivers.at(bit)) == 0) {
+			RTLIL::Cell *cell = drivers.at(bit);
+			sat_cells.insert(cell);
+			for (auto &in_bit : cell_inputs(cell))
+				import_node(in_bit);
+			if (!satgen.importCell(cell))
+				log_abort();
+		}
+		return satgen.importSigSpec(bit).front();
+	}
+
+	bool prove(int master, int slave, bool inverted)
+	{
+		int lit_master = import_node(node_bits[master]);
+		int lit_slave = import_node(node_bits[slave]);
+
+		ez.setSolverConflictBudget(config.conflict_limit);
+		if (ez.solve(inverted ? ez.IFF(lit_master, lit_slave) : ez.XOR(lit_master, lit_slave))) {
+			count_disproven++;
+			return false;
+		}
+
+		if (ez.getSolverTimoutStatus()) {
+			count_timeout++;
+			return false;
+		}
+
+		// the proven equivalence also helps with all later queries
+		ez.assume(inverted ? ez.XOR(lit_master, lit_slave) : ez.IFF(lit_master, lit_slave));
+		count_proven++;
+		return true;
+	}
+
+	void sweep()
+	{
+		// candidate classes: nodes with identical simulation signatures, up to
+		// complement. the class members that could not be merged with an earlier
+		// member become representatives that later members are checked against.
+		std::map<std::vector<uint64_t>, std::vector<int>> class_reps;
+
+		for (size_t idx = 0; idx < node_bits.size(); idx++)
+		{
+			bool phase = sim_data[idx*config.sim_words] & 1;
+			std::vector<uint64_t> signature;
+			for (int i = 0; i < config.sim_words; i++)
+				signature.push_back(phase ? ~sim_data[idx*config.sim_words + i] : sim_data[idx*config.sim_words + i]);
+
+			std::vector<int> &reps = class_reps[signature];
+			RTLIL::Cell *cell = drivers.count(node_bits[idx]) ? drivers.at(node_bits[idx]) : NULL;
+
+			if (cell != NULL && !cell->get_bool_attribute("\\keep"))
+			{
+				int tries = 0;
+				for (int rep : reps)
+				{
+					if (config.max_tries > 0 && tries++ >= config.max_tries)
+						break;
+
+					bool inverted = phase != bool(sim_data[rep*config.sim_words] & 1);
+					if (!prove(rep, idx, inverted))
+						continue;
+
+					if (config.verbose)
+						log("  Proved %s %s %s.\n", log_signal(node_bits[idx]), inverted ? "!=" : "==", log_signal(node_bits[rep]));
+
+					merge_t m;
+					m.cell = cell;
+					m.master = node_bits[rep];
+					m.inverted = inverted;
+					merges.push_back(m);
+					goto next_node;
+				}
+			}
+
+			reps.push_back(idx);
+		next_node:;
+		}
+	}
+
+	void apply_merges()
+	{
+		std::map<RTLIL::SigBit, RTLIL::SigBit> inverted_masters;
+
+		for (auto &m : merges)
+		{
+			RTLIL::SigBit master = m.master;
+
+			if (m.inverted && master.wire == NULL) {
+				master = master.data == RTLIL::State::S1 ? RTLIL::State::S0 : RTLIL::State::S1;
+			} else if (m.inverted) {
+				if (inverted_masters.count(master) == 0) {
+					RTLIL::Wire *inv_wire = module->new_wire(1, NEW_ID);
+					RTLIL::Cell *inv_cell = new RTLIL::Cell;
+					inv_cell->name = NEW_ID;
+					inv_cell->type = "$_INV_";
+					inv_cell->connections["\\A"] = master;
+					inv_cell->connections["\\Y"] = inv_wire;
+					module->add(inv_cell);
+					inverted_masters[master] = inv_wire;
+				}
+				master = inverted_masters.at(master);
+			}
+
+			remove_cell(m.cell, master);
+		}
+	}
+
+	void run()
+	{
+		log("Running SAT sweeping on module %s:\n", RTLIL::id2cstr(module->name));
+
+		find_gates();
+		int gate_count = topo_cells.size();
+
+		strash();
+		simulate();
+		sweep();
+		apply_merges();
+
+		log("  Merged %d structurally identical gates.\n", count_strash);
+		log("  Merged %d functionally equivalent gates (%d SAT calls: %d proven, %d disproven, %d timeouts).\n",
+				int(merges.size()), count_proven + count_disproven + count_timeout, count_proven, count_disproven, count_timeout);
+		log("  Removed %d of %d gates.\n", count_strash + int(merges.size()), gate_count);
+	}
+};
+
+} /* namespace */
+
+struct FraigPass : public Pass {
+	FraigPass() : Pass("fraig", "SAT sweeping for internal gate netlists") { }
+	virtual void help()
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    fraig [options] [selection]\n");
+		log("\n");
+		log("This pass performs SAT sweeping on netlists of internal gate cells ($_INV_,\n");
+		log("$_AND_, $_OR_, $_XOR_ and $_MUX_). Structurally identical gates are merged\n");
+		log("first. Then random simulation is used to find candidate groups of gates that\n");
+		log("might be equivialent or antivalent, and the candidates are checked with an\n");
+		log("incremental SAT solver. Proven equivialent gates are merged with the first\n");
+		log("gate of their group in topological order, using an inverter if necessary.\n");
+		log("A subsequent call to 'clean' will remove the redundant drivers.\n");
+		log("\n");
+		log("    -sim <n>\n");
+		log("        use <n> 64-bit words of random simulation patterns (default: 4)\n");
+		log("\n");
+		log("    -conflicts <n>\n");
+		log("        conflict limit for each SAT query (default: 1000). a query that\n");
+		log("        exceeds the limit is treated as not equivialent. 0 means no limit.\n");
+		log("\n");
+		log("    -tries <n>\n");
+		log("        compare each gate against at most <n> earlier gates of its candidate\n");
+		log("        group (default: 8). 0 means no limit.\n");
+		log("\n");
+		log("    -v\n");
+		log("        print each merge\n");
+		log("\n");
+		log("Other cell types are treated like primary inputs. Cells with the 'keep'\n");
+		log("attribute are never removed.\n");
+		log("\n");
+	}
+	virtual void execute(std::vector<std::string> args, RTLIL::Design *design)
+	{
+		FraigConfig config;
+		config.sim_words = 4;
+		config.conflict_limit = 1000;
+		config.max_tries = 8;
+		config.verbose = false;
+
+		log_header("Executing FRAIG pass (SAT sweeping).\n");
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++) {
+			if (args[argidx] == "-sim" && argidx+1 < args.size()) {
+				config.sim_words = std::max(atoi(args[++argidx].c_str()), 1);
+				continue;
+			}
+			if (args[argidx] == "-conflicts" && argidx+1 < args.size()) {
+				config.conflict_limit = std::max(atoi(args[++argidx].c_str()), 0);
+				continue;
+			}
+			if (args[argidx] == "-tries" && argidx+1 < args.size()) {
+				config.max_tries = std::max(atoi(args[++argidx].c_str()), 0);
+				continue;
+			}
+			if (args[argidx] == "-v") {
+				config.verbose = true;
+				continue;
+			}
+			break;
+		}
+		extra_args(args, argidx, design);
+
+		for (auto &mod_it : design->modules)
+			if (design->selected(mod_it.second))
+				FraigWorker(design, mod_it.second, config).run();
+	}
+} FraigPass;
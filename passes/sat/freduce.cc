@@ -27,11 +27,14 @@
 #include <stdio.h>
 #include <string.h>
 #include <algorithm>
+#include <functional>
+#include <atomic>
+#include <thread>
 
 namespace {
 
 bool inv_mode;
-int verbose_level, reduce_counter, reduce_stop_at;
+int verbose_level, reduce_counter, reduce_stop_at, sim_words, num_threads;
 typedef std::map<RTLIL::SigBit, std::pair<RTLIL::Cell*, std::set<RTLIL::SigBit>>> drivers_t;
 std::string dump_prefix;
 
@@ -119,7 +122,7 @@ struct FindReducedInputs
 		}
 		log_assert(sat_pi_uniq_bitvec.size() == idx_bits);
 
-		sat_pi[bit] = ez.frozen_literal(stringf("p, falsei_%s", log_signal(bit)));
+		sat_pi[bit] = ez.frozen_literal(stringf("pi_%d", idx));
 		ez.assume(ez.IFF(ez.XOR(sat_a, sat_b), sat_pi[bit]));
 
 		for (size_t i = 0; i < idx_bits; i++)
@@ -238,6 +241,13 @@ struct PerformReduction
 	std::vector<int> out_depth;
 	int cone_size;
 
+	// bit-parallel random simulation: sim_words 64-bit words of values and
+	// defined-masks per signal bit, stored at sim_index[bit] * sim_words
+	std::vector<RTLIL::Cell*> cone_cells;
+	std::map<RTLIL::SigBit, int> sim_index;
+	std::vector<uint64_t> sim_val, sim_def;
+	uint64_t sim_rng_state;
+
 	int register_cone_worker(std::set<RTLIL::Cell*> &celldone, std::map<RTLIL::SigBit, int> &sigdepth, RTLIL::SigBit out)
 	{
 		if (out.wire == NULL)
@@ -247,7 +257,8 @@ struct PerformReduction
 
 		if (drivers.count(out) != 0) {
 			std::pair<RTLIL::Cell*, std::set<RTLIL::SigBit>> &drv = drivers.at(out);
-			if (celldone.count(drv.first) == 0) {
+			bool new_cell = celldone.count(drv.first) == 0;
+			if (new_cell) {
 				if (!satgen.importCell(drv.first))
 					log_error("Can't create SAT model for cell %s (%s)!\n", RTLIL::id2cstr(drv.first->name), RTLIL::id2cstr(drv.first->type));
 				celldone.insert(drv.first);
@@ -255,6 +266,8 @@ struct PerformReduction
 			int max_child_depth = 0;
 			for (auto &bit : drv.second)
 				max_child_depth = std::max(register_cone_worker(celldone, sigdepth, bit), max_child_depth);
+			if (new_cell)
+				cone_cells.push_back(drv.first);
 			sigdepth[out] = max_child_depth + 1;
 		} else {
 			pi_bits.push_back(out);
@@ -266,6 +279,150 @@ struct PerformReduction
 		return sigdepth.at(out);
 	}
 
+	uint64_t sim_random()
+	{
+		// xorshift64*, fixed seed so that results are reproducible
+		sim_rng_state ^= sim_rng_state >> 12;
+		sim_rng_state ^= sim_rng_state << 25;
+		sim_rng_state ^= sim_rng_state >> 27;
+		return sim_rng_state * 2685821657736338717ULL;
+	}
+
+	int sim_bit(RTLIL::SigBit bit)
+	{
+		if (sim_index.count(bit) != 0)
+			return sim_index.at(bit);
+
+		int idx = sim_index.size();
+		sim_index[bit] = idx;
+		sim_val.resize(sim_val.size() + sim_words, 0);
+		sim_def.resize(sim_def.size() + sim_words, 0);
+
+		if (bit.wire == NULL && (bit.data == RTLIL::State::S0 || bit.data == RTLIL::State::S1))
+			for (int i = 0; i < sim_words; i++) {
+				sim_val[idx*sim_words + i] = bit.data == RTLIL::State::S1 ? ~uint64_t(0) : 0;
+				sim_def[idx*sim_words + i] = ~uint64_t(0);
+			}
+		return idx;
+	}
+
+	std::vector<int> sim_sig(RTLIL::Cell *cell, std::string port)
+	{
+		std::vector<int> indices;
+		if (cell->connections.count(port) != 0)
+			for (auto &bit : sigmap(cell->connections.at(port)).to_sigbit_vector())
+				indices.push_back(sim_bit(bit));
+		return indices;
+	}
+
+	RTLIL::Const sim_get_const(const std::vector<int> &sig, int pattern)
+	{
+		RTLIL::Const value(RTLIL::State::Sx, sig.size());
+		int word = pattern / 64;
+		uint64_t mask = uint64_t(1) << (pattern % 64);
+		for (size_t i = 0; i < sig.size(); i++)
+			if (sim_def[sig[i]*sim_words + word] & mask)
+				value.bits[i] = (sim_val[sig[i]*sim_words + word] & mask) ? RTLIL::State::S1 : RTLIL::State::S0;
+		return value;
+	}
+
+	void sim_set_const(const std::vector<int> &sig, int pattern, const RTLIL::Const &value)
+	{
+		int word = pattern / 64;
+		uint64_t mask = uint64_t(1) << (pattern % 64);
+		for (size_t i = 0; i < sig.size() && i < value.bits.size(); i++) {
+			if (value.bits[i] == RTLIL::State::S0 || value.bits[i] == RTLIL::State::S1)
+				sim_def[sig[i]*sim_words + word] |= mask;
+			if (value.bits[i] == RTLIL::State::S1)
+				sim_val[sig[i]*sim_words + word] |= mask;
+		}
+	}
+
+	void sim_cell(RTLIL::Cell *cell)
+	{
+		std::vector<int> sig_a = sim_sig(cell, "\\A");
+		std::vector<int> sig_b = sim_sig(cell, "\\B");
+		std::vector<int> sig_s = sim_sig(cell, "\\S");
+		std::vector<int> sig_y = sim_sig(cell, "\\Y");
+
+		if (sig_y.size() == 0)
+			return;
+		for (auto &bit : sigmap(cell->connections.at("\\Y")).to_sigbit_vector())
+			if (bit.wire == NULL)
+				return;
+
+		if (cell->type == "$_INV_" || cell->type == "$_AND_" || cell->type == "$_OR_" || cell->type == "$_XOR_" || cell->type == "$_MUX_")
+		{
+			for (int i = 0; i < sim_words; i++)
+			{
+				uint64_t a = sim_val[sig_a[0]*sim_words + i], da = sim_def[sig_a[0]*sim_words + i];
+				uint64_t b = 0, db = 0, s = 0, ds = 0, y, dy;
+				if (sig_b.size() > 0)
+					b = sim_val[sig_b[0]*sim_words + i], db = sim_def[sig_b[0]*sim_words + i];
+				if (sig_s.size() > 0)
+					s = sim_val[sig_s[0]*sim_words + i], ds = sim_def[sig_s[0]*sim_words + i];
+
+				if (cell->type == "$_INV_") {
+					y = ~a, dy = da;
+				} else if (cell->type == "$_AND_") {
+					y = a & b, dy = (da & db) | (da & ~a) | (db & ~b);
+				} else if (cell->type == "$_OR_") {
+					y = a | b, dy = (da & db) | (da & a) | (db & b);
+				} else if (cell->type == "$_XOR_") {
+					y = a ^ b, dy = da & db;
+				} else {
+					y = (ds & s & b) | (ds & ~s & a) | (~ds & a & b);
+					dy = (ds & s & db) | (ds & ~s & da) | (da & db & ~(a ^ b));
+				}
+
+				sim_val[sig_y[0]*sim_words + i] = y & dy;
+				sim_def[sig_y[0]*sim_words + i] = dy;
+			}
+			return;
+		}
+
+		// coarse-grain cells are evaluated one pattern at a time, unsupported
+		// cells (e.g. $lut) leave their outputs undefined
+		if (cell->type == "$lut" || cell->type == "$assert")
+			return;
+
+		bool is_mux = cell->type == "$mux" || cell->type == "$pmux" || cell->type == "$safe_pmux";
+
+		for (int pattern = 0; pattern < 64*sim_words; pattern++)
+		{
+			RTLIL::Const value_s = sim_get_const(sig_s, pattern);
+			if (is_mux) {
+				int count_set_s_bits = 0;
+				for (auto &bit : value_s.bits) {
+					if (bit != RTLIL::State::S0 && bit != RTLIL::State::S1)
+						goto next_pattern;
+					if (bit == RTLIL::State::S1)
+						count_set_s_bits++;
+				}
+				if (cell->type == "$safe_pmux" && count_set_s_bits > 1)
+					value_s = RTLIL::Const(RTLIL::State::S0, value_s.bits.size());
+			}
+			sim_set_const(sig_y, pattern, CellTypes::eval(cell, sim_get_const(sig_a, pattern), sim_get_const(sig_b, pattern), value_s));
+		next_pattern:;
+		}
+	}
+
+	void simulate()
+	{
+		sim_rng_state = 88172645463325252ULL;
+
+		for (auto &bit : pi_bits) {
+			int idx = sim_bit(bit);
+			for (int i = 0; i < sim_words; i++) {
+				sim_val[idx*sim_words + i] = sim_random();
+				sim_def[idx*sim_words + i] = ~uint64_t(0);
+			}
+		}
+
+		for (auto cell : cone_cells)
+			sim_cell(cell);
+	}
+
 	PerformReduction(SigMap &sigmap, drivers_t &drivers, std::set<std::pair<RTLIL::SigBit, RTLIL::SigBit>> &inv_pairs, std::vector<RTLIL::SigBit> &bits, int cone_size) :
 			sigmap(sigmap), drivers(drivers), inv_pairs(inv_pairs), satgen(&ez, &sigmap), out_bits(bits), cone_size(cone_size)
 	{
@@ -288,6 +445,58 @@ struct PerformReduction
 					sat_out[i] = ez.NOT(sat_out[i]);
 		} else
 			out_inverted = std::vector<bool>(sat_out.size(), false);
+
+		if (sim_words > 0)
+			simulate();
+	}
+
+	void sim_buckets(std::vector<std::vector<int>> &sim_bucket_list)
+	{
+		// bits that are equivialent (or inverted in -inv mode) must have matching
+		// simulation signatures wherever both are defined. bits with fully defined
+		// signatures are grouped by signature, partially defined ones are added to
+		// every compatible group and also get a group of their own.
+
+		std::map<std::vector<uint64_t>, std::vector<int>> full_buckets;
+		std::vector<int> partial_bits;
+
+		for (size_t idx = 0; idx < out_bits.size(); idx++)
+		{
+			int sim_idx = sim_bit(out_bits[idx]);
+			uint64_t inv_mask = out_inverted[idx] ? ~uint64_t(0) : 0;
+			bool fully_defined = true;
+
+			std::vector<uint64_t> signature;
+			for (int i = 0; i < sim_words; i++) {
+				signature.push_back((sim_val[sim_idx*sim_words + i] ^ inv_mask) & sim_def[sim_idx*sim_words + i]);
+				if (sim_def[sim_idx*sim_words + i] != ~uint64_t(0))
+					fully_defined = false;
+			}
+
+			if (fully_defined)
+				full_buckets[signature].push_back(idx);
+			else
+				partial_bits.push_back(idx);
+		}
+
+		for (auto &it : full_buckets)
+		{
+			std::vector<int> bucket = it.second;
+			for (int idx : partial_bits) {
+				int sim_idx = sim_bit(out_bits[idx]);
+				uint64_t inv_mask = out_inverted[idx] ? ~uint64_t(0) : 0;
+				for (int i = 0; i < sim_words; i++)
+					if (((sim_val[sim_idx*sim_words + i] ^ inv_mask ^ it.first[i]) & sim_def[sim_idx*sim_words + i]) != 0)
+						goto next_partial_bit;
+				bucket.push_back(idx);
+			next_partial_bit:;
+			}
+			if (bucket.size() > 1)
+				sim_bucket_list.push_back(bucket);
+		}
+
+		if (partial_bits.size() > 1)
+			sim_bucket_list.push_back(partial_bits);
 	}
 
 	void analyze_const(std::vector<std::vector<equiv_bit_t>> &results, int idx)
@@ -483,7 +692,16 @@ struct PerformReduction
 
 		std::vector<std::set<int>> results_buf;
 		std::map<int, int> results_map;
-		analyze(results_buf, results_map, bucket, stringf("[%2d%%] %d ", perc, cone_size), "");
+
+		if (sim_words > 0) {
+			std::vector<std::vector<int>> sim_bucket_list;
+			sim_buckets(sim_bucket_list);
+			if (verbose_level >= 1)
+				log("[%2d%%] %d   Random simulation split %d signals into %d candidate buckets.\n", perc, cone_size, int(bucket.size()), int(sim_bucket_list.size()));
+			for (auto &sim_bucket : sim_bucket_list)
+				analyze(results_buf, results_map, sim_bucket, stringf("[%2d%%] %d ", perc, cone_size), "");
+		} else
+			analyze(results_buf, results_map, bucket, stringf("[%2d%%] %d ", perc, cone_size), "");
 
 		for (auto &r : results_buf)
 		{
@@ -560,6 +778,27 @@ struct FreduceWorker
 	{
 	}
 
+	bool parallel_mode()
+	{
+		// log() is not thread-safe, so verbose runs are always sequential
+		return num_threads > 1 && verbose_level == 0;
+	}
+
+	void parallel_for(int count, std::function<void(int)> func)
+	{
+		std::atomic<int> next_index(0);
+		std::vector<std::thread> threads;
+
+		for (int i = 0; i < std::min(num_threads, count); i++)
+			threads.push_back(std::thread([&]() {
+				for (int idx = next_index++; idx < count; idx = next_index++)
+					func(idx);
+			}));
+
+		for (auto &thread : threads)
+			thread.join();
+	}
+
 	bool find_bit_in_cone(std::set<RTLIL::Cell*> &celldone, RTLIL::SigBit needle, RTLIL::SigBit haystack)
 	{
 		if (needle == haystack)
@@ -629,7 +868,8 @@ struct FreduceWorker
 
 		int bits_count = 0;
 		int bits_full_count = 0;
-		std::map<std::vector<RTLIL::SigBit>, std::vector<RTLIL::SigBit>> buckets;
+		std::vector<std::set<RTLIL::SigBit>*> work_batches;
+		std::vector<int> work_batches_perc;
 		for (auto &batch : batches)
 		{
 			for (auto &bit : batch)
@@ -639,39 +879,81 @@ struct FreduceWorker
 			continue;
 
 		found_selected_wire:
+			work_batches.push_back(&batch);
+			work_batches_perc.push_back(bits_full_count);
+			bits_full_count += batch.size();
+		}
+
+		std::vector<std::vector<std::vector<RTLIL::SigBit>>> batch_inputs(work_batches.size());
+		auto find_batch_inputs = [&](int i) {
+			FindReducedInputs infinder(sigmap, drivers);
+			int count = work_batches_perc[i];
+			for (auto &bit : *work_batches[i]) {
+				batch_inputs[i].push_back(std::vector<RTLIL::SigBit>());
+				infinder.analyze(batch_inputs[i].back(), bit, 100 * count++ / bits_full_total);
+			}
+		};
+
+		if (parallel_mode())
+			parallel_for(work_batches.size(), find_batch_inputs);
+
+		std::map<std::vector<RTLIL::SigBit>, std::vector<RTLIL::SigBit>> buckets;
+		for (size_t i = 0; i < work_batches.size(); i++)
+		{
+			std::set<RTLIL::SigBit> &batch = *work_batches[i];
 			log("  Finding reduced input cone for signal batch %s%c\n",
 					log_signal(RTLIL::SigSpec(std::vector<RTLIL::SigBit>(batch.begin(), batch.end())).optimized()), verbose_level ? ':' : '.');
 
-			FindReducedInputs infinder(sigmap, drivers);
+			if (!parallel_mode())
+				find_batch_inputs(i);
+
+			int k = 0;
 			for (auto &bit : batch) {
-				std::vector<RTLIL::SigBit> inputs;
-				infinder.analyze(inputs, bit, 100 * bits_full_count / bits_full_total);
-				buckets[inputs].push_back(bit);
-				bits_full_count++;
+				buckets[batch_inputs[i][k++]].push_back(bit);
 				bits_count++;
 			}
+			batch_inputs[i].clear();
 		}
 		log("  Sorted %d signal bits into %d buckets.\n", bits_count, int(buckets.size()));
 
-		int bucket_count = 0;
-		std::vector<std::vector<equiv_bit_t>> equiv;
+		std::vector<std::pair<const std::vector<RTLIL::SigBit>, std::vector<RTLIL::SigBit>>*> work_buckets;
 		for (auto &bucket : buckets)
+			work_buckets.push_back(&bucket);
+
+		std::vector<std::vector<std::vector<equiv_bit_t>>> bucket_equiv(work_buckets.size());
+		auto reduce_bucket = [&](int i) {
+			auto &bucket = *work_buckets[i];
+			if (bucket.second.size() == 1)
+				return;
+			PerformReduction worker(sigmap, drivers, inv_pairs, bucket.second, bucket.first.size());
+			if (bucket.first.size() == 0) {
+				for (size_t idx = 0; idx < bucket.second.size(); idx++)
+					worker.analyze_const(bucket_equiv[i], idx);
+			} else
+				worker.analyze(bucket_equiv[i], 100 * (i+1) / (buckets.size() + 1));
+		};
+
+		if (parallel_mode())
+			parallel_for(work_buckets.size(), reduce_bucket);
+
+		std::vector<std::vector<equiv_bit_t>> equiv;
+		for (size_t i = 0; i < work_buckets.size(); i++)
 		{
-			bucket_count++;
+			auto &bucket = *work_buckets[i];
 
 			if (bucket.second.size() == 1)
 				continue;
 
-			if (bucket.first.size() == 0) {
+			if (bucket.first.size() == 0)
 				log("  Finding const values for bucket %s%c\n", log_signal(RTLIL::SigSpec(bucket.second).optimized()), verbose_level ? ':' : '.');
-				PerformReduction worker(sigmap, drivers, inv_pairs, bucket.second, bucket.first.size());
-				for (size_t idx = 0; idx < bucket.second.size(); idx++)
-					worker.analyze_const(equiv, idx);
-			} else {
+			else
 				log("  Trying to shatter bucket %s%c\n", log_signal(RTLIL::SigSpec(bucket.second).optimized()), verbose_level ? ':' : '.');
-				PerformReduction worker(sigmap, drivers, inv_pairs, bucket.second, bucket.first.size());
-				worker.analyze(equiv, 100 * bucket_count / (buckets.size() + 1));
-			}
+
+			if (!parallel_mode())
+				reduce_bucket(i);
+
+			equiv.insert(equiv.end(), bucket_equiv[i].begin(), bucket_equiv[i].end());
+			bucket_equiv[i].clear();
 		}
 
 		std::map<RTLIL::SigBit, int> bitusage;
@@ -768,6 +1050,16 @@ struct FreducePass : public Pass {
 		log("    -inv\n");
 		log("        enable explicit handling of inverted signals\n");
 		log("\n");
+		log("    -sim <n>\n");
+		log("        use <n> 64-bit words of bit-parallel random simulation to split\n");
+		log("        the signals into candidate groups before running the SAT solver.\n");
+		log("        the default is 4 (256 random patterns). use '-sim 0' to disable.\n");
+		log("\n");
+		log("    -j <n>\n");
+		log("        analyze independent signal batches and buckets using <n> worker\n");
+		log("        threads, each with its own SAT solver. the results are merged in\n");
+		log("        the same order as in a single-threaded run. (ignored with -v/-vv)\n");
+		log("\n");
 		log("    -stop <n>\n");
 		log("        stop after <n> reduction operations. this is mostly used for\n");
 		log("        debugging the freduce command itself.\n");
@@ -789,6 +1081,8 @@ struct FreducePass : public Pass {
 		reduce_stop_at = 0;
 		verbose_level = 0;
 		inv_mode = false;
+		sim_words = 4;
+		num_threads = 1;
 		dump_prefix = std::string();
 
 		log_header("Executing FREDUCE pass (perform functional reduction).\n");
@@ -807,6 +1101,14 @@ struct FreducePass : public Pass {
 				inv_mode = true;
 				continue;
 			}
+			if (args[argidx] == "-sim" && argidx+1 < args.size()) {
+				sim_words = std::max(atoi(args[++argidx].c_str()), 0);
+				continue;
+			}
+			if (args[argidx] == "-j" && argidx+1 < args.size()) {
+				num_threads = std::max(atoi(args[++argidx].c_str()), 1);
+				continue;
+			}
 			if (args[argidx] == "-stop" && argidx+1 < args.size()) {
 				reduce_stop_at = atoi(args[++argidx].c_str());
 				continue;
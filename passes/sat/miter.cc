@@ -19,14 +19,192 @@
 
 #include "kernel/register.h"
 #include "kernel/rtlil.h"
+#include "kernel/celltypes.h"
+#include "kernel/sigtools.h"
 #include "kernel/log.h"
 
+static void miter_import_module(RTLIL::Module *miter_module, RTLIL::Module *module, std::string prefix, std::map<RTLIL::Wire*, RTLIL::Wire*> &wire_map)
+{
+	if (module->processes.size() != 0)
+		log_cmd_error("Module %s contains processes. Run 'proc' first!\n", module->name.c_str());
+	if (module->memories.size() != 0)
+		log_cmd_error("Module %s contains memories. Run 'memory' first!\n", module->name.c_str());
+
+	for (auto &it : module->wires) {
+		if (wire_map.count(it.second) != 0)
+			continue;
+		RTLIL::Wire *w = new RTLIL::Wire;
+		w->name = it.first[0] == '\\' ? prefix + "." + it.first.substr(1) : "$miter" + prefix + "." + it.first;
+		w->width = it.second->width;
+		w->start_offset = it.second->start_offset;
+		w->attributes = it.second->attributes;
+		miter_module->add(w);
+		wire_map[it.second] = w;
+	}
+
+	struct rewrite_sigspec_worker {
+		std::map<RTLIL::Wire*, RTLIL::Wire*> &wire_map;
+		rewrite_sigspec_worker(std::map<RTLIL::Wire*, RTLIL::Wire*> &wire_map) : wire_map(wire_map) { }
+		void operator()(RTLIL::SigSpec &sig) {
+			for (auto &c : sig.chunks)
+				if (c.wire != NULL)
+					c.wire = wire_map.at(c.wire);
+		}
+	};
+
+	rewrite_sigspec_worker rewriter(wire_map);
+
+	for (auto &it : module->cells) {
+		RTLIL::Cell *c = new RTLIL::Cell;
+		c->name = it.first[0] == '\\' ? prefix + "." + it.first.substr(1) : "$miter" + prefix + "." + it.first;
+		c->type = it.second->type;
+		c->parameters = it.second->parameters;
+		c->attributes = it.second->attributes;
+		c->connections = it.second->connections;
+		c->rewrite_sigspecs(rewriter);
+		miter_module->add(c);
+	}
+
+	for (auto conn : module->connections) {
+		rewriter(conn.first);
+		rewriter(conn.second);
+		miter_module->connections.push_back(conn);
+	}
+}
+
+struct MiterShareWorker
+{
+	RTLIL::Module *module;
+	CellTypes ct;
+	SigMap sigmap;
+
+	typedef std::pair<std::pair<RTLIL::IdString, std::map<RTLIL::IdString, RTLIL::Const>>, std::map<RTLIL::IdString, RTLIL::SigSpec>> cell_key_t;
+
+	std::map<RTLIL::SigBit, RTLIL::Cell*> drivers;
+	std::set<RTLIL::Cell*> visited;
+	std::vector<RTLIL::Cell*> topo_cells;
+
+	MiterShareWorker(RTLIL::Module *module) : module(module), sigmap(module)
+	{
+		ct.setup_internals();
+		ct.setup_stdcells();
+		ct.cell_types.erase("$assert");
+	}
+
+	static bool is_commutative(RTLIL::Cell *cell)
+	{
+		static const char *types[] = { "$and", "$or", "$xor", "$xnor", "$add", "$mul", "$eq", "$ne", "$eqx", "$nex",
+				"$logic_and", "$logic_or", "$_AND_", "$_OR_", "$_XOR_", NULL };
+		for (int i = 0; types[i]; i++)
+			if (cell->type == types[i])
+				goto found_type;
+		return false;
+	found_type:
+		if (cell->parameters.count("\\A_WIDTH") != 0 && cell->parameters.at("\\A_WIDTH") != cell->parameters.at("\\B_WIDTH"))
+			return false;
+		if (cell->parameters.count("\\A_SIGNED") != 0 && cell->parameters.at("\\A_SIGNED").as_bool() != cell->parameters.at("\\B_SIGNED").as_bool())
+			return false;
+		return true;
+	}
+
+	cell_key_t cell_key(RTLIL::Cell *cell)
+	{
+		cell_key_t key;
+		key.first.first = cell->type;
+		key.first.second = cell->parameters;
+		for (auto &conn : cell->connections)
+			if (!ct.cell_output(cell->type, conn.first))
+				key.second[conn.first] = sigmap(conn.second);
+		if (is_commutative(cell) && key.second.count("\\A") && key.second.count("\\B") && key.second.at("\\B") < key.second.at("\\A"))
+			std::swap(key.second.at("\\A"), key.second.at("\\B"));
+		return key;
+	}
+
+	void topo_visit(RTLIL::Cell *root)
+	{
+		// iterative depth-first search, so long chains of gates do not overflow the stack.
+		// the second element is set when the fanin cells of the cell have been pushed.
+		std::vector<std::pair<RTLIL::Cell*, bool>> stack = { std::pair<RTLIL::Cell*, bool>(root, false) };
+		std::vector<RTLIL::Cell*> fanins;
+
+		while (!stack.empty())
+		{
+			RTLIL::Cell *cell = stack.back().first;
+
+			if (stack.back().second) {
+				stack.pop_back();
+				topo_cells.push_back(cell);
+				continue;
+			}
+
+			if (visited.count(cell) != 0) {
+				stack.pop_back();
+				continue;
+			}
+			visited.insert(cell);
+			stack.back().second = true;
+
+			fanins.clear();
+			for (auto &conn : cell->connections)
+				if (!ct.cell_output(cell->type, conn.first))
+					for (auto &bit : sigmap(conn.second).to_sigbit_vector())
+						if (drivers.count(bit) != 0 && visited.count(drivers.at(bit)) == 0)
+							fanins.push_back(drivers.at(bit));
+
+			// pushed in reverse order, so the fanins are visited in connection order
+			for (auto it = fanins.rbegin(); it != fanins.rend(); it++)
+				stack.push_back(std::pair<RTLIL::Cell*, bool>(*it, false));
+		}
+	}
+
+	int run()
+	{
+		for (auto &it : module->cells)
+			if (ct.cell_known(it.second->type))
+				for (auto &conn : it.second->connections)
+					if (ct.cell_output(it.second->type, conn.first))
+						for (auto &bit : sigmap(conn.second).to_sigbit_vector())
+							if (bit.wire != NULL)
+								drivers[bit] = it.second;
+
+		for (auto &it : module->cells)
+			if (ct.cell_known(it.second->type))
+				topo_visit(it.second);
+
+		// inputs are always visited before the cells driven by them, so a
+		// single pass merges complete identical cones
+		int count = 0;
+		std::map<cell_key_t, RTLIL::Cell*> sharemap;
+		for (auto cell : topo_cells)
+		{
+			cell_key_t key = cell_key(cell);
+			if (sharemap.count(key) == 0) {
+				sharemap[key] = cell;
+				continue;
+			}
+
+			RTLIL::Cell *master = sharemap.at(key);
+			for (auto &conn : cell->connections)
+				if (ct.cell_output(cell->type, conn.first)) {
+					module->connections.push_back(RTLIL::SigSig(conn.second, master->connections.at(conn.first)));
+					sigmap.add(conn.second, master->connections.at(conn.first));
+				}
+			module->cells.erase(cell->name);
+			delete cell;
+			count++;
+		}
+
+		return count;
+	}
+};
+
 static void create_miter_equiv(struct Pass *that, std::vector<std::string> args, RTLIL::Design *design)
 {
 	bool flag_ignore_gold_x = false;
 	bool flag_make_outputs = false;
 	bool flag_make_outcmp = false;
 	bool flag_make_assert = false;
+	bool flag_share = false;
 
 	size_t argidx;
 	for (argidx = 2; argidx < args.size(); argidx++)
@@ -47,6 +225,10 @@ static void create_miter_equiv(struct Pass *that, std::vector<std::string> args,
 			flag_make_assert = true;
 			continue;
 		}
+		if (args[argidx] == "-share") {
+			flag_share = true;
+			continue;
+		}
 		break;
 	}
 	if (argidx+3 != args.size() || args[argidx].substr(0, 1) == "-")
@@ -109,12 +291,22 @@ static void create_miter_equiv(struct Pass *that, std::vector<std::string> args,
 	RTLIL::Cell *gold_cell = new RTLIL::Cell;
 	gold_cell->name = "\\gold";
 	gold_cell->type = gold_name;
-	miter_module->add(gold_cell);
 
 	RTLIL::Cell *gate_cell = new RTLIL::Cell;
 	gate_cell->name = "\\gate";
 	gate_cell->type = gate_name;
-	miter_module->add(gate_cell);
+
+	if (flag_share) {
+		delete gold_cell;
+		delete gate_cell;
+		gold_cell = NULL;
+		gate_cell = NULL;
+	} else {
+		miter_module->add(gold_cell);
+		miter_module->add(gate_cell);
+	}
+
+	std::map<RTLIL::Wire*, RTLIL::Wire*> gold_wire_map, gate_wire_map;
 
 	RTLIL::SigSpec all_conditions;
 
@@ -130,8 +322,13 @@ static void create_miter_equiv(struct Pass *that, std::vector<std::string> args,
 			w2->width = w1->width;
 			miter_module->add(w2);
 
-			gold_cell->connections[w1->name] = w2;
-			gate_cell->connections[w1->name] = w2;
+			if (flag_share) {
+				gold_wire_map[w1] = w2;
+				gate_wire_map[gate_module->wires.at(w1->name)] = w2;
+			} else {
+				gold_cell->connections[w1->name] = w2;
+				gate_cell->connections[w1->name] = w2;
+			}
 		}
 
 		if (w1->port_output)
@@ -148,8 +345,15 @@ static void create_miter_equiv(struct Pass *that, std::vector<std::string> args,
 			w2_gate->width = w1->width;
 			miter_module->add(w2_gate);
 
-			gold_cell->connections[w1->name] = w2_gold;
-			gate_cell->connections[w1->name] = w2_gate;
+			if (flag_share) {
+				if (!w1->port_input) {
+					gold_wire_map[w1] = w2_gold;
+					gate_wire_map[gate_module->wires.at(w1->name)] = w2_gate;
+				}
+			} else {
+				gold_cell->connections[w1->name] = w2_gold;
+				gate_cell->connections[w1->name] = w2_gate;
+			}
 
 			RTLIL::SigSpec this_condition;
 
@@ -282,6 +486,16 @@ static void create_miter_equiv(struct Pass *that, std::vector<std::string> args,
 	not_cell->connections["\\Y"] = w_trigger;
 	miter_module->add(not_cell);
 
+	if (flag_share)
+	{
+		miter_import_module(miter_module, gold_module, "\\gold", gold_wire_map);
+		miter_import_module(miter_module, gate_module, "\\gate", gate_wire_map);
+
+		int cell_count = miter_module->cells.size();
+		int merged_count = MiterShareWorker(miter_module).run();
+		log("Merged %d of %d cells in the shared miter circuit.\n", merged_count, cell_count);
+	}
+
 	miter_module->fixup_ports();
 }
 
@@ -313,6 +527,13 @@ struct MiterPass : public Pass {
 		log("    -make_assert\n");
 		log("        also create an 'assert' cell that checks if trigger is always low.\n");
 		log("\n");
+		log("    -share\n");
+		log("        instead of instantiating the gold and gate modules, copy their contents\n");
+		log("        into the miter circuit and merge structurally identical combinational\n");
+		log("        cells. this way logic that is shared by the two modules is only\n");
+		log("        represented once and only the actual differences remain for the\n");
+		log("        solver. (run 'flatten' first to also cover sub-modules.)\n");
+		log("\n");
 	}
 	virtual void execute(std::vector<std::string> args, RTLIL::Design *design)
 	{
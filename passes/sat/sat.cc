@@ -53,6 +53,10 @@ struct SatHelper
 
 	// undef constraints
 	bool enable_undef, set_init_def, set_init_undef, set_init_zero, ignore_unknown_cells;
+
+	// cone of influence reduction and structural hashing
+	bool enable_coi, cells_prepared;
+	std::vector<RTLIL::Cell*> import_cells;
 	std::vector<std::string> sets_def, sets_any_undef, sets_all_undef;
 	std::map<int, std::vector<std::string>> sets_def_at, sets_any_undef_at, sets_all_undef_at;
 
@@ -60,7 +64,7 @@ struct SatHelper
 	std::vector<std::string> shows;
 	SigPool show_signal_pool;
 	SigSet<RTLIL::Cell*> show_drivers;
-	int max_timestep, timeout;
+	int max_timestep, timeout, portfolio;
 	bool gotTimeout;
 
 	SatHelper(RTLIL::Design *design, RTLIL::Module *module, bool enable_undef) :
@@ -72,9 +76,13 @@ struct SatHelper
 		set_init_undef = false;
 		set_init_zero = false;
 		ignore_unknown_cells = false;
+		enable_coi = false;
+		cells_prepared = false;
 		max_timestep = -1;
 		timeout = 0;
+		portfolio = 1;
 		gotTimeout = false;
+		modelMaxTimestep = -2;
 	}
 
 	void check_undef_enabled(const RTLIL::SigSpec &sig)
@@ -103,6 +111,13 @@ struct SatHelper
 			RTLIL::SigSpec rhs = it.second->attributes.at("\\init");
 			log_assert(lhs.width == rhs.width);
 
+			// registers outside the cone of influence have not been imported
+			if (enable_coi) {
+				lhs.remove2(satgen.initial_state.remove(lhs), &rhs);
+				if (lhs.width == 0)
+					continue;
+			}
+
 			log("Import set-constraint from init attribute: %s = %s\n", log_signal(lhs), log_signal(rhs));
 			big_lhs.remove2(lhs, &big_rhs);
 			big_lhs.append(lhs);
@@ -166,8 +181,182 @@ struct SatHelper
 		ez.assume(satgen.signals_eq(big_lhs, big_rhs, 1));
 	}
 
+	void add_coi_root(SigPool &roots, std::string lhs_str, std::string rhs_str = std::string())
+	{
+		// errors are ignored here. they are reported when the constraint is imported.
+		RTLIL::SigSpec lhs, rhs;
+		if (!RTLIL::SigSpec::parse_sel(lhs, design, module, lhs_str))
+			return;
+		roots.add(sigmap(lhs));
+		if (!rhs_str.empty() && RTLIL::SigSpec::parse_rhs(lhs, rhs, module, rhs_str))
+			roots.add(sigmap(rhs));
+	}
+
+	std::string cell_hash_key(RTLIL::Cell *cell)
+	{
+		std::map<RTLIL::IdString, RTLIL::SigSpec> conn;
+		for (auto &p : cell->connections)
+			if (!ct.cell_output(cell->type, p.first))
+				conn[p.first] = sigmap(p.second);
+
+		if (cell->type == "$and" || cell->type == "$or" || cell->type == "$xor" || cell->type == "$xnor" || cell->type == "$add" || cell->type == "$mul" ||
+				cell->type == "$logic_and" || cell->type == "$logic_or" || cell->type == "$_AND_" || cell->type == "$_OR_" || cell->type == "$_XOR_") {
+			if (conn.at("\\A") < conn.at("\\B"))
+				std::swap(conn.at("\\A"), conn.at("\\B"));
+		}
+
+		std::string key = cell->type + "\n";
+		for (auto &it : cell->parameters)
+			key += "P " + it.first + "=" + it.second.as_string() + "\n";
+		for (auto &it : conn)
+			key += "C " + it.first + "=" + log_signal(it.second) + "\n";
+		return key;
+	}
+
+	void prepare_cells()
+	{
+		if (cells_prepared)
+			return;
+		cells_prepared = true;
+
+		std::vector<RTLIL::Cell*> selected_cells;
+		for (auto &c : module->cells)
+			if (design->selected(module, c.second))
+				selected_cells.push_back(c.second);
+
+		if (!enable_coi) {
+			import_cells = selected_cells;
+			return;
+		}
+
+		log("\nComputing cone of influence:\n");
+
+		// the cone of influence is the transitive fanin (across all time steps,
+		// i.e. also through the registers) of all constrained, proven and shown
+		// signals. cells that add constraints on their own are additional roots.
+
+		SigPool roots;
+		for (auto &s : sets)
+			add_coi_root(roots, s.first, s.second);
+		for (auto &it : sets_at)
+			for (auto &s : it.second)
+				add_coi_root(roots, s.first, s.second);
+		for (auto &it : unsets_at)
+			for (auto &s : it.second)
+				add_coi_root(roots, s);
+		for (auto &s : sets_init)
+			add_coi_root(roots, s.first, s.second);
+		for (auto &s : prove)
+			add_coi_root(roots, s.first, s.second);
+		for (auto &s : prove_x)
+			add_coi_root(roots, s.first, s.second);
+		for (auto list : { &sets_def, &sets_any_undef, &sets_all_undef, &shows })
+			for (auto &s : *list)
+				add_coi_root(roots, s);
+		for (auto map : { &sets_def_at, &sets_any_undef_at, &sets_all_undef_at })
+			for (auto &it : *map)
+				for (auto &s : it.second)
+					add_coi_root(roots, s);
+
+		SigSet<RTLIL::Cell*> drivers;
+		std::set<RTLIL::Cell*> cone;
+
+		for (auto cell : selected_cells) {
+			if (!ct.cell_known(cell->type) || (cell->type == "$assert" && prove_asserts) ||
+					((cell->type == "$div" || cell->type == "$mod") && satgen.ignore_div_by_zero)) {
+				cone.insert(cell);
+				for (auto &p : cell->connections)
+					roots.add(sigmap(p.second));
+				continue;
+			}
+			for (auto &p : cell->connections)
+				if (ct.cell_output(cell->type, p.first))
+					drivers.insert(sigmap(p.second), cell);
+		}
+
+		SigPool queued_signals = roots, handled_signals;
+		while (queued_signals.size() > 0) {
+			RTLIL::SigSpec sig = queued_signals.export_all();
+			queued_signals.clear();
+			handled_signals.add(sig);
+			for (auto cell : drivers.find(sig)) {
+				if (cone.count(cell))
+					continue;
+				cone.insert(cell);
+				for (auto &p : cell->connections)
+					if (!ct.cell_output(cell->type, p.first))
+						queued_signals.add(handled_signals.remove(sigmap(p.second)));
+			}
+		}
+
+		// merge structurally identical combinational cells within the cone by
+		// connecting their outputs in the sigmap, so they share one set of
+		// variables and only one of them is imported.
+
+		CellTypes ct_comb;
+		ct_comb.setup_internals();
+		ct_comb.setup_stdcells();
+
+		std::set<RTLIL::Cell*> merged;
+		for (bool did_something = true; did_something;)
+		{
+			did_something = false;
+			std::map<std::string, RTLIL::Cell*> known_cells;
+
+			for (auto cell : selected_cells)
+			{
+				if (!cone.count(cell) || merged.count(cell) || !ct_comb.cell_known(cell->type) || cell->type == "$assert")
+					continue;
+
+				std::string key = cell_hash_key(cell);
+				if (known_cells.count(key) == 0) {
+					known_cells[key] = cell;
+					continue;
+				}
+
+				// outputs that are (partially) driven by constants are left alone
+				RTLIL::Cell *other = known_cells.at(key);
+				bool compatible = true;
+				for (auto &p : cell->connections)
+					if (ct.cell_output(cell->type, p.first)) {
+						RTLIL::SigSpec sig = sigmap(p.second), other_sig = sigmap(other->connections.at(p.first));
+						if (sig.width != other_sig.width)
+							compatible = false;
+						for (auto &c : sig.chunks)
+							if (c.wire == NULL)
+								compatible = false;
+						for (auto &c : other_sig.chunks)
+							if (c.wire == NULL)
+								compatible = false;
+					}
+				if (!compatible)
+					continue;
+
+				for (auto &p : cell->connections)
+					if (ct.cell_output(cell->type, p.first))
+						sigmap.add(p.second, other->connections.at(p.first));
+				merged.insert(cell);
+				did_something = true;
+			}
+		}
+
+		int pruned_count = 0;
+		for (auto cell : selected_cells) {
+			if (cone.count(cell) == 0)
+				pruned_count++;
+			else if (merged.count(cell) == 0)
+				import_cells.push_back(cell);
+		}
+
+		log("Pruned %d of %d selected cells outside the cone of influence.\n", pruned_count, int(selected_cells.size()));
+		log("Merged %d structurally identical cells.\n", int(merged.size()));
+		log("Importing %d cells to SAT database.\n", int(import_cells.size()));
+	}
+
 	void setup(int timestep = -1)
 	{
+		prepare_cells();
+
 		if (timestep > 0)
 			log ("\nSetting up time step %d:\n", timestep);
 		else
@@ -302,18 +491,17 @@ struct SatHelper
 		}
 
 		int import_cell_counter = 0;
-		for (auto &c : module->cells)
-			if (design->selected(module, c.second)) {
-				// log("Import cell: %s\n", RTLIL::id2cstr(c.first));
-				if (satgen.importCell(c.second, timestep)) {
-					for (auto &p : c.second->connections)
-						if (ct.cell_output(c.second->type, p.first))
-							show_drivers.insert(sigmap(p.second), c.second);
-					import_cell_counter++;
-				} else if (ignore_unknown_cells)
-					log("Warning: Failed to import cell %s (type %s) to SAT database.\n", RTLIL::id2cstr(c.first), RTLIL::id2cstr(c.second->type));
-				else
-					log_error("Failed to import cell %s (type %s) to SAT database.\n", RTLIL::id2cstr(c.first), RTLIL::id2cstr(c.second->type));
+		for (auto cell : import_cells) {
+			// log("Import cell: %s\n", RTLIL::id2cstr(cell->name));
+			if (satgen.importCell(cell, timestep)) {
+				for (auto &p : cell->connections)
+					if (ct.cell_output(cell->type, p.first))
+						show_drivers.insert(sigmap(p.second), cell);
+				import_cell_counter++;
+			} else if (ignore_unknown_cells)
+				log("Warning: Failed to import cell %s (type %s) to SAT database.\n", RTLIL::id2cstr(cell->name), RTLIL::id2cstr(cell->type));
+			else
+				log_error("Failed to import cell %s (type %s) to SAT database.\n", RTLIL::id2cstr(cell->name), RTLIL::id2cstr(cell->type));
 		}
 		log("Imported %d cells to SAT database.\n", import_cell_counter);
 	}
@@ -401,6 +589,91 @@ struct SatHelper
 		return ez.expression(ezSAT::OpAnd, prove_bits);
 	}
 
+	void setup_proof_batch(std::vector<std::string> &names, std::vector<int> &prove_exprs, int timestep = -1)
+	{
+		assert(prove.size() || prove_x.size() || prove_asserts);
+
+		names.clear();
+		prove_exprs.clear();
+
+		for (auto &s : prove)
+		{
+			RTLIL::SigSpec lhs, rhs;
+
+			if (!RTLIL::SigSpec::parse_sel(lhs, design, module, s.first))
+				log_cmd_error("Failed to parse lhs proof expression `%s'.\n", s.first.c_str());
+			if (!RTLIL::SigSpec::parse_rhs(lhs, rhs, module, s.second))
+				log_cmd_error("Failed to parse rhs proof expression `%s'.\n", s.second.c_str());
+			show_signal_pool.add(sigmap(lhs));
+			show_signal_pool.add(sigmap(rhs));
+
+			if (lhs.width != rhs.width)
+				log_cmd_error("Proof expression with different lhs and rhs sizes: %s (%s, %d bits) vs. %s (%s, %d bits)\n",
+					s.first.c_str(), log_signal(lhs), lhs.width, s.second.c_str(), log_signal(rhs), rhs.width);
+
+			log("Import proof-constraint: %s = %s\n", log_signal(lhs), log_signal(rhs));
+			check_undef_enabled(lhs), check_undef_enabled(rhs);
+			names.push_back(stringf("-prove %s %s", s.first.c_str(), s.second.c_str()));
+			prove_exprs.push_back(satgen.signals_eq(lhs, rhs, timestep));
+		}
+
+		for (auto &s : prove_x)
+		{
+			RTLIL::SigSpec lhs, rhs;
+
+			if (!RTLIL::SigSpec::parse_sel(lhs, design, module, s.first))
+				log_cmd_error("Failed to parse lhs proof-x expression `%s'.\n", s.first.c_str());
+			if (!RTLIL::SigSpec::parse_rhs(lhs, rhs, module, s.second))
+				log_cmd_error("Failed to parse rhs proof-x expression `%s'.\n", s.second.c_str());
+			show_signal_pool.add(sigmap(lhs));
+			show_signal_pool.add(sigmap(rhs));
+
+			if (lhs.width != rhs.width)
+				log_cmd_error("Proof-x expression with different lhs and rhs sizes: %s (%s, %d bits) vs. %s (%s, %d bits)\n",
+					s.first.c_str(), log_signal(lhs), lhs.width, s.second.c_str(), log_signal(rhs), rhs.width);
+
+			log("Import proof-x-constraint: %s = %s\n", log_signal(lhs), log_signal(rhs));
+
+			std::vector<int> value_lhs = satgen.importDefSigSpec(lhs, timestep);
+			std::vector<int> value_rhs = satgen.importDefSigSpec(rhs, timestep);
+
+			std::vector<int> undef_lhs = satgen.importUndefSigSpec(lhs, timestep);
+			std::vector<int> undef_rhs = satgen.importUndefSigSpec(rhs, timestep);
+
+			std::vector<int> prove_bits;
+			for (size_t i = 0; i < value_lhs.size(); i++)
+				prove_bits.push_back(ez.OR(undef_lhs.at(i), ez.AND(ez.NOT(undef_rhs.at(i)), ez.NOT(ez.XOR(value_lhs.at(i), value_rhs.at(i))))));
+
+			names.push_back(stringf("-prove-x %s %s", s.first.c_str(), s.second.c_str()));
+			prove_exprs.push_back(ez.expression(ezSAT::OpAnd, prove_bits));
+		}
+
+		if (prove_asserts)
+		{
+			// one property per assert cell, using the same encoding as SatGen::importAsserts()
+			RTLIL::SigSpec asserts_a, asserts_en;
+			satgen.getAsserts(asserts_a, asserts_en, timestep);
+			asserts_a.expand();
+			asserts_en.expand();
+
+			for (size_t i = 0; i < asserts_a.chunks.size(); i++)
+			{
+				int check_bit, enable_bit;
+				if (satgen.model_undef) {
+					check_bit = ez.AND(ez.NOT(satgen.importUndefSigSpec(asserts_a.chunks[i], timestep).front()), satgen.importDefSigSpec(asserts_a.chunks[i], timestep).front());
+					enable_bit = ez.AND(ez.NOT(satgen.importUndefSigSpec(asserts_en.chunks[i], timestep).front()), satgen.importDefSigSpec(asserts_en.chunks[i], timestep).front());
+				} else {
+					check_bit = satgen.importDefSigSpec(asserts_a.chunks[i], timestep).front();
+					enable_bit = satgen.importDefSigSpec(asserts_en.chunks[i], timestep).front();
+				}
+
+				log("Import proof for assert: %s when %s.\n", log_signal(asserts_a.chunks[i]), log_signal(asserts_en.chunks[i]));
+				names.push_back(stringf("assert %s when %s", log_signal(asserts_a.chunks[i]), log_signal(asserts_en.chunks[i])));
+				prove_exprs.push_back(ez.OR(check_bit, ez.NOT(enable_bit)));
+			}
+		}
+	}
+
 	void force_unique_state(int timestep_from, int timestep_to)
 	{
 		RTLIL::SigSpec state_signals = satgen.initial_state.export_all();
@@ -411,7 +684,11 @@ struct SatHelper
 	bool solve(const std::vector<int> &assumptions)
 	{
 		log_assert(gotTimeout == false);
+		// the threads of a portfolio may share a cpu, so the deadline of
+		// a portfolio run is also checked against the wall clock
 		ez.setSolverTimeout(timeout);
+		ez.setSolverWallTimeout(portfolio > 1 ? timeout : 0);
+		ez.setPortfolioSize(portfolio);
 		bool success = ez.solve(modelExpressions, modelValues, assumptions);
 		if (ez.getSolverTimoutStatus())
 			gotTimeout = true;
@@ -422,6 +699,8 @@ struct SatHelper
 	{
 		log_assert(gotTimeout == false);
 		ez.setSolverTimeout(timeout);
+		ez.setSolverWallTimeout(portfolio > 1 ? timeout : 0);
+		ez.setPortfolioSize(portfolio);
 		bool success = ez.solve(modelExpressions, modelValues, a, b, c, d, e, f);
 		if (ez.getSolverTimoutStatus())
 			gotTimeout = true;
@@ -448,7 +727,16 @@ struct SatHelper
 	std::vector<bool> modelValues;
 	std::set<ModelBlockInfo> modelInfo;
 
-	void maximize_undefs()
+	// state for incremental model generation: in temporal induction proofs
+	// generate_model() is called once per induction length, but only the
+	// blocks for the newly added time steps need to be imported. the model
+	// is rebuilt when the signals it was built from have changed.
+	RTLIL::SigSpec modelSig;
+	std::vector<int> modelValueExpressions, modelUndefExpressions;
+	SigPool modelSigPool, modelInitState;
+	int modelMaxTimestep;
+
+	void maximize_undefs(int assumption = 0)
 	{
 		log_assert(enable_undef);
 		std::vector<bool> backupValues;
@@ -464,7 +752,7 @@ struct SatHelper
 					maybe_undef.push_back(modelExpressions.at(modelExpressions.size()/2 + i));
 
 			backupValues.swap(modelValues);
-			if (!solve(ez.expression(ezSAT::OpAnd, must_undef), ez.expression(ezSAT::OpOr, maybe_undef)))
+			if (!solve(assumption, ez.expression(ezSAT::OpAnd, must_undef), ez.expression(ezSAT::OpOr, maybe_undef)))
 				break;
 		}
 
@@ -473,107 +761,121 @@ struct SatHelper
 
 	void generate_model()
 	{
-		RTLIL::SigSpec modelSig;
-		modelExpressions.clear();
-		modelInfo.clear();
-
-		// Add "show" signals or alternatively the leaves on the input cone on all set and prove signals
+		bool rebuild = modelMaxTimestep == -2 || modelSigPool.bits != show_signal_pool.bits ||
+				modelInitState.bits != satgen.initial_state.bits || (modelMaxTimestep <= 0 && max_timestep > 0);
 
-		if (shows.size() == 0)
+		if (rebuild)
 		{
-			SigPool queued_signals, handled_signals, final_signals;
-			queued_signals = show_signal_pool;
-			while (queued_signals.size() > 0) {
-				RTLIL::SigSpec sig = queued_signals.export_one();
-				queued_signals.del(sig);
-				handled_signals.add(sig);
-				std::set<RTLIL::Cell*> drivers = show_drivers.find(sig);
-				if (drivers.size() == 0) {
-					final_signals.add(sig);
-				} else {
-					for (auto &d : drivers)
-					for (auto &p : d->connections) {
-						if (d->type == "$dff" && p.first == "\\CLK")
-							continue;
-						if (d->type.substr(0, 6) == "$_DFF_" && p.first == "\\C")
-							continue;
-						queued_signals.add(handled_signals.remove(sigmap(p.second)));
+			modelSig = RTLIL::SigSpec();
+			modelInfo.clear();
+			modelValueExpressions.clear();
+			modelUndefExpressions.clear();
+			modelSigPool = show_signal_pool;
+			modelInitState = satgen.initial_state;
+			modelMaxTimestep = -2;
+
+			// Add "show" signals or alternatively the leaves on the input cone on all set and prove signals
+
+			if (shows.size() == 0)
+			{
+				SigPool queued_signals, handled_signals, final_signals;
+				queued_signals = show_signal_pool;
+				while (queued_signals.size() > 0) {
+					RTLIL::SigSpec sig = queued_signals.export_one();
+					queued_signals.del(sig);
+					handled_signals.add(sig);
+					std::set<RTLIL::Cell*> drivers = show_drivers.find(sig);
+					if (drivers.size() == 0) {
+						final_signals.add(sig);
+					} else {
+						for (auto &d : drivers)
+						for (auto &p : d->connections) {
+							if (d->type == "$dff" && p.first == "\\CLK")
+								continue;
+							if (d->type.substr(0, 6) == "$_DFF_" && p.first == "\\C")
+								continue;
+							queued_signals.add(handled_signals.remove(sigmap(p.second)));
+						}
 					}
 				}
-			}
-			modelSig = final_signals.export_all();
+				modelSig = final_signals.export_all();
 
-			// additionally add all set and prove signals directly
-			// (it improves user confidence if we write the constraints back ;-)
-			modelSig.append(show_signal_pool.export_all());
-		}
-		else
-		{
-			for (auto &s : shows) {
-				RTLIL::SigSpec sig;
-				if (!RTLIL::SigSpec::parse_sel(sig, design, module, s))
-					log_cmd_error("Failed to parse show expression `%s'.\n", s.c_str());
-				log("Import show expression: %s\n", log_signal(sig));
-				modelSig.append(sig);
+				// additionally add all set and prove signals directly
+				// (it improves user confidence if we write the constraints back ;-)
+				modelSig.append(show_signal_pool.export_all());
 			}
-		}
-
-		modelSig.sort_and_unify();
-		// log("Model signals: %s\n", log_signal(modelSig));
-
-		std::vector<int> modelUndefExpressions;
-
-		for (auto &c : modelSig.chunks)
-			if (c.wire != NULL)
+			else
 			{
-				ModelBlockInfo info;
-				RTLIL::SigSpec chunksig = c;
-				info.width = chunksig.width;
-				info.description = log_signal(chunksig);
+				for (auto &s : shows) {
+					RTLIL::SigSpec sig;
+					if (!RTLIL::SigSpec::parse_sel(sig, design, module, s))
+						log_cmd_error("Failed to parse show expression `%s'.\n", s.c_str());
+					log("Import show expression: %s\n", log_signal(sig));
+					modelSig.append(sig);
+				}
+			}
 
-				for (int timestep = -1; timestep <= max_timestep; timestep++)
+			modelSig.sort_and_unify();
+			// log("Model signals: %s\n", log_signal(modelSig));
+
+			// Add initial state signals as collected by satgen
+			//
+			RTLIL::SigSpec initSig = satgen.initial_state.export_all();
+			for (auto &c : initSig.chunks)
+				if (c.wire != NULL)
 				{
-					if ((timestep == -1 && max_timestep > 0) || timestep == 0)
-						continue;
+					ModelBlockInfo info;
+					RTLIL::SigSpec chunksig = c;
 
-					info.timestep = timestep;
-					info.offset = modelExpressions.size();
+					info.timestep = 0;
+					info.offset = modelValueExpressions.size();
+					info.width = chunksig.width;
+					info.description = log_signal(chunksig);
 					modelInfo.insert(info);
 
-					std::vector<int> vec = satgen.importSigSpec(chunksig, timestep);
-					modelExpressions.insert(modelExpressions.end(), vec.begin(), vec.end());
+					std::vector<int> vec = satgen.importSigSpec(chunksig, 1);
+					modelValueExpressions.insert(modelValueExpressions.end(), vec.begin(), vec.end());
 
 					if (enable_undef) {
-						std::vector<int> undef_vec = satgen.importUndefSigSpec(chunksig, timestep);
+						std::vector<int> undef_vec = satgen.importUndefSigSpec(chunksig, 1);
 						modelUndefExpressions.insert(modelUndefExpressions.end(), undef_vec.begin(), undef_vec.end());
 					}
 				}
-			}
+		}
 
-		// Add initial state signals as collected by satgen
-		//
-		modelSig = satgen.initial_state.export_all();
-		for (auto &c : modelSig.chunks)
-			if (c.wire != NULL)
-			{
-				ModelBlockInfo info;
-				RTLIL::SigSpec chunksig = c;
+		// Import the model signals for all time steps not covered by an earlier call.
+		// The order of the blocks in modelExpressions does not matter, modelInfo holds
+		// the offsets and is sorted by time step.
+
+		for (int timestep = std::max(-1, modelMaxTimestep + 1); timestep <= max_timestep; timestep++)
+		{
+			if ((timestep == -1 && max_timestep > 0) || timestep == 0)
+				continue;
 
-				info.timestep = 0;
-				info.offset = modelExpressions.size();
-				info.width = chunksig.width;
-				info.description = log_signal(chunksig);
-				modelInfo.insert(info);
+			for (auto &c : modelSig.chunks)
+				if (c.wire != NULL)
+				{
+					ModelBlockInfo info;
+					RTLIL::SigSpec chunksig = c;
+					info.width = chunksig.width;
+					info.description = log_signal(chunksig);
+					info.timestep = timestep;
+					info.offset = modelValueExpressions.size();
+					modelInfo.insert(info);
 
-				std::vector<int> vec = satgen.importSigSpec(chunksig, 1);
-				modelExpressions.insert(modelExpressions.end(), vec.begin(), vec.end());
+					std::vector<int> vec = satgen.importSigSpec(chunksig, timestep);
+					modelValueExpressions.insert(modelValueExpressions.end(), vec.begin(), vec.end());
 
-				if (enable_undef) {
-					std::vector<int> undef_vec = satgen.importUndefSigSpec(chunksig, 1);
-					modelUndefExpressions.insert(modelUndefExpressions.end(), undef_vec.begin(), undef_vec.end());
+					if (enable_undef) {
+						std::vector<int> undef_vec = satgen.importUndefSigSpec(chunksig, timestep);
+						modelUndefExpressions.insert(modelUndefExpressions.end(), undef_vec.begin(), undef_vec.end());
+					}
 				}
-			}
+		}
+
+		modelMaxTimestep = max_timestep;
 
+		modelExpressions = modelValueExpressions;
 		modelExpressions.insert(modelExpressions.end(), modelUndefExpressions.begin(), modelUndefExpressions.end());
 	}
 
@@ -793,6 +1095,92 @@ static void print_qed()
 	log("\n");
 }
 
+static void run_batch_proof(SatHelper &sathelper, std::vector<std::string> &names, std::vector<int> &prove_exprs,
+		bool verify, bool falsify, bool fail_on_timeout, bool max_undef, std::string vcd_file_name)
+{
+	ezSAT &ez = sathelper.ez;
+	std::vector<int> activation_literals;
+	std::vector<std::string> results;
+	int count_proven = 0, count_failed = 0, count_timeout = 0;
+
+	// each property gets an activation literal that enables the negated
+	// property. only one of them is assumed per solver call.
+	for (size_t i = 0; i < prove_exprs.size(); i++) {
+		activation_literals.push_back(ez.frozen_literal(stringf("prove_batch_%d", int(i))));
+		ez.assume(ez.OR(ez.NOT(activation_literals.back()), ez.NOT(prove_exprs[i])));
+	}
+
+	for (size_t i = 0; i < prove_exprs.size(); i++)
+	{
+		log("\nProving property %d of %d: %s\n", int(i+1), int(prove_exprs.size()), names[i].c_str());
+		log("Solving problem with %d variables and %d clauses..\n", ez.numCnfVariables(), ez.numCnfClauses());
+		if (ez.numCnfClausesSaved() > 0)
+			log("Polarity-aware encoding omitted %d clauses.\n", ez.numCnfClausesSaved());
+
+		if (sathelper.solve(activation_literals[i]))
+		{
+			if (max_undef) {
+				log("SAT model found. maximizing number of undefs.\n");
+				sathelper.maximize_undefs(activation_literals[i]);
+			}
+
+			log("SAT proof finished - model found: FAIL!\n");
+			sathelper.print_model();
+
+			// one file per failed property: foo.vcd -> foo_<property number>.vcd
+			if (!vcd_file_name.empty()) {
+				size_t dot = vcd_file_name.rfind('.');
+				if (dot == std::string::npos || vcd_file_name.find('/', dot) != std::string::npos)
+					dot = vcd_file_name.size();
+				sathelper.dump_model_to_vcd(stringf("%s_%d%s", vcd_file_name.substr(0, dot).c_str(), int(i+1), vcd_file_name.substr(dot).c_str()));
+			}
+
+			results.push_back("FAILED");
+			count_failed++;
+		}
+		else if (sathelper.gotTimeout)
+		{
+			log("Interrupted SAT solver: TIMEOUT!\n");
+			sathelper.gotTimeout = false;
+			results.push_back("TIMEOUT");
+			count_timeout++;
+		}
+		else
+		{
+			log("SAT proof finished - no model found: SUCCESS!\n");
+			// a proven property holds in every model and can help with the remaining ones
+			ez.assume(prove_exprs[i]);
+			results.push_back("PROVEN");
+			count_proven++;
+		}
+	}
+
+	log("\nBatch proof results (%d proven, %d failed, %d timeout):\n", count_proven, count_failed, count_timeout);
+	log("\n  %-5s %-8s %s\n", "#", "result", "property");
+	for (size_t i = 0; i < names.size(); i++)
+		log("  %-5d %-8s %s\n", int(i+1), results[i].c_str(), names[i].c_str());
+
+	if (count_failed == 0 && count_timeout == 0)
+		print_qed();
+	else if (count_failed != 0)
+		print_proof_failed();
+	else
+		print_timeout();
+
+	if (verify && count_failed != 0) {
+		log("\n");
+		log_error("Called with -verify and %d proofs did fail!\n", count_failed);
+	}
+	if (fail_on_timeout && count_timeout != 0) {
+		log("\n");
+		log_error("Called with -verify and %d proofs did time out!\n", count_timeout);
+	}
+	if (falsify && count_proven != 0) {
+		log("\n");
+		log_error("Called with -falsify and %d proofs did succeed!\n", count_proven);
+	}
+}
+
 struct SatPass : public Pass {
 	SatPass() : Pass("sat", "solve a SAT problem in the circuit") { }
 	virtual void help()
@@ -847,6 +1235,11 @@ struct SatPass : public Pass {
 		log("    -ignore_unknown_cells\n");
 		log("        ignore all cells that can not be matched to a SAT model\n");
 		log("\n");
+		log("    -coi\n");
+		log("        only import the cells in the cone of influence of the set, proof and\n");
+		log("        show signals and merge structurally identical cells before the SAT\n");
+		log("        problem is generated.\n");
+		log("\n");
 		log("The following options can be used to set up a sequential problem:\n");
 		log("\n");
 		log("    -seq <N>\n");
@@ -904,6 +1297,15 @@ struct SatPass : public Pass {
 		log("    -prove-asserts\n");
 		log("        Prove that all asserts in the design hold.\n");
 		log("\n");
+		log("    -prove-batch\n");
+		log("        Prove each -prove and -prove-x constraint and each assert separately.\n");
+		log("        The design is only encoded once, each property is checked using an\n");
+		log("        activation literal in the same incremental solver. A table with a\n");
+		log("        PROVEN, FAILED or TIMEOUT result for each property is printed at the\n");
+		log("        end. With -dump_vcd a file is written for each failed property, the\n");
+		log("        number of the property is added to the file name (e.g. trace_2.vcd).\n");
+		log("        (Not supported for temporal induction proofs and -dump_cnf.)\n");
+		log("\n");
 		log("    -maxsteps <N>\n");
 		log("        Set a maximum length for the induction.\n");
 		log("\n");
@@ -913,6 +1315,12 @@ struct SatPass : public Pass {
 		log("    -timeout <N>\n");
 		log("        Maximum number of seconds a single SAT instance may take.\n");
 		log("\n");
+		log("    -portfolio <N>\n");
+		log("        Run <N> differently configured instances of the SAT solver in\n");
+		log("        parallel threads on the same problem and use the result of the\n");
+		log("        instance that finishes first. The -timeout of a portfolio run is\n");
+		log("        measured in wall clock time.\n");
+		log("\n");
 		log("    -verify\n");
 		log("        Return an error and stop the synthesis script if the proof fails.\n");
 		log("\n");
@@ -932,11 +1340,12 @@ struct SatPass : public Pass {
 		std::map<int, std::vector<std::pair<std::string, std::string>>> sets_at;
 		std::map<int, std::vector<std::string>> unsets_at, sets_def_at, sets_any_undef_at, sets_all_undef_at;
 		std::vector<std::string> shows, sets_def, sets_any_undef, sets_all_undef;
-		int loopcount = 0, seq_len = 0, maxsteps = 0, initsteps = 0, timeout = 0;
+		int loopcount = 0, seq_len = 0, maxsteps = 0, initsteps = 0, timeout = 0, portfolio = 1;
 		bool verify = false, fail_on_timeout = false, enable_undef = false, set_def_inputs = false;
 		bool ignore_div_by_zero = false, set_init_undef = false, set_init_zero = false, max_undef = false;
 		bool tempinduct = false, prove_asserts = false, show_inputs = false, show_outputs = false;
 		bool ignore_unknown_cells = false, falsify = false, tempinduct_def = false, set_init_def = false;
+		bool enable_coi = false, prove_batch = false;
 		std::string vcd_file_name, cnf_file_name;
 
 		log_header("Executing SAT pass (solving SAT problems in the circuit).\n");
@@ -969,6 +1378,10 @@ struct SatPass : public Pass {
 				timeout = atoi(args[++argidx].c_str());
 				continue;
 			}
+			if (args[argidx] == "-portfolio" && argidx+1 < args.size()) {
+				portfolio = std::max(1, atoi(args[++argidx].c_str()));
+				continue;
+			}
 			if (args[argidx] == "-max" && argidx+1 < args.size()) {
 				loopcount = atoi(args[++argidx].c_str());
 				continue;
@@ -1046,6 +1459,10 @@ struct SatPass : public Pass {
 				prove_asserts = true;
 				continue;
 			}
+			if (args[argidx] == "-prove-batch") {
+				prove_batch = true;
+				continue;
+			}
 			if (args[argidx] == "-seq" && argidx+1 < args.size()) {
 				seq_len = atoi(args[++argidx].c_str());
 				continue;
@@ -1115,6 +1532,10 @@ struct SatPass : public Pass {
 				ignore_unknown_cells = true;
 				continue;
 			}
+			if (args[argidx] == "-coi") {
+				enable_coi = true;
+				continue;
+			}
 			if (args[argidx] == "-dump_vcd" && argidx+1 < args.size()) {
 				vcd_file_name = args[++argidx];
 				continue;
@@ -1141,6 +1562,15 @@ struct SatPass : public Pass {
 		if (!prove.size() && !prove_x.size() && !prove_asserts && tempinduct)
 			log_cmd_error("Got -tempinduct but nothing to prove!\n");
 
+		if (prove_batch && !prove.size() && !prove_x.size() && !prove_asserts)
+			log_cmd_error("Got -prove-batch but nothing to prove!\n");
+
+		if (prove_batch && (tempinduct || loopcount != 0))
+			log_cmd_error("The option -prove-batch can't be combined with -tempinduct or -loop!\n");
+
+		if (prove_batch && !cnf_file_name.empty())
+			log_cmd_error("The option -prove-batch can't be combined with -dump_cnf!\n");
+
 		if (set_init_undef + set_init_zero + set_init_def > 1)
 			log_cmd_error("The options -set-init-undef, -set-init-def, and -set-init-zero are exclusive!\n");
 
@@ -1178,6 +1608,7 @@ struct SatPass : public Pass {
 			basecase.unsets_at = unsets_at;
 			basecase.shows = shows;
 			basecase.timeout = timeout;
+			basecase.portfolio = portfolio;
 			basecase.sets_def = sets_def;
 			basecase.sets_any_undef = sets_any_undef;
 			basecase.sets_all_undef = sets_all_undef;
@@ -1190,6 +1621,7 @@ struct SatPass : public Pass {
 			basecase.set_init_zero = set_init_zero;
 			basecase.satgen.ignore_div_by_zero = ignore_div_by_zero;
 			basecase.ignore_unknown_cells = ignore_unknown_cells;
+			basecase.enable_coi = enable_coi;
 
 			for (int timestep = 1; timestep <= seq_len; timestep++)
 				basecase.setup(timestep);
@@ -1201,11 +1633,13 @@ struct SatPass : public Pass {
 			inductstep.prove_asserts = prove_asserts;
 			inductstep.shows = shows;
 			inductstep.timeout = timeout;
+			inductstep.portfolio = portfolio;
 			inductstep.sets_def = sets_def;
 			inductstep.sets_any_undef = sets_any_undef;
 			inductstep.sets_all_undef = sets_all_undef;
 			inductstep.satgen.ignore_div_by_zero = ignore_div_by_zero;
 			inductstep.ignore_unknown_cells = ignore_unknown_cells;
+			inductstep.enable_coi = enable_coi;
 
 			inductstep.setup(1);
 			inductstep.ez.assume(inductstep.setup_proof(1));
@@ -1324,6 +1758,7 @@ struct SatPass : public Pass {
 			sathelper.unsets_at = unsets_at;
 			sathelper.shows = shows;
 			sathelper.timeout = timeout;
+			sathelper.portfolio = portfolio;
 			sathelper.sets_def = sets_def;
 			sathelper.sets_any_undef = sets_any_undef;
 			sathelper.sets_all_undef = sets_all_undef;
@@ -1336,6 +1771,33 @@ struct SatPass : public Pass {
 			sathelper.set_init_zero = set_init_zero;
 			sathelper.satgen.ignore_div_by_zero = ignore_div_by_zero;
 			sathelper.ignore_unknown_cells = ignore_unknown_cells;
+			sathelper.enable_coi = enable_coi;
+
+			if (prove_batch) {
+				std::vector<std::string> batch_names;
+				std::vector<int> batch_exprs;
+				if (seq_len == 0) {
+					sathelper.setup();
+					sathelper.setup_proof_batch(batch_names, batch_exprs);
+				} else {
+					std::vector<std::vector<int>> batch_exprs_per_step;
+					for (int timestep = 1; timestep <= seq_len; timestep++) {
+						sathelper.setup(timestep);
+						batch_exprs_per_step.push_back(std::vector<int>());
+						sathelper.setup_proof_batch(batch_names, batch_exprs_per_step.back(), timestep);
+					}
+					for (size_t i = 0; i < batch_names.size(); i++) {
+						std::vector<int> prove_bits;
+						for (auto &step_exprs : batch_exprs_per_step)
+							prove_bits.push_back(step_exprs.at(i));
+						batch_exprs.push_back(sathelper.ez.expression(ezSAT::OpAnd, prove_bits));
+					}
+					sathelper.setup_init();
+				}
+				sathelper.generate_model();
+				run_batch_proof(sathelper, batch_names, batch_exprs, verify, falsify, fail_on_timeout, max_undef, vcd_file_name);
+				return;
+			}
 
 			if (seq_len == 0) {
 				sathelper.setup();
@@ -1372,6 +1834,8 @@ struct SatPass : public Pass {
 		rerun_solver:
 			log("\nSolving problem with %d variables and %d clauses..\n",
 					sathelper.ez.numCnfVariables(), sathelper.ez.numCnfClauses());
+			if (sathelper.ez.numCnfClausesSaved() > 0)
+				log("Polarity-aware encoding omitted %d clauses.\n", sathelper.ez.numCnfClausesSaved());
 
 			if (sathelper.solve())
 			{
@@ -22,6 +22,8 @@
 #include "kernel/log.h"
 #include "libs/subcircuit/subcircuit.h"
 #include <algorithm>
+#include <thread>
+#include <atomic>
 #include <stdlib.h>
 #include <assert.h>
 #include <stdio.h>
@@ -421,6 +423,15 @@ struct ExtractPass : public Pass {
 		log("    -ignore_param <cell_type> <parameter_name>\n");
 		log("        Do not use this parameter when matching cells.\n");
 		log("\n");
+		log("    -max_matches <num>\n");
+		log("        find at most the specified number of matches for each pair of needle\n");
+		log("        and haystack module\n");
+		log("\n");
+		log("    -j <num>\n");
+		log("        search up to the specified number of haystack modules (or mining\n");
+		log("        candidates) in parallel (default: 1). The results do not depend on\n");
+		log("        the number of threads.\n");
+		log("\n");
 		log("This pass does not operate on modules with uprocessed processes in it.\n");
 		log("(I.e. the 'proc' pass should be used first to convert processes to netlists.)\n");
 		log("\n");
@@ -445,6 +456,10 @@ struct ExtractPass : public Pass {
 		log("    -mine_max_fanout <num>\n");
 		log("        don't consider internal signals with more than <num> connections\n");
 		log("\n");
+		log("    -mine_max_pool <num>\n");
+		log("        only keep <num> matches of the frequent subcircuits of each size as\n");
+		log("        seeds for growing the next larger subcircuits (default: unlimited)\n");
+		log("\n");
 		log("The modules in the map file may have the attribute 'extract_order' set to an\n");
 		log("integer value. Then this value is used to determine the order in which the pass\n");
 		log("tries to map the modules to the design (ascending, default value is 0).\n");
@@ -463,6 +478,13 @@ struct ExtractPass : public Pass {
 		std::string mine_outfile;
 		bool constports = false;
 		bool nodefaultswaps = false;
+		bool verbose = false;
+		int max_matches = -1;
+		int num_threads = 1;
+
+		std::vector<std::pair<std::string, std::string>> compat_types;
+		std::vector<std::pair<std::string, std::set<std::string>>> swap_ports;
+		std::vector<std::pair<std::string, std::map<std::string, std::string>>> swap_perms;
 
 		bool mine_mode = false;
 		int mine_cells_min = 3;
@@ -470,6 +492,7 @@ struct ExtractPass : public Pass {
 		int mine_min_freq = 10;
 		int mine_limit_mod = -1;
 		int mine_max_fanout = -1;
+		int mine_max_pool = -1;
 		std::set<std::pair<RTLIL::IdString, RTLIL::IdString>> mine_split;
 
 		size_t argidx;
@@ -509,8 +532,12 @@ struct ExtractPass : public Pass {
 				mine_max_fanout = atoi(args[++argidx].c_str());
 				continue;
 			}
+			if (args[argidx] == "-mine_max_pool" && argidx+1 < args.size()) {
+				mine_max_pool = atoi(args[++argidx].c_str());
+				continue;
+			}
 			if (args[argidx] == "-verbose") {
-				solver.setVerbose();
+				verbose = true;
 				continue;
 			}
 			if (args[argidx] == "-constports") {
@@ -524,7 +551,7 @@ struct ExtractPass : public Pass {
 			if (args[argidx] == "-compat" && argidx+2 < args.size()) {
 				std::string needle_type = RTLIL::escape_id(args[++argidx]);
 				std::string haystack_type = RTLIL::escape_id(args[++argidx]);
-				solver.addCompatibleTypes(needle_type, haystack_type);
+				compat_types.push_back(std::pair<std::string, std::string>(needle_type, haystack_type));
 				continue;
 			}
 			if (args[argidx] == "-swap" && argidx+2 < args.size()) {
@@ -534,7 +561,7 @@ struct ExtractPass : public Pass {
 				for (char *sptr, *p = strtok_r(ports_str, ",\t\r\n ", &sptr); p != NULL; p = strtok_r(NULL, ",\t\r\n ", &sptr))
 					ports.insert(RTLIL::escape_id(p));
 				free(ports_str);
-				solver.addSwappablePorts(type, ports);
+				swap_ports.push_back(std::pair<std::string, std::set<std::string>>(type, ports));
 				continue;
 			}
 			if (args[argidx] == "-perm" && argidx+3 < args.size()) {
@@ -557,7 +584,7 @@ struct ExtractPass : public Pass {
 				std::sort(map_right.begin(), map_right.end());
 				if (map_left != map_right)
 					log_cmd_error("Arguments to -perm are not a valid permutation!\n");
-				solver.addSwappablePortsPermutation(type, map);
+				swap_perms.push_back(std::pair<std::string, std::map<std::string, std::string>>(type, map));
 				continue;
 			}
 			if (args[argidx] == "-cell_attr" && argidx+1 < args.size()) {
@@ -577,27 +604,53 @@ struct ExtractPass : public Pass {
 				argidx += 2;
 				continue;
 			}
+			if (args[argidx] == "-max_matches" && argidx+1 < args.size()) {
+				max_matches = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (args[argidx] == "-j" && argidx+1 < args.size()) {
+				num_threads = std::max(1, atoi(args[++argidx].c_str()));
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
 
-		if (!nodefaultswaps) {
-			solver.addSwappablePorts("$and",       "\\A", "\\B");
-			solver.addSwappablePorts("$or",        "\\A", "\\B");
-			solver.addSwappablePorts("$xor",       "\\A", "\\B");
-			solver.addSwappablePorts("$xnor",      "\\A", "\\B");
-			solver.addSwappablePorts("$eq",        "\\A", "\\B");
-			solver.addSwappablePorts("$ne",        "\\A", "\\B");
-			solver.addSwappablePorts("$eqx",       "\\A", "\\B");
-			solver.addSwappablePorts("$nex",       "\\A", "\\B");
-			solver.addSwappablePorts("$add",       "\\A", "\\B");
-			solver.addSwappablePorts("$mul",       "\\A", "\\B");
-			solver.addSwappablePorts("$logic_and", "\\A", "\\B");
-			solver.addSwappablePorts("$logic_or",  "\\A", "\\B");
-			solver.addSwappablePorts("$_AND_",     "\\A", "\\B");
-			solver.addSwappablePorts("$_OR_",      "\\A", "\\B");
-			solver.addSwappablePorts("$_XOR_",     "\\A", "\\B");
-		}
+		// the solver keeps state between calls to solve() and can't be shared
+		// between threads. so each parallel job gets its own, identically
+		// configured solver.
+		auto setup_solver = [&](SubCircuitSolver &s)
+		{
+			if (verbose)
+				s.setVerbose();
+			s.ignore_parameters = solver.ignore_parameters;
+			s.ignored_parameters = solver.ignored_parameters;
+			s.cell_attr = solver.cell_attr;
+			s.wire_attr = solver.wire_attr;
+			for (auto &it : compat_types)
+				s.addCompatibleTypes(it.first, it.second);
+			for (auto &it : swap_ports)
+				s.addSwappablePorts(it.first, it.second);
+			for (auto &it : swap_perms)
+				s.addSwappablePortsPermutation(it.first, it.second);
+			if (!nodefaultswaps) {
+				s.addSwappablePorts("$and",       "\\A", "\\B");
+				s.addSwappablePorts("$or",        "\\A", "\\B");
+				s.addSwappablePorts("$xor",       "\\A", "\\B");
+				s.addSwappablePorts("$xnor",      "\\A", "\\B");
+				s.addSwappablePorts("$eq",        "\\A", "\\B");
+				s.addSwappablePorts("$ne",        "\\A", "\\B");
+				s.addSwappablePorts("$eqx",       "\\A", "\\B");
+				s.addSwappablePorts("$nex",       "\\A", "\\B");
+				s.addSwappablePorts("$add",       "\\A", "\\B");
+				s.addSwappablePorts("$mul",       "\\A", "\\B");
+				s.addSwappablePorts("$logic_and", "\\A", "\\B");
+				s.addSwappablePorts("$logic_or",  "\\A", "\\B");
+				s.addSwappablePorts("$_AND_",     "\\A", "\\B");
+				s.addSwappablePorts("$_OR_",      "\\A", "\\B");
+				s.addSwappablePorts("$_XOR_",     "\\A", "\\B");
+			}
+		};
 
 		if (map_filenames.empty() && mine_outfile.empty())
 			log_cmd_error("Missing option -map <verilog_or_ilang_file> or -mine <output_ilang_file>.\n");
@@ -638,6 +691,7 @@ struct ExtractPass : public Pass {
 		}
 
 		std::map<std::string, RTLIL::Module*> needle_map, haystack_map;
+		std::map<std::string, SubCircuit::Graph> graphs;
 		std::vector<RTLIL::Module*> needle_list;
 
 		log_header("Creating graphs for SubCircuit library.\n");
@@ -648,7 +702,7 @@ struct ExtractPass : public Pass {
 				std::string graph_name = "needle_" + RTLIL::unescape_id(mod_it.first);
 				log("Creating needle graph %s.\n", graph_name.c_str());
 				if (module2graph(mod_graph, mod_it.second, constports)) {
-					solver.addGraph(graph_name, mod_graph);
+					graphs[graph_name] = mod_graph;
 					needle_map[graph_name] = mod_it.second;
 					needle_list.push_back(mod_it.second);
 				}
@@ -659,7 +713,7 @@ struct ExtractPass : public Pass {
 			std::string graph_name = "haystack_" + RTLIL::unescape_id(mod_it.first);
 			log("Creating haystack graph %s.\n", graph_name.c_str());
 			if (module2graph(mod_graph, mod_it.second, constports, design, mine_mode ? mine_max_fanout : -1, mine_mode ? &mine_split : NULL)) {
-				solver.addGraph(graph_name, mod_graph);
+				graphs[graph_name] = mod_graph;
 				haystack_map[graph_name] = mod_it.second;
 			}
 		}
@@ -671,10 +725,52 @@ struct ExtractPass : public Pass {
 
 			std::sort(needle_list.begin(), needle_list.end(), compareSortNeedleList);
 
+			std::vector<std::string> needle_names, haystack_names;
 			for (auto needle : needle_list)
-			for (auto &haystack_it : haystack_map) {
-				log("Solving for %s in %s.\n", ("needle_" + RTLIL::unescape_id(needle->name)).c_str(), haystack_it.first.c_str());
-				solver.solve(results, "needle_" + RTLIL::unescape_id(needle->name), haystack_it.first, false);
+				needle_names.push_back("needle_" + RTLIL::unescape_id(needle->name));
+			for (auto &it : haystack_map)
+				haystack_names.push_back(it.first);
+
+			// matches in different haystack modules are independent, so there is one
+			// job per haystack module. a job searches the needles in order, so matches
+			// never overlap with the matches of needles searched earlier.
+			std::vector<std::vector<std::vector<SubCircuit::Solver::Result>>> job_results(haystack_names.size());
+
+			auto run_job = [&](int idx)
+			{
+				SubCircuitSolver job_solver;
+				setup_solver(job_solver);
+				for (auto &name : needle_names)
+					job_solver.addGraph(name, graphs.at(name));
+				job_solver.addGraph(haystack_names[idx], graphs.at(haystack_names[idx]));
+
+				job_results[idx].resize(needle_names.size());
+				for (size_t i = 0; i < needle_names.size(); i++) {
+					if (verbose)
+						log("Solving for %s in %s.\n", needle_names[i].c_str(), haystack_names[idx].c_str());
+					job_solver.solve(job_results[idx][i], needle_names[i], haystack_names[idx], false, max_matches);
+				}
+			};
+
+			// the debug output of the solver would be interleaved
+			if (verbose)
+				num_threads = 1;
+
+			std::atomic<int> next_index(0);
+			std::vector<std::thread> threads;
+			for (int i = 0; i < std::min(num_threads, int(haystack_names.size())); i++)
+				threads.push_back(std::thread([&]() {
+					for (int idx = next_index++; idx < int(haystack_names.size()); idx = next_index++)
+						run_job(idx);
+				}));
+			for (auto &thread : threads)
+				thread.join();
+
+			for (size_t i = 0; i < needle_names.size(); i++)
+			for (size_t j = 0; j < haystack_names.size(); j++) {
+				std::vector<SubCircuit::Solver::Result> &pair_results = job_results[j][i];
+				log("Found %d matches for %s in %s.\n", int(pair_results.size()), needle_names[i].c_str(), haystack_names[j].c_str());
+				results.insert(results.end(), pair_results.begin(), pair_results.end());
 			}
 			log("Found %zd matches.\n", results.size());
 
@@ -702,7 +798,10 @@ struct ExtractPass : public Pass {
 			std::vector<SubCircuit::Solver::MineResult> results;
 
 			log_header("Running miner from SubCircuit library.\n");
-			solver.mine(results, mine_cells_min, mine_cells_max, mine_min_freq, mine_limit_mod);
+			setup_solver(solver);
+			for (auto &it : haystack_map)
+				solver.addGraph(it.first, graphs.at(it.first));
+			solver.mine(results, mine_cells_min, mine_cells_max, mine_min_freq, mine_limit_mod, mine_max_pool, num_threads);
 
 			map = new RTLIL::Design;
 
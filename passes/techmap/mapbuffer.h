@@ -0,0 +1,138 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef MAPBUFFER_H
+#define MAPBUFFER_H
+
+#include "kernel/rtlil.h"
+#include <stdlib.h>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+// A MapBuffer collects the wires, cells and connections created by mapping
+// a batch of cells in a worker thread. The mappers add their objects to the
+// (otherwise empty) buffer module instead of the real module. Objects named
+// using NEW_ID are numbered with a thread local counter while the batch is
+// mapped and get their final names when the buffer is committed to the real
+// module. Committing the buffers of all batches in a fixed order therefore
+// creates the same names no matter how many threads are used.
+
+struct MapBuffer
+{
+	RTLIL::Module *buffer;
+
+	MapBuffer() : buffer(new RTLIL::Module) { }
+	~MapBuffer() { delete buffer; }
+
+	MapBuffer(const MapBuffer&) = delete;
+	MapBuffer &operator=(const MapBuffer&) = delete;
+
+	// names of the form $auto$<file>:<line>:<func>$<idx>. the names created by
+	// expanding a template have a '.' after the cell name they are prefixed with.
+	static bool is_auto_name(const RTLIL::IdString &name)
+	{
+		if (name.compare(0, 6, "$auto$") != 0)
+			return false;
+		size_t pos = name.find('$', 6);
+		if (pos == std::string::npos || pos+1 == name.size() || name.rfind('$') != pos)
+			return false;
+		for (size_t i = pos+1; i < name.size(); i++)
+			if (name[i] < '0' || name[i] > '9')
+				return false;
+		return true;
+	}
+
+	static int auto_name_idx(const RTLIL::IdString &name)
+	{
+		return atoi(name.c_str() + name.rfind('$') + 1);
+	}
+
+	// move all objects to the module. the committed cells are appended to
+	// new_cells and selected in the design (if not NULL)
+	void commit(RTLIL::Module *module, RTLIL::Design *design, std::vector<RTLIL::Cell*> &new_cells)
+	{
+		// assign the final ids in the order the objects were created
+		std::vector<std::pair<int, RTLIL::IdString*>> auto_names;
+		for (auto &it : buffer->wires)
+			if (is_auto_name(it.first))
+				auto_names.push_back(std::pair<int, RTLIL::IdString*>(auto_name_idx(it.first), &it.second->name));
+		for (auto &it : buffer->cells)
+			if (is_auto_name(it.first))
+				auto_names.push_back(std::pair<int, RTLIL::IdString*>(auto_name_idx(it.first), &it.second->name));
+		std::sort(auto_names.begin(), auto_names.end());
+		for (auto &it : auto_names)
+			*it.second = it.second->substr(0, it.second->rfind('$') + 1) + stringf("%d", RTLIL::autoidx++);
+
+		for (auto &it : buffer->wires) {
+			module->add(it.second);
+			if (design)
+				design->select(module, it.second);
+		}
+		for (auto &it : buffer->cells) {
+			module->add(it.second);
+			if (design)
+				design->select(module, it.second);
+			new_cells.push_back(it.second);
+		}
+		module->connections.insert(module->connections.end(), buffer->connections.begin(), buffer->connections.end());
+
+		buffer->wires.clear();
+		buffer->cells.clear();
+		buffer->connections.clear();
+	}
+
+	// call worker(i, buffer) for all i in [0, num_items) on num_threads threads.
+	// the items are split into batches of consecutive items, each batch is
+	// mapped into its own buffer and the buffers are committed in batch order
+	// by calling commit(batch_begin, batch_end, buffer).
+	template<typename W, typename C>
+	static void run(int num_items, int num_threads, W worker, C commit)
+	{
+		int batch_size = std::max(1, std::min(256, num_items / (4 * std::max(1, num_threads))));
+		int num_batches = (num_items + batch_size - 1) / batch_size;
+
+		std::vector<MapBuffer> buffers(num_batches);
+		std::atomic<int> next_batch(0);
+
+		auto thread_main = [&]() {
+			int counter = 0;
+			RTLIL::local_autoidx = &counter;
+			for (int b = next_batch++; b < num_batches; b = next_batch++) {
+				counter = 0;
+				for (int i = b * batch_size; i < std::min(num_items, (b+1) * batch_size); i++)
+					worker(i, buffers[b].buffer);
+			}
+			RTLIL::local_autoidx = NULL;
+		};
+
+		std::vector<std::thread> threads;
+		for (int i = 1; i < std::min(num_threads, num_batches); i++)
+			threads.push_back(std::thread(thread_main));
+		thread_main();
+		for (auto &t : threads)
+			t.join();
+
+		for (int b = 0; b < num_batches; b++)
+			commit(b * batch_size, std::min(num_items, (b+1) * batch_size), buffers[b]);
+	}
+};
+
+#endif
+
@@ -20,6 +20,7 @@
 #include "kernel/register.h"
 #include "kernel/sigtools.h"
 #include "kernel/log.h"
+#include "passes/techmap/mapbuffer.h"
 #include <stdlib.h>
 #include <assert.h>
 #include <stdio.h>
@@ -511,7 +512,7 @@ struct SimplemapPass : public Pass {
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
 		log("\n");
-		log("    simplemap [selection]\n");
+		log("    simplemap [options] [selection]\n");
 		log("\n");
 		log("This pass maps a small selection of simple coarse-grain cells to yosys gate\n");
 		log("primitives. The following internal cell types are mapped by this pass:\n");
@@ -521,11 +522,28 @@ struct SimplemapPass : public Pass {
 		log("  $logic_not, $logic_and, $logic_or, $mux\n");
 		log("  $sr, $dff, $dffsr, $adff, $dlatch\n");
 		log("\n");
+		log("    -j <num>\n");
+		log("        map the cells of each module on up to <num> threads. the result does\n");
+		log("        not depend on the number of threads.\n");
+		log("\n");
 	}
 	virtual void execute(std::vector<std::string> args, RTLIL::Design *design)
 	{
 		log_header("Executing SIMPLEMAP pass (map simple cells to gate primitives).\n");
-		extra_args(args, 1, design);
+
+		int num_threads = 0;
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++) {
+			if (args[argidx] == "-j" && argidx+1 < args.size()) {
+				num_threads = atoi(args[++argidx].c_str());
+				if (num_threads < 1)
+					log_cmd_error("Invalid number of threads %d.\n", num_threads);
+				continue;
+			}
+			break;
+		}
+		extra_args(args, argidx, design);
 
 		std::map<std::string, void(*)(RTLIL::Module*, RTLIL::Cell*)> mappers;
 		simplemap_get_mappers(mappers);
@@ -540,13 +558,24 @@ struct SimplemapPass : public Pass {
 				if (!design->selected(mod_it.second, cell_it.second))
 					continue;
 				log("Mapping %s.%s (%s).\n", RTLIL::id2cstr(mod_it.first), RTLIL::id2cstr(cell_it.first), RTLIL::id2cstr(cell_it.second->type));
-				mappers.at(cell_it.second->type)(mod_it.second, cell_it.second);
+				if (num_threads == 0)
+					mappers.at(cell_it.second->type)(mod_it.second, cell_it.second);
 				delete_cells.push_back(cell_it.second);
 			}
-			for (auto &it : delete_cells) {
+			for (auto &it : delete_cells)
 				mod_it.second->cells.erase(it->name);
-				delete it;
+			if (num_threads > 0) {
+				std::vector<RTLIL::Cell*> new_cells;
+				MapBuffer::run(delete_cells.size(), num_threads,
+					[&](int i, RTLIL::Module *buffer) {
+						mappers.at(delete_cells[i]->type)(buffer, delete_cells[i]);
+					},
+					[&](int, int, MapBuffer &buf) {
+						buf.commit(mod_it.second, NULL, new_cells);
+					});
 			}
+			for (auto &it : delete_cells)
+				delete it;
 		}
 	}
 } SimplemapPass;
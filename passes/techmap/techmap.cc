@@ -21,10 +21,13 @@
 #include "kernel/register.h"
 #include "kernel/sigtools.h"
 #include "kernel/log.h"
+#include "libs/sha1/sha1.h"
+#include "passes/techmap/mapbuffer.h"
 #include <stdlib.h>
 #include <assert.h>
 #include <stdio.h>
 #include <string.h>
+#include <errno.h>
 
 #include "passes/techmap/stdcells.inc"
 
@@ -99,7 +102,9 @@ struct TechmapWorker
 		return result;
 	}
 
-	void techmap_module_worker(RTLIL::Design *design, RTLIL::Module *module, RTLIL::Cell *cell, RTLIL::Module *tpl, bool flatten_mode)
+	// check the template, remove the cell from the module and return the name for the
+	// _TECHMAP_REPLACE_ cell (or an empty string)
+	std::string techmap_prepare_cell(RTLIL::Module *module, RTLIL::Cell *cell, RTLIL::Module *tpl, bool flatten_mode)
 	{
 		log("Mapping `%s.%s' using `%s'.\n", RTLIL::id2cstr(module->name), RTLIL::id2cstr(cell->name), RTLIL::id2cstr(tpl->name));
 
@@ -109,6 +114,16 @@ struct TechmapWorker
 		if (tpl->processes.size() != 0)
 			log_error("Technology map yielded processes -> this is not supported.\n");
 
+		std::set<RTLIL::IdString> port_names;
+		for (auto &it : tpl->wires)
+			if (it.second->port_id > 0) {
+				port_names.insert(it.first);
+				port_names.insert(stringf("$%d", it.second->port_id));
+			}
+		for (auto &it : cell->connections)
+			if (it.first.substr(0, 1) == "$" && port_names.count(it.first) == 0)
+				log_error("Can't map port `%s' of cell `%s' to template `%s'!\n", it.first.c_str(), cell->name.c_str(), tpl->name.c_str());
+
 		// erase from namespace first for _TECHMAP_REPLACE_ to work
 		module->cells.erase(cell->name);
 		std::string orig_cell_name;
@@ -121,6 +136,15 @@ struct TechmapWorker
 					break;
 				}
 
+		return orig_cell_name;
+	}
+
+	// add the wires, cells and connections of the template to the module. this
+	// only reads the design, so it can run in a worker thread if module is a
+	// MapBuffer and design is NULL (the new objects are not selected then).
+	void techmap_expand_cell(RTLIL::Design *design, RTLIL::Module *module, RTLIL::Cell *cell, RTLIL::Module *tpl, bool flatten_mode,
+			std::string orig_cell_name, std::vector<RTLIL::Cell*> &new_cells)
+	{
 		std::map<RTLIL::IdString, RTLIL::IdString> positional_ports;
 
 		for (auto &it : tpl->wires) {
@@ -134,7 +158,8 @@ struct TechmapWorker
 			if (it.second->get_bool_attribute("\\_techmap_special_"))
 				w->attributes.clear();
 			module->add(w);
-			design->select(module, w);
+			if (design)
+				design->select(module, w);
 		}
 
 		SigMap port_signal_map;
@@ -143,11 +168,8 @@ struct TechmapWorker
 			RTLIL::IdString portname = it.first;
 			if (positional_ports.count(portname) > 0)
 				portname = positional_ports.at(portname);
-			if (tpl->wires.count(portname) == 0 || tpl->wires.at(portname)->port_id == 0) {
-				if (portname.substr(0, 1) == "$")
-					log_error("Can't map port `%s' of cell `%s' to template `%s'!\n", portname.c_str(), cell->name.c_str(), tpl->name.c_str());
+			if (tpl->wires.count(portname) == 0 || tpl->wires.at(portname)->port_id == 0)
 				continue;
-			}
 			RTLIL::Wire *w = tpl->wires.at(portname);
 			RTLIL::SigSig c;
 			if (w->port_output) {
@@ -191,7 +213,9 @@ struct TechmapWorker
 				port_signal_map.apply(it2.second);
 			}
 			module->add(c);
-			design->select(module, c);
+			if (design)
+				design->select(module, c);
+			new_cells.push_back(c);
 		}
 
 		for (auto &it : tpl->connections) {
@@ -202,235 +226,329 @@ struct TechmapWorker
 			port_signal_map.apply(c.second);
 			module->connections.push_back(c);
 		}
+	}
 
+	void techmap_module_worker(RTLIL::Design *design, RTLIL::Module *module, RTLIL::Cell *cell, RTLIL::Module *tpl, bool flatten_mode,
+			std::vector<RTLIL::Cell*> &new_cells)
+	{
+		std::string orig_cell_name = techmap_prepare_cell(module, cell, tpl, flatten_mode);
+		techmap_expand_cell(design, module, cell, tpl, flatten_mode, orig_cell_name, new_cells);
 		delete cell;
 	}
 
+	struct TechmapJob {
+		RTLIL::Cell *cell;
+		RTLIL::Module *tpl;
+		std::string orig_cell_name;
+	};
+
+	// expand the (already prepared) cells of one generation on num_threads threads. the
+	// results are committed to the module in the order of the jobs.
+	void techmap_run_parallel(RTLIL::Design *design, RTLIL::Module *module, const std::vector<TechmapJob> &tpl_jobs,
+			const std::vector<RTLIL::Cell*> &simplemap_jobs, bool flatten_mode, int num_threads, std::vector<RTLIL::Cell*> &new_cells)
+	{
+		MapBuffer::run(tpl_jobs.size(), num_threads,
+			[&](int i, RTLIL::Module *buffer) {
+				std::vector<RTLIL::Cell*> buffer_cells;
+				techmap_expand_cell(NULL, buffer, tpl_jobs[i].cell, tpl_jobs[i].tpl, flatten_mode, tpl_jobs[i].orig_cell_name, buffer_cells);
+			},
+			[&](int begin, int end, MapBuffer &buf) {
+				buf.commit(module, design, new_cells);
+				for (int i = begin; i < end; i++)
+					delete tpl_jobs[i].cell;
+			});
+
+		MapBuffer::run(simplemap_jobs.size(), num_threads,
+			[&](int i, RTLIL::Module *buffer) {
+				simplemap_mappers.at(simplemap_jobs[i]->type)(buffer, simplemap_jobs[i]);
+			},
+			[&](int begin, int end, MapBuffer &buf) {
+				buf.commit(module, NULL, new_cells);
+				for (int i = begin; i < end; i++)
+					delete simplemap_jobs[i];
+			});
+	}
+
+	// map the cells of the module until no more expansions are possible (or for
+	// max_iter generations of cells). the cells that match a template are kept in
+	// a worklist indexed by cell type: the module is only scanned once, and the
+	// cells created by an expansion are added to the worklist of the next
+	// generation. with num_threads > 0 the templates for all cells of a generation
+	// are selected first and the cells are then expanded in parallel.
 	bool techmap_module(RTLIL::Design *design, RTLIL::Module *module, RTLIL::Design *map, std::set<RTLIL::Cell*> &handled_cells,
-			const std::map<RTLIL::IdString, std::set<RTLIL::IdString>> &celltypeMap, bool flatten_mode)
+			const std::map<RTLIL::IdString, std::set<RTLIL::IdString>> &celltypeMap, bool flatten_mode, int max_iter = -1, int num_threads = 0)
 	{
 		if (!design->selected(module))
 			return false;
 
 		bool log_continue = false;
 		bool did_something = false;
-		std::vector<std::string> cell_names;
 
-		SigMap sigmap(module);
-		for (auto &cell_it : module->cells)
-			cell_names.push_back(cell_it.first);
+		// cells created by simplemap are not reported back, so the module must be
+		// rescanned after simplemap was used if templates match internal gate cells
+		bool rescan_after_simplemap = false;
+		for (auto &it : celltypeMap)
+			if (it.first.substr(0, 2) == "$_")
+				rescan_after_simplemap = true;
 
-		for (auto &cell_name : cell_names)
-		{
-			if (module->cells.count(cell_name) == 0)
-				continue;
-
-			RTLIL::Cell *cell = module->cells[cell_name];
+		std::map<RTLIL::IdString, std::vector<RTLIL::Cell*>> worklist, next_worklist;
+		std::vector<RTLIL::Cell*> new_cells;
 
-			if (!design->selected(module, cell) || handled_cells.count(cell) > 0)
-				continue;
+		for (auto &cell_it : module->cells)
+			if (celltypeMap.count(cell_it.second->type) > 0)
+				worklist[cell_it.second->type].push_back(cell_it.second);
 
-			if (celltypeMap.count(cell->type) == 0)
-				continue;
+		for (int iter = 1; !worklist.empty(); iter++)
+		{
+			SigMap sigmap(module);
+			bool did_simplemap = false;
+			std::vector<TechmapJob> tpl_jobs;
+			std::vector<RTLIL::Cell*> simplemap_jobs;
 
-			for (auto &tpl_name : celltypeMap.at(cell->type))
+			for (auto &wl_it : worklist)
+			for (auto cell : wl_it.second)
 			{
-				std::string derived_name = tpl_name;
-				RTLIL::Module *tpl = map->modules[tpl_name];
-				std::map<RTLIL::IdString, RTLIL::Const> parameters = cell->parameters;
+				if (!design->selected(module, cell) || handled_cells.count(cell) > 0)
+					continue;
 
-				if (!flatten_mode)
+				for (auto &tpl_name : celltypeMap.at(cell->type))
 				{
-					if (tpl->get_bool_attribute("\\techmap_simplemap")) {
-						log("Mapping %s.%s (%s) with simplemap.\n", RTLIL::id2cstr(module->name), RTLIL::id2cstr(cell->name), RTLIL::id2cstr(cell->type));
-						if (simplemap_mappers.count(cell->type) == 0)
-							log_error("No simplemap mapper for cell type %s found!\n", RTLIL::id2cstr(cell->type));
-						simplemap_mappers.at(cell->type)(module, cell);
-						module->cells.erase(cell->name);
-						delete cell;
-						cell = NULL;
-						did_something = true;
-						break;
-					}
+					std::string derived_name = tpl_name;
+					RTLIL::Module *tpl = map->modules[tpl_name];
+					std::map<RTLIL::IdString, RTLIL::Const> parameters = cell->parameters;
 
-					for (auto conn : cell->connections) {
-						if (conn.first.substr(0, 1) == "$")
-							continue;
-						if (tpl->wires.count(conn.first) > 0 && tpl->wires.at(conn.first)->port_id > 0)
-							continue;
-						if (!conn.second.is_fully_const() || parameters.count(conn.first) > 0 || tpl->avail_parameters.count(conn.first) == 0)
-							goto next_tpl;
-						parameters[conn.first] = conn.second.as_const();
-					}
-
-					if (0) {
-			next_tpl:
-						continue;
-					}
-
-					if (tpl->avail_parameters.count("\\_TECHMAP_CELLTYPE_") != 0)
-						parameters["\\_TECHMAP_CELLTYPE_"] = RTLIL::unescape_id(cell->type);
-
-					for (auto conn : cell->connections) {
-						if (tpl->avail_parameters.count(stringf("\\_TECHMAP_CONSTMSK_%s_", RTLIL::id2cstr(conn.first))) != 0) {
-							std::vector<RTLIL::SigBit> v = sigmap(conn.second).to_sigbit_vector();
-							for (auto &bit : v)
-								bit = RTLIL::SigBit(bit.wire == NULL ? RTLIL::State::S1 : RTLIL::State::S0);
-							parameters[stringf("\\_TECHMAP_CONSTMSK_%s_", RTLIL::id2cstr(conn.first))] = RTLIL::SigSpec(v).as_const();
+					if (!flatten_mode)
+					{
+						if (tpl->get_bool_attribute("\\techmap_simplemap")) {
+							log("Mapping %s.%s (%s) with simplemap.\n", RTLIL::id2cstr(module->name), RTLIL::id2cstr(cell->name), RTLIL::id2cstr(cell->type));
+							if (simplemap_mappers.count(cell->type) == 0)
+								log_error("No simplemap mapper for cell type %s found!\n", RTLIL::id2cstr(cell->type));
+							if (num_threads > 0) {
+								module->cells.erase(cell->name);
+								simplemap_jobs.push_back(cell);
+							} else {
+								simplemap_mappers.at(cell->type)(module, cell);
+								module->cells.erase(cell->name);
+								delete cell;
+								did_simplemap = true;
+							}
+							cell = NULL;
+							did_something = true;
+							break;
 						}
-						if (tpl->avail_parameters.count(stringf("\\_TECHMAP_CONSTVAL_%s_", RTLIL::id2cstr(conn.first))) != 0) {
-							std::vector<RTLIL::SigBit> v = sigmap(conn.second).to_sigbit_vector();
-							for (auto &bit : v)
-								if (bit.wire != NULL)
-									bit = RTLIL::SigBit(RTLIL::State::Sx);
-							parameters[stringf("\\_TECHMAP_CONSTVAL_%s_", RTLIL::id2cstr(conn.first))] = RTLIL::SigSpec(v).as_const();
+
+						for (auto conn : cell->connections) {
+							if (conn.first.substr(0, 1) == "$")
+								continue;
+							if (tpl->wires.count(conn.first) > 0 && tpl->wires.at(conn.first)->port_id > 0)
+								continue;
+							if (!conn.second.is_fully_const() || parameters.count(conn.first) > 0 || tpl->avail_parameters.count(conn.first) == 0)
+								goto next_tpl;
+							parameters[conn.first] = conn.second.as_const();
 						}
-					}
 
-					int unique_bit_id_counter = 0;
-					std::map<RTLIL::SigBit, int> unique_bit_id;
-					unique_bit_id[RTLIL::State::S0] = unique_bit_id_counter++;
-					unique_bit_id[RTLIL::State::S1] = unique_bit_id_counter++;
-					unique_bit_id[RTLIL::State::Sx] = unique_bit_id_counter++;
-					unique_bit_id[RTLIL::State::Sz] = unique_bit_id_counter++;
-
-					for (auto conn : cell->connections)
-						if (tpl->avail_parameters.count(stringf("\\_TECHMAP_CONNMAP_%s_", RTLIL::id2cstr(conn.first))) != 0) {
-							for (auto &bit : sigmap(conn.second).to_sigbit_vector())
-								if (unique_bit_id.count(bit) == 0)
-									unique_bit_id[bit] = unique_bit_id_counter++;
+						if (0) {
+				next_tpl:
+							continue;
 						}
 
-					int bits = 0;
-					for (int i = 0; i < 32; i++)
-						if (((unique_bit_id_counter-1) & (1 << i)) != 0)
-							bits = i;
-					if (tpl->avail_parameters.count("\\_TECHMAP_BITS_CONNMAP_"))
-						parameters["\\_TECHMAP_BITS_CONNMAP_"] = bits;
-
-					for (auto conn : cell->connections)
-						if (tpl->avail_parameters.count(stringf("\\_TECHMAP_CONNMAP_%s_", RTLIL::id2cstr(conn.first))) != 0) {
-							RTLIL::Const value;
-							for (auto &bit : sigmap(conn.second).to_sigbit_vector()) {
-								RTLIL::Const chunk(unique_bit_id.at(bit), bits);
-								value.bits.insert(value.bits.end(), chunk.bits.begin(), chunk.bits.end());
+						if (tpl->avail_parameters.count("\\_TECHMAP_CELLTYPE_") != 0)
+							parameters["\\_TECHMAP_CELLTYPE_"] = RTLIL::unescape_id(cell->type);
+
+						for (auto conn : cell->connections) {
+							if (tpl->avail_parameters.count(stringf("\\_TECHMAP_CONSTMSK_%s_", RTLIL::id2cstr(conn.first))) != 0) {
+								std::vector<RTLIL::SigBit> v = sigmap(conn.second).to_sigbit_vector();
+								for (auto &bit : v)
+									bit = RTLIL::SigBit(bit.wire == NULL ? RTLIL::State::S1 : RTLIL::State::S0);
+								parameters[stringf("\\_TECHMAP_CONSTMSK_%s_", RTLIL::id2cstr(conn.first))] = RTLIL::SigSpec(v).as_const();
+							}
+							if (tpl->avail_parameters.count(stringf("\\_TECHMAP_CONSTVAL_%s_", RTLIL::id2cstr(conn.first))) != 0) {
+								std::vector<RTLIL::SigBit> v = sigmap(conn.second).to_sigbit_vector();
+								for (auto &bit : v)
+									if (bit.wire != NULL)
+										bit = RTLIL::SigBit(RTLIL::State::Sx);
+								parameters[stringf("\\_TECHMAP_CONSTVAL_%s_", RTLIL::id2cstr(conn.first))] = RTLIL::SigSpec(v).as_const();
 							}
-							parameters[stringf("\\_TECHMAP_CONNMAP_%s_", RTLIL::id2cstr(conn.first))] = value;
 						}
-				}
 
-				std::pair<RTLIL::IdString, std::map<RTLIL::IdString, RTLIL::Const>> key(tpl_name, parameters);
-				if (techmap_cache.count(key) > 0) {
-					tpl = techmap_cache[key];
-				} else {
-					if (cell->parameters.size() != 0) {
-						derived_name = tpl->derive(map, parameters);
-						tpl = map->modules[derived_name];
-						log_continue = true;
-					}
-					techmap_cache[key] = tpl;
-				}
+						int unique_bit_id_counter = 0;
+						std::map<RTLIL::SigBit, int> unique_bit_id;
+						unique_bit_id[RTLIL::State::S0] = unique_bit_id_counter++;
+						unique_bit_id[RTLIL::State::S1] = unique_bit_id_counter++;
+						unique_bit_id[RTLIL::State::Sx] = unique_bit_id_counter++;
+						unique_bit_id[RTLIL::State::Sz] = unique_bit_id_counter++;
+
+						for (auto conn : cell->connections)
+							if (tpl->avail_parameters.count(stringf("\\_TECHMAP_CONNMAP_%s_", RTLIL::id2cstr(conn.first))) != 0) {
+								for (auto &bit : sigmap(conn.second).to_sigbit_vector())
+									if (unique_bit_id.count(bit) == 0)
+										unique_bit_id[bit] = unique_bit_id_counter++;
+							}
 
-				if (flatten_mode)
-					techmap_do_cache[tpl] = true;
+						int bits = 0;
+						for (int i = 0; i < 32; i++)
+							if (((unique_bit_id_counter-1) & (1 << i)) != 0)
+								bits = i;
+						if (tpl->avail_parameters.count("\\_TECHMAP_BITS_CONNMAP_"))
+							parameters["\\_TECHMAP_BITS_CONNMAP_"] = bits;
+
+						for (auto conn : cell->connections)
+							if (tpl->avail_parameters.count(stringf("\\_TECHMAP_CONNMAP_%s_", RTLIL::id2cstr(conn.first))) != 0) {
+								RTLIL::Const value;
+								for (auto &bit : sigmap(conn.second).to_sigbit_vector()) {
+									RTLIL::Const chunk(unique_bit_id.at(bit), bits);
+									value.bits.insert(value.bits.end(), chunk.bits.begin(), chunk.bits.end());
+								}
+								parameters[stringf("\\_TECHMAP_CONNMAP_%s_", RTLIL::id2cstr(conn.first))] = value;
+							}
+					}
 
-				if (techmap_do_cache.count(tpl) == 0)
-				{
-					bool keep_running = true;
-					techmap_do_cache[tpl] = true;
+					std::pair<RTLIL::IdString, std::map<RTLIL::IdString, RTLIL::Const>> key(tpl_name, parameters);
+					if (techmap_cache.count(key) > 0) {
+						tpl = techmap_cache[key];
+					} else {
+						if (cell->parameters.size() != 0) {
+							derived_name = tpl->derive(map, parameters);
+							tpl = map->modules[derived_name];
+							log_continue = true;
+						}
+						techmap_cache[key] = tpl;
+					}
 
-					std::set<std::string> techmap_wire_names;
+					if (flatten_mode)
+						techmap_do_cache[tpl] = true;
 
-					while (keep_running)
+					if (techmap_do_cache.count(tpl) == 0)
 					{
-						TechmapWires twd = techmap_find_special_wires(tpl);
-						keep_running = false;
+						bool keep_running = true;
+						techmap_do_cache[tpl] = true;
 
-						for (auto &it : twd)
-							techmap_wire_names.insert(it.first);
+						std::set<std::string> techmap_wire_names;
 
-						for (auto &it : twd["_TECHMAP_FAIL_"]) {
-							RTLIL::SigSpec value = it.value;
-							if (value.is_fully_const() && value.as_bool()) {
-								log("Not using module `%s' from techmap as it contains a %s marker wire with non-zero value %s.\n",
-										derived_name.c_str(), RTLIL::id2cstr(it.wire->name), log_signal(value));
-								techmap_do_cache[tpl] = false;
+						while (keep_running)
+						{
+							TechmapWires twd = techmap_find_special_wires(tpl);
+							keep_running = false;
+
+							for (auto &it : twd)
+								techmap_wire_names.insert(it.first);
+
+							for (auto &it : twd["_TECHMAP_FAIL_"]) {
+								RTLIL::SigSpec value = it.value;
+								if (value.is_fully_const() && value.as_bool()) {
+									log("Not using module `%s' from techmap as it contains a %s marker wire with non-zero value %s.\n",
+											derived_name.c_str(), RTLIL::id2cstr(it.wire->name), log_signal(value));
+									techmap_do_cache[tpl] = false;
+								}
 							}
-						}
 
-						if (!techmap_do_cache[tpl])
-							break;
+							if (!techmap_do_cache[tpl])
+								break;
 
-						for (auto &it : twd)
-						{
-							if (it.first.substr(0, 12) != "_TECHMAP_DO_" || it.second.empty())
-								continue;
+							for (auto &it : twd)
+							{
+								if (it.first.substr(0, 12) != "_TECHMAP_DO_" || it.second.empty())
+									continue;
+
+								auto &data = it.second.front();
+
+								if (!data.value.is_fully_const())
+									log_error("Techmap yielded config wire %s with non-const value %s.\n", RTLIL::id2cstr(data.wire->name), log_signal(data.value));
 
-							auto &data = it.second.front();
+								techmap_wire_names.erase(it.first);
+								tpl->wires.erase(data.wire->name);
 
-							if (!data.value.is_fully_const())
-								log_error("Techmap yielded config wire %s with non-const value %s.\n", RTLIL::id2cstr(data.wire->name), log_signal(data.value));
+								const char *p = data.wire->name.c_str();
+								const char *q = strrchr(p+1, '.');
+								q = q ? q : p+1;
 
+								assert(!strncmp(q, "_TECHMAP_DO_", 12));
+								std::string new_name = data.wire->name.substr(0, q-p) + "_TECHMAP_DONE_" + data.wire->name.substr(q-p+12);
+								while (tpl->wires.count(new_name))
+									new_name += "_";
+								data.wire->name = new_name;
+								tpl->add(data.wire);
+
+								std::string cmd_string = data.value.as_const().decode_string();
+
+								RTLIL::Selection tpl_mod_sel(false);
+								std::string backup_active_module = map->selected_active_module;
+								map->selected_active_module = tpl->name;
+								tpl_mod_sel.select(tpl);
+								map->selection_stack.push_back(tpl_mod_sel);
+								Pass::call(map, cmd_string);
+								map->selection_stack.pop_back();
+								map->selected_active_module = backup_active_module;
+
+								keep_running = true;
+								break;
+							}
+						}
+
+						TechmapWires twd = techmap_find_special_wires(tpl);
+						for (auto &it : twd) {
+							if (it.first != "_TECHMAP_FAIL_" && it.first.substr(0, 12) != "_TECHMAP_DO_" && it.first.substr(0, 14) != "_TECHMAP_DONE_")
+								log_error("Techmap yielded unknown config wire %s.\n", it.first.c_str());
+							if (techmap_do_cache[tpl])
+								for (auto &it2 : it.second)
+									if (!it2.value.is_fully_const())
+										log_error("Techmap yielded config wire %s with non-const value %s.\n", RTLIL::id2cstr(it2.wire->name), log_signal(it2.value));
 							techmap_wire_names.erase(it.first);
-							tpl->wires.erase(data.wire->name);
-
-							const char *p = data.wire->name.c_str();
-							const char *q = strrchr(p+1, '.');
-							q = q ? q : p+1;
-
-							assert(!strncmp(q, "_TECHMAP_DO_", 12));
-							std::string new_name = data.wire->name.substr(0, q-p) + "_TECHMAP_DONE_" + data.wire->name.substr(q-p+12);
-							while (tpl->wires.count(new_name))
-								new_name += "_";
-							data.wire->name = new_name;
-							tpl->add(data.wire);
-
-							std::string cmd_string = data.value.as_const().decode_string();
-
-							RTLIL::Selection tpl_mod_sel(false);
-							std::string backup_active_module = map->selected_active_module;
-							map->selected_active_module = tpl->name;
-							tpl_mod_sel.select(tpl);
-							map->selection_stack.push_back(tpl_mod_sel);
-							Pass::call(map, cmd_string);
-							map->selection_stack.pop_back();
-							map->selected_active_module = backup_active_module;
-
-							keep_running = true;
-							break;
 						}
+
+						for (auto &it : techmap_wire_names)
+							log_error("Techmap special wire %s disappeared. This is considered a fatal error.\n", RTLIL::id2cstr(it));
 					}
 
-					TechmapWires twd = techmap_find_special_wires(tpl);
-					for (auto &it : twd) {
-						if (it.first != "_TECHMAP_FAIL_" && it.first.substr(0, 12) != "_TECHMAP_DO_" && it.first.substr(0, 14) != "_TECHMAP_DONE_")
-							log_error("Techmap yielded unknown config wire %s.\n", it.first.c_str());
-						if (techmap_do_cache[tpl])
-							for (auto &it2 : it.second)
-								if (!it2.value.is_fully_const())
-									log_error("Techmap yielded config wire %s with non-const value %s.\n", RTLIL::id2cstr(it2.wire->name), log_signal(it2.value));
-						techmap_wire_names.erase(it.first);
+					if (techmap_do_cache.at(tpl) == false)
+						continue;
+
+					if (log_continue) {
+						log_header("Continuing TECHMAP pass.\n");
+						log_continue = false;
 					}
 
-					for (auto &it : techmap_wire_names)
-						log_error("Techmap special wire %s disappeared. This is considered a fatal error.\n", RTLIL::id2cstr(it));
+					if (num_threads > 0) {
+						TechmapJob job;
+						job.cell = cell;
+						job.tpl = tpl;
+						job.orig_cell_name = techmap_prepare_cell(module, cell, tpl, flatten_mode);
+						tpl_jobs.push_back(job);
+					} else {
+						new_cells.clear();
+						techmap_module_worker(design, module, cell, tpl, flatten_mode, new_cells);
+						for (auto c : new_cells)
+							if (celltypeMap.count(c->type) > 0)
+								next_worklist[c->type].push_back(c);
+					}
+					did_something = true;
+					cell = NULL;
+					break;
 				}
 
-				if (techmap_do_cache.at(tpl) == false)
-					continue;
+				handled_cells.insert(cell);
+			}
 
-				if (log_continue) {
-					log_header("Continuing TECHMAP pass.\n");
-					log_continue = false;
-				}
+			if (!tpl_jobs.empty() || !simplemap_jobs.empty()) {
+				new_cells.clear();
+				techmap_run_parallel(design, module, tpl_jobs, simplemap_jobs, flatten_mode, num_threads, new_cells);
+				for (auto c : new_cells)
+					if (celltypeMap.count(c->type) > 0)
+						next_worklist[c->type].push_back(c);
+			}
 
-				techmap_module_worker(design, module, cell, tpl, flatten_mode);
-				did_something = true;
-				cell = NULL;
-				break;
+			worklist.clear();
+			worklist.swap(next_worklist);
+
+			if (did_simplemap && rescan_after_simplemap) {
+				worklist.clear();
+				for (auto &cell_it : module->cells)
+					if (celltypeMap.count(cell_it.second->type) > 0 && handled_cells.count(cell_it.second) == 0)
+						worklist[cell_it.second->type].push_back(cell_it.second);
 			}
 
-			handled_cells.insert(cell);
+			if (max_iter > 0 && iter >= max_iter)
+				break;
 		}
 
 		if (log_continue) {
@@ -442,6 +560,67 @@ struct TechmapWorker
 	}
 };
 
+// A parsed map library together with the templates derived from it and the
+// results of the _TECHMAP_DO_ commands that have been run on them. Libraries
+// are kept for the lifetime of the process and reused by later techmap calls
+// with the same map file contents and frontend options.
+struct TechmapLibrary
+{
+	RTLIL::Design *map;
+	std::map<RTLIL::IdString, std::set<RTLIL::IdString>> celltypeMap;
+	TechmapWorker worker;
+
+	TechmapLibrary() : map(new RTLIL::Design) { }
+	~TechmapLibrary() { delete map; }
+};
+
+static std::map<std::string, TechmapLibrary*> techmap_library_cache;
+
+static std::string techmap_hash(const std::string &data)
+{
+	unsigned char hash[20];
+	char hash_hex_string[41];
+	sha1::calc(data.c_str(), data.size(), hash);
+	sha1::toHexString(hash, hash_hex_string);
+	return hash_hex_string;
+}
+
+static TechmapLibrary *techmap_load_library(const std::vector<std::pair<std::string, std::string>> &sources, std::string verilog_frontend)
+{
+	TechmapLibrary *lib = new TechmapLibrary;
+	simplemap_get_mappers(lib->worker.simplemap_mappers);
+
+	RTLIL::Design *map = lib->map;
+	for (auto &src : sources) {
+		const std::string &fn = src.first;
+		FILE *f = fmemopen((void*)src.second.data(), src.second.size(), "rt");
+		if (f == NULL)
+			log_cmd_error("Opening memory stream for map file `%s' failed: %s\n", fn.c_str(), strerror(errno));
+		Frontend::frontend_call(map, f, fn, (fn.size() > 3 && fn.substr(fn.size()-3) == ".il") ? "ilang" : verilog_frontend);
+		fclose(f);
+	}
+
+	std::map<RTLIL::IdString, RTLIL::Module*> modules_new;
+	for (auto &it : map->modules) {
+		if (it.first.substr(0, 2) == "\\$")
+			it.second->name = it.first.substr(1);
+		modules_new[it.second->name] = it.second;
+	}
+	map->modules.swap(modules_new);
+
+	for (auto &it : map->modules) {
+		if (it.second->attributes.count("\\techmap_celltype") && !it.second->attributes.at("\\techmap_celltype").bits.empty()) {
+			char *p = strdup(it.second->attributes.at("\\techmap_celltype").decode_string().c_str());
+			for (char *q = strtok(p, " \t\r\n"); q; q = strtok(NULL, " \t\r\n"))
+				lib->celltypeMap[RTLIL::escape_id(q)].insert(it.first);
+			free(p);
+		} else
+			lib->celltypeMap[it.first].insert(it.first);
+	}
+
+	return lib;
+}
+
 struct TechmapPass : public Pass {
 	TechmapPass() : Pass("techmap", "generic technology mapper") { }
 	virtual void help()
@@ -466,13 +645,27 @@ struct TechmapPass : public Pass {
 		log("        is called from other commands.\n");
 		log("\n");
 		log("    -max_iter <number>\n");
-		log("        only run the specified number of iterations.\n");
+		log("        only run the specified number of iterations (each iteration maps the\n");
+		log("        cells created by the previous one).\n");
 		log("\n");
 		log("    -D <define>, -I <incdir>\n");
 		log("        this options are passed as-is to the verilog frontend for loading the\n");
 		log("        map file. Note that the verilog frontend is also called with the\n");
 		log("        '-ignore_redef' option set.\n");
 		log("\n");
+		log("    -j <num>\n");
+		log("        expand the cells on up to <num> threads. the templates for all cells\n");
+		log("        that can be mapped in an iteration are selected first, then the cells\n");
+		log("        are expanded in parallel. the result does not depend on the number\n");
+		log("        of threads.\n");
+		log("\n");
+		log("    -nocache\n");
+		log("        do not reuse (and do not keep) the parsed map library. by default the\n");
+		log("        map files are parsed once per yosys process: later techmap calls with\n");
+		log("        map files of the same content and the same -D/-I options reuse the\n");
+		log("        parsed modules and the templates derived from them. (files included\n");
+		log("        by the map files are not part of this comparison.)\n");
+		log("\n");
 		log("When a module in the map file has the 'techmap_celltype' attribute set, it will\n");
 		log("match cells with a type that match the text value of this attribute. Otherwise\n");
 		log("the module name will be used to match the cell.\n");
@@ -546,7 +739,8 @@ struct TechmapPass : public Pass {
 
 		std::vector<std::string> map_files;
 		std::string verilog_frontend = "verilog -ignore_redef";
-		int max_iter = -1;
+		int max_iter = -1, num_threads = 0;
+		bool nocache = false;
 
 		size_t argidx;
 		std::string proc_share_path = proc_share_dirname();
@@ -563,6 +757,16 @@ struct TechmapPass : public Pass {
 				max_iter = atoi(args[++argidx].c_str());
 				continue;
 			}
+			if (args[argidx] == "-nocache") {
+				nocache = true;
+				continue;
+			}
+			if (args[argidx] == "-j" && argidx+1 < args.size()) {
+				num_threads = atoi(args[++argidx].c_str());
+				if (num_threads < 1)
+					log_cmd_error("Invalid number of threads %d.\n", num_threads);
+				continue;
+			}
 			if (args[argidx] == "-D" && argidx+1 < args.size()) {
 				verilog_frontend += " -D " + args[++argidx];
 				continue;
@@ -575,57 +779,49 @@ struct TechmapPass : public Pass {
 		}
 		extra_args(args, argidx, design);
 
-		TechmapWorker worker;
-		simplemap_get_mappers(worker.simplemap_mappers);
-
-		RTLIL::Design *map = new RTLIL::Design;
+		// the map files are read and hashed here, so the cache key covers their contents
+		std::vector<std::pair<std::string, std::string>> sources;
 		if (map_files.empty()) {
-			FILE *f = fmemopen(stdcells_code, strlen(stdcells_code), "rt");
-			Frontend::frontend_call(map, f, "<stdcells.v>", verilog_frontend);
-			fclose(f);
+			sources.push_back(std::pair<std::string, std::string>("<stdcells.v>", stdcells_code));
 		} else
 			for (auto &fn : map_files) {
 				FILE *f = fopen(fn.c_str(), "rt");
 				if (f == NULL)
 					log_cmd_error("Can't open map file `%s'\n", fn.c_str());
-				Frontend::frontend_call(map, f, fn, (fn.size() > 3 && fn.substr(fn.size()-3) == ".il") ? "ilang" : verilog_frontend);
+				std::string contents;
+				char buffer[4096];
+				size_t n;
+				while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0)
+					contents.append(buffer, n);
 				fclose(f);
+				sources.push_back(std::pair<std::string, std::string>(fn, contents));
 			}
 
-		std::map<RTLIL::IdString, RTLIL::Module*> modules_new;
-		for (auto &it : map->modules) {
-			if (it.first.substr(0, 2) == "\\$")
-				it.second->name = it.first.substr(1);
-			modules_new[it.second->name] = it.second;
-		}
-		map->modules.swap(modules_new);
-
-		std::map<RTLIL::IdString, std::set<RTLIL::IdString>> celltypeMap;
-		for (auto &it : map->modules) {
-			if (it.second->attributes.count("\\techmap_celltype") && !it.second->attributes.at("\\techmap_celltype").bits.empty()) {
-				char *p = strdup(it.second->attributes.at("\\techmap_celltype").decode_string().c_str());
-				for (char *q = strtok(p, " \t\r\n"); q; q = strtok(NULL, " \t\r\n"))
-					celltypeMap[RTLIL::escape_id(q)].insert(it.first);
-				free(p);
-			} else
-				celltypeMap[it.first].insert(it.first);
+		std::string cache_key = verilog_frontend;
+		for (auto &src : sources)
+			cache_key += stringf("\n%s %s", src.first.c_str(), techmap_hash(src.second).c_str());
+
+		TechmapLibrary *lib = NULL;
+		if (!nocache && techmap_library_cache.count(cache_key) > 0) {
+			lib = techmap_library_cache.at(cache_key);
+			log("Using cached map library with %d modules.\n", int(lib->map->modules.size()));
+		} else {
+			lib = techmap_load_library(sources, verilog_frontend);
+			if (!nocache)
+				techmap_library_cache[cache_key] = lib;
 		}
 
-		bool did_something = true;
+		bool did_something = false;
 		std::set<RTLIL::Cell*> handled_cells;
-		while (did_something) {
-			did_something = false;
-			for (auto &mod_it : design->modules)
-				if (worker.techmap_module(design, mod_it.second, map, handled_cells, celltypeMap, false))
-					did_something = true;
-			if (did_something)
-				design->check();
-			if (max_iter > 0 && --max_iter == 0)
-				break;
-		}
+		for (auto &mod_it : design->modules)
+			if (lib->worker.techmap_module(design, mod_it.second, lib->map, handled_cells, lib->celltypeMap, false, max_iter, num_threads))
+				did_something = true;
+		if (did_something)
+			design->check();
 
 		log("No more expansions possible.\n");
-		delete map;
+		if (nocache)
+			delete lib;
 
 		log_pop();
 	}
@@ -663,18 +859,12 @@ struct FlattenPass : public Pass {
 				if (mod_it.second->get_bool_attribute("\\top"))
 					top_mod = mod_it.second;
 
-		bool did_something = true;
 		std::set<RTLIL::Cell*> handled_cells;
-		while (did_something) {
-			did_something = false;
-			if (top_mod != NULL) {
-				if (worker.techmap_module(design, top_mod, design, handled_cells, celltypeMap, true))
-					did_something = true;
-			} else {
-				for (auto &mod_it : design->modules)
-					if (worker.techmap_module(design, mod_it.second, design, handled_cells, celltypeMap, true))
-						did_something = true;
-			}
+		if (top_mod != NULL) {
+			worker.techmap_module(design, top_mod, design, handled_cells, celltypeMap, true);
+		} else {
+			for (auto &mod_it : design->modules)
+				worker.techmap_module(design, mod_it.second, design, handled_cells, celltypeMap, true);
 		}
 
 		log("No more expansions possible.\n");
@@ -54,6 +54,10 @@ struct SynthXilinxPass : public Pass {
 		log("        write the design to the specified edif file. writing of an output file\n");
 		log("        is omitted if this parameter is not specified.\n");
 		log("\n");
+		log("    -lutmap\n");
+		log("        use the built-in 'aigopt' and 'lutmap' passes instead of ABC for\n");
+		log("        mapping the logic to LUTs. this does not need the external ABC tool.\n");
+		log("\n");
 		log("    -run <from_label>:<to_label>\n");
 		log("        only run the commands between the labels (see below). an empty\n");
 		log("        from label is synonymous to 'begin', and empty to label is\n");
@@ -78,7 +82,8 @@ struct SynthXilinxPass : public Pass {
 		log("        opt\n");
 		log("\n");
 		log("    map_luts:\n");
-		log("        abc -lut 6\n");
+		log("        abc -lut 6                  (without -lutmap)\n");
+		log("        aigopt; lutmap -k 6         (with -lutmap)\n");
 		log("        clean\n");
 		log("\n");
 		log("    map_cells:\n");
@@ -103,6 +108,7 @@ struct SynthXilinxPass : public Pass {
 		std::string arch_name = "spartan6";
 		std::string edif_file;
 		std::string run_from, run_to;
+		bool use_lutmap = false;
 
 		size_t argidx;
 		for (argidx = 1; argidx < args.size(); argidx++)
@@ -119,6 +125,10 @@ struct SynthXilinxPass : public Pass {
 				edif_file = args[++argidx];
 				continue;
 			}
+			if (args[argidx] == "-lutmap") {
+				use_lutmap = true;
+				continue;
+			}
 			if (args[argidx] == "-run" && argidx+1 < args.size()) {
 				size_t pos = args[argidx+1].find(':');
 				if (pos == std::string::npos)
@@ -176,7 +186,11 @@ struct SynthXilinxPass : public Pass {
 
 		if (check_label(active, run_from, run_to, "map_luts"))
 		{
-			Pass::call(design, "abc -lut 6");
+			if (use_lutmap) {
+				Pass::call(design, "aigopt");
+				Pass::call(design, "lutmap -k 6");
+			} else
+				Pass::call(design, "abc -lut 6");
 			Pass::call(design, "clean");
 		}
 
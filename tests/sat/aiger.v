@@ -0,0 +1,7 @@
+module test(input clk, input [3:0] a, b, output reg q, output reg [3:0] p, output [3:0] y);
+always @(posedge clk) begin
+	q <= a[0] ^ b[1];
+	p <= a + b;
+end
+assign y = q ? p : a & ~b;
+endmodule
@@ -0,0 +1,5 @@
+module seq(input clk, input [3:0] a, b, output reg [3:0] q, output [3:0] y);
+always @(posedge clk)
+	q <= q + (a & b);
+assign y = q ^ a;
+endmodule
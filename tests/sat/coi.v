@@ -0,0 +1,46 @@
+module coi_comb(a, b, c, x, y, z, s1, s2, v, w);
+	input [7:0] a, b, c;
+	output [7:0] x, y, z, s1, s2;
+	output v, w;
+
+	// x and y are structurally identical, z is not
+	assign x = (a & b) + c;
+	assign y = (b & a) + c;
+	assign z = (a | b) + c;
+
+	// same connections, different parameters
+	assign s1 = a[3:0] * b[3:0];
+	assign s2 = $signed(a[3:0]) * $signed(b[3:0]);
+
+	// only related through a constraint on w
+	assign v = (a ^ b) == 8'd0;
+	assign w = a == b;
+endmodule
+
+module coi_seq(clk, a, r1, r2, junk);
+	input clk;
+	input [7:0] a;
+	output reg [7:0] r1 = 0, r2 = 0;
+	output reg [7:0] junk = 0;
+
+	always @(posedge clk) begin
+		r1 <= r1 + a;
+		r2 <= a + r2;
+		junk <= junk * 3 + a;
+		assert(r1 == r2);
+	end
+endmodule
+
+module coi_seq_bad(clk, a, r1, r2, junk);
+	input clk;
+	input [7:0] a;
+	output reg [7:0] r1 = 0, r2 = 0;
+	output reg [7:0] junk = 0;
+
+	always @(posedge clk) begin
+		r1 <= r1 + a;
+		r2 <= a + r2 + (a == 8'd77);
+		junk <= junk * 3 + a;
+		assert(r1 == r2);
+	end
+endmodule
@@ -0,0 +1,14 @@
+module gold(input [4:0] a, b, c, input [31:0] p, q, r, output [4:0] y, output [31:0] z);
+assign y = (a + b) * c;
+assign z = (p + q) + (r ^ q);
+endmodule
+
+module gate(input [4:0] a, b, c, input [31:0] p, q, r, output [4:0] y, output [31:0] z);
+assign y = a * c + b * c;
+assign z = p + (q + (r ^ q));
+endmodule
+
+module bad(input [4:0] a, b, c, input [31:0] p, q, r, output [4:0] y, output [31:0] z);
+assign y = a * c + b * c;
+assign z = p + (q + (r ^ q)) + (p == 32'hdeadbeef);
+endmodule
@@ -0,0 +1,18 @@
+module test(a, b, c, d, y1, y2, q1, q2, z1, z2);
+	input [31:0] a, b;
+	input [3:0] c, d;
+	output [31:0] y1, y2;
+	output q1, q2;
+	output [3:0] z1, z2;
+
+	assign y1 = a & b;
+	assign y2 = ~(~a | ~b);
+
+	// q1 and q2 depend on the same inputs but differ only
+	// for one in 2^32 values of a
+	assign q1 = a != 32'd0;
+	assign q2 = (a != 32'd0) && (a != 32'hdeadbeef);
+
+	assign z1 = c + d;
+	assign z2 = ~(~c - d);
+endmodule
@@ -0,0 +1,6 @@
+module test(input [3:0] a, b, input s, output [3:0] y, z, output [7:0] p, output eq);
+assign y = s ? a + b : a - b;
+assign z = (a & b) | (a & ~b);
+assign p = a * b;
+assign eq = (a + b) == (b + a);
+endmodule
@@ -0,0 +1,10 @@
+// n1 is used in negative polarity by an output and in positive polarity by
+// another LUT, n2 is used in both polarities by outputs.
+module polarity(input [5:0] a, b, input c, output y1, z1, y2, z2, w2);
+wire n1 = &a, n2 = &b;
+assign y1 = ~n1;
+assign z1 = n1 ^ c;
+assign y2 = ~n2;
+assign z2 = n2 ^ c;
+assign w2 = n2;
+endmodule
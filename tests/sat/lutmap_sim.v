@@ -0,0 +1,9 @@
+// map $lut cells to logic that the sat pass can import
+module \$lut (I, O);
+parameter WIDTH = 0;
+parameter LUT = 0;
+input [WIDTH-1:0] I;
+output O;
+wire [2**WIDTH-1:0] table = LUT;
+assign O = table[I];
+endmodule
@@ -0,0 +1,14 @@
+module gold(input [3:0] a, b, c, output [3:0] x, y);
+assign x = (a + b) ^ c;
+assign y = (a & b) | c;
+endmodule
+
+module gate(input [3:0] a, b, c, output [3:0] x, y);
+assign x = (a + b) ^ c;
+assign y = (b & a) | c;
+endmodule
+
+module bad(input [3:0] a, b, c, output [3:0] x, y);
+assign x = (a + b) ^ c;
+assign y = (a & b) & c;
+endmodule
@@ -0,0 +1,39 @@
+module ident(a, b, p, q, r, s, ok1, ok2, ok3, ok4, ok5);
+	input [7:0] a, b;
+	input [31:0] p, q, r;
+	input s;
+	output ok1, ok2, ok3, ok4, ok5;
+
+	assign ok1 = a * b == b * a;
+	assign ok2 = b == 0 || (a / b) * b + a % b == a;
+	assign ok3 = ^{p, q} == (^p ^ ^q);
+	assign ok4 = (p + q) + r == p + (q + r);
+	assign ok5 = (s ? p : q) == ((p & {32{s}}) | (q & ~{32{s}}));
+endmodule
+
+module nonident(a, b, p, q, r, bad1, bad2, bad3, bad4);
+	input [7:0] a, b;
+	input [31:0] p, q, r;
+	output bad1, bad2, bad3, bad4;
+
+	assign bad1 = a * b == b * a + (a == 8'd201 && b == 8'd77);
+	assign bad2 = b == 0 || (a / b) * b + a % b == a + (a == 8'd200 && b == 8'd7);
+	assign bad3 = ^{p, q} == (^p ^ ^q ^ (p == 32'hcafe0000));
+	assign bad4 = (p + q) + r == p + (q | r);
+endmodule
+
+module arith(a, b, p, q, r, s, y1, y2, y3, y4, y5, y6);
+	input [5:0] a, b;
+	input [31:0] p, q, r;
+	input s;
+	output [5:0] y1, y2, y3;
+	output y4;
+	output [31:0] y5, y6;
+
+	assign y1 = a * b;
+	assign y2 = a / b;
+	assign y3 = a % b;
+	assign y4 = ^{p, q};
+	assign y5 = s ? p : q;
+	assign y6 = p + q - r;
+endmodule
@@ -0,0 +1,6 @@
+module test(input [3:0] a, b, output [3:0] y, z);
+assign y = a & b;
+assign z = a | b;
+assert property ((y & z) == y);
+assert property ((y | z) == z);
+endmodule
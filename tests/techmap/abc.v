@@ -0,0 +1,43 @@
+module abc_add(a, b, c, y, gt);
+	input [15:0] a, b, c;
+	output [15:0] y;
+	output gt;
+
+	assign y = a + b - c;
+	assign gt = a > c;
+endmodule
+
+module abc_alu(op, a, b, y);
+	input [1:0] op;
+	input [7:0] a, b;
+	output reg [7:0] y;
+
+	always @* begin
+		case (op)
+			0: y = a & b;
+			1: y = a | ~b;
+			2: y = a ^ (b << 1);
+			3: y = a - b;
+		endcase
+	end
+endmodule
+
+module abc_seq(clk, rst, in, count, crc, y);
+	input clk, rst;
+	input [7:0] in;
+	output reg [7:0] count = 0;
+	output reg [15:0] crc = 0;
+	output [7:0] y;
+
+	always @(posedge clk) begin
+		if (rst) begin
+			count <= 0;
+			crc <= 0;
+		end else begin
+			count <= count + in;
+			crc <= {crc[14:0], 1'b0} ^ (crc[15] ? 16'h1021 : 16'h0) ^ {in, count};
+		end
+	end
+
+	assign y = count ^ crc[15:8] ^ crc[7:0];
+endmodule
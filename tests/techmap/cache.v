@@ -0,0 +1,24 @@
+module test(input [3:0] a, b, output [3:0] y);
+assign y = a & b;
+endmodule
+
+// alternative implementations of $_AND_, the test script writes one of them
+// at a time to cache_map.v (renamed to $_AND_) and maps with that file
+
+module map_or(A, B, Y);
+input A, B;
+output Y;
+assign Y = ~(~A | ~B);
+endmodule
+
+module map_mul(A, B, Y);
+input A, B;
+output Y;
+assign Y = A * B;
+endmodule
+
+module map_xor(A, B, Y);
+input A, B;
+output Y;
+assign Y = (A ^ B) ^ (A | B);
+endmodule
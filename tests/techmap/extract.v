@@ -0,0 +1,23 @@
+module test1(a, b, c, d, e, f, x, y, z);
+	input [7:0] a, b, c, d, e, f;
+	output [7:0] x, y, z;
+
+	assign x = a * b + c;
+	assign y = (d * e + f) ^ a;
+	assign z = a * b - c;
+endmodule
+
+module test2(a, b, c, d, x, y);
+	input [7:0] a, b, c, d;
+	output [7:0] x, y;
+
+	assign x = (a * b + c) * d + a;
+	assign y = (c + d) & (a * d + b);
+endmodule
+
+module test3(a, b, c, x);
+	input [7:0] a, b, c;
+	output [7:0] x;
+
+	assign x = c + a * b;
+endmodule
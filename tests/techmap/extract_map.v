@@ -0,0 +1,6 @@
+module macc(a, b, c, y);
+	input [7:0] a, b, c;
+	output [7:0] y;
+
+	assign y = a * b + c;
+endmodule
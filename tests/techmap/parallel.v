@@ -0,0 +1,6 @@
+module test(input [63:0] a, b, c, input s, output [63:0] x, y, z, output [7:0] p);
+assign x = (a & b) | c;
+assign y = s ? a + b : a - c;
+assign z = (a ^ c) & ~b;
+assign p = a[7:0] * b[7:0];
+endmodule
@@ -0,0 +1,6 @@
+module test(input [12:0] a, input [5:0] b, input [2:0] c, output x, y, z, w);
+assign x = ^a;
+assign y = ^b;
+assign z = ^c;
+assign w = ^c[1:0];
+endmodule
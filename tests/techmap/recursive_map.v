@@ -0,0 +1,60 @@
+// wide $reduce_xor cells are split in two halves, which are mapped again by
+// the same template (or by the next one for width 2). cells with 3 inputs
+// are not mapped by any template and stay $reduce_xor cells.
+
+(* techmap_celltype = "$reduce_xor" *)
+module reduce_xor_a_split (A, Y);
+
+parameter A_SIGNED = 0;
+parameter A_WIDTH = 1;
+parameter Y_WIDTH = 1;
+
+input [A_WIDTH-1:0] A;
+output [Y_WIDTH-1:0] Y;
+
+wire _TECHMAP_FAIL_ = A_WIDTH < 4;
+
+localparam H = A_WIDTH / 2;
+wire lo, hi;
+
+\$reduce_xor #(.A_SIGNED(0), .A_WIDTH(H), .Y_WIDTH(1)) lo_xor (.A(A[H-1:0]), .Y(lo));
+\$reduce_xor #(.A_SIGNED(0), .A_WIDTH(A_WIDTH-H), .Y_WIDTH(1)) hi_xor (.A(A[A_WIDTH-1:H]), .Y(hi));
+
+assign Y = lo ^ hi;
+
+endmodule
+
+(* techmap_celltype = "$reduce_xor" *)
+module reduce_xor_b_pair (A, Y);
+
+parameter A_SIGNED = 0;
+parameter A_WIDTH = 1;
+parameter Y_WIDTH = 1;
+
+input [A_WIDTH-1:0] A;
+output [Y_WIDTH-1:0] Y;
+
+wire _TECHMAP_FAIL_ = A_WIDTH != 2;
+
+\$_XOR_ g (.A(A[0]), .B(A[A_WIDTH-1]), .Y(Y));
+
+endmodule
+
+// the $_XOR_ gates created by simplemap are mapped again
+
+(* techmap_simplemap *)
+module \$xor ;
+endmodule
+
+module \$_XOR_ (A, B, Y);
+
+input A, B;
+output Y;
+wire t1, t2, t3;
+
+\$_OR_ g1 (.A(A), .B(B), .Y(t1));
+\$_AND_ g2 (.A(A), .B(B), .Y(t2));
+\$_INV_ g3 (.A(t2), .Y(t3));
+\$_AND_ g4 (.A(t1), .B(t3), .Y(Y));
+
+endmodule
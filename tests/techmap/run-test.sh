@@ -8,3 +8,7 @@ for x in *_runtest.sh; do
 		exit 1
 	fi
 done
+for x in *.ys; do
+	echo "Running $x.."
+	../../yosys -ql ${x%.ys}.log $x
+done